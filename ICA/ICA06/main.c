@@ -7,10 +7,10 @@ File    : main.c - ICA06
 Author  : Jou Jon Galenzoga
 */
 
-#include <stdio.h>
 #include "stm32g031xx.h"
 #include "gpio.h"
 #include "usart.h"
+#include "fmt.h"
 
 // ================================================================
 // SELECT WHICH PART TO RUN
@@ -111,8 +111,9 @@ int main(void)
 
     for (int col = 1; col <= 16; col++)
     {
-        sprintf(text, "%03d ", col);
+        Fmt_U32(text, (uint32_t)col, 3, '0');           // "%03d"
         _USART_TxString(USART2, text);
+        _USART_TxByte(USART2, ' ');
     }
 
     _USART_TxString(USART2, "\r\n");
@@ -123,14 +124,16 @@ int main(void)
     for (int row = 1; row <= 16; row++)
     {
         // Row label
-        sprintf(text, "%03d ", row);
+        Fmt_U32(text, (uint32_t)row, 3, '0');
         _USART_TxString(USART2, text);
+        _USART_TxByte(USART2, ' ');
 
         // Row products
         for (int col = 1; col <= 16; col++)
         {
-            sprintf(text, "%03d ", row * col);
+            Fmt_U32(text, (uint32_t)(row * col), 3, '0');
             _USART_TxString(USART2, text);
+            _USART_TxByte(USART2, ' ');
         }
 
         _USART_TxString(USART2, "\r\n");
@@ -162,7 +165,7 @@ int main(void)
     int num1 = 0;
     int num2 = 0;
     uint32_t product = 0;
-    char out[64];
+    char out[_FMT_DEC32_SIZE];
 
     // --------------------- Prompt for first number ---------------------
     _USART_TxString(USART2, "Enter first 4-digit number: ");  
@@ -187,11 +190,18 @@ int main(void)
     product = (uint32_t)num1 * (uint32_t)num2;
 
     // --------------------- Output decimal result ------------------------
-    sprintf(out, "You entered: %d and %d\r\n", num1, num2);
+    _USART_TxString(USART2, "You entered: ");
+    Fmt_I32(out, num1, 0, ' ');
+    _USART_TxString(USART2, out);
+    _USART_TxString(USART2, " and ");
+    Fmt_I32(out, num2, 0, ' ');
     _USART_TxString(USART2, out);
+    _USART_TxString(USART2, "\r\n");
 
-    sprintf(out, "Product (decimal): %lu\r\n", product);
+    _USART_TxString(USART2, "Product (decimal): ");
+    Fmt_U32(out, product, 0, ' ');
     _USART_TxString(USART2, out);
+    _USART_TxString(USART2, "\r\n");
 
     // --------------------- Output 32-bit binary -------------------------
     _USART_TxString(USART2, "Product (binary 32-bit): ");
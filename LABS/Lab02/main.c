@@ -37,6 +37,7 @@
  *   C ............. 1 kHz
  *   D ............. 5 kHz
  *   E ............. 10 kHz
+ *   F ............. Type any frequency (1 Hz .. 8 MHz, e.g. 440.5), Enter
  * 
  ******************************************************************************/
 
@@ -45,7 +46,8 @@
 #include "gpio.h"
 #include "Timer.h"
 #include "usart.h"
-#include <stdio.h>
+#include "fmt.h"
+#include <string.h>
 
 /*=============================================================================
  * CONFIGURATION SECTION
@@ -87,32 +89,32 @@
 #endif
 
 /*=============================================================================
- * FREQUENCY TABLE
- * Defines the 5 selectable frequencies for PWM generation
+ * FREQUENCY PRESETS
+ * Keys A-E jump to these frequencies, F lets you type any frequency.
  * 
- * Formula: PWM_freq = SYSCLK / (PSC × ARR)
+ * PSC/ARR are no longer hard-coded for 32MHz: Timer_SetFrequency searches
+ * them for the current SYSCLK and picks the largest ARR (finest duty steps)
+ * that lands within PWM_MAX_ERROR_PPM of the target.
  * 
- * Each entry contains:
- *   - key: Keyboard letter to select this frequency
- *   - freq_hz: Actual frequency in Hz
- *   - prescaler: Timer prescaler value (PSC register gets prescaler-1)
- *   - period: Timer period value (ARR register gets period-1)
+ * Formula: PWM_freq = SYSCLK / (PSC × ARR)
  *===========================================================================*/
 
+#define PWM_MAX_ERROR_PPM   1000               // 0.1% frequency error allowed
+#define UPTIME_MAX_ERROR_PPM 50                // 1 Hz clock: 4 s a day at most
+#define PWM_MIN_MHZ         1000ULL            // 1 Hz (frequencies are in mHz)
+#define PWM_MAX_MHZ         8000000000ULL      // 8 MHz (3-bit duty at 64MHz)
+
 typedef struct {
     char key;              // Keyboard key (A-E)
-    uint16_t freq_hz;      // Frequency in Hz
-    uint16_t prescaler;    // Prescaler value (actual PSC = prescaler - 1)
-    uint16_t period;       // Period value (actual ARR = period - 1)
-} FrequencyConfig;
-
-const FrequencyConfig FREQ_TABLE[] = {
-    // Key, Freq,  PSC,  ARR     Formula verification:
-    {'A', 100,    320,  1000},  // 32MHz / (320 × 1000) = 100 Hz
-    {'B', 500,    64,   1000},  // 32MHz / (64 × 1000)  = 500 Hz
-    {'C', 1000,   32,   1000},  // 32MHz / (32 × 1000)  = 1 kHz
-    {'D', 5000,   64,   100},   // 32MHz / (64 × 100)   = 5 kHz
-    {'E', 10000,  32,   100}    // 32MHz / (32 × 100)   = 10 kHz
+    uint32_t freq_hz;      // Frequency in Hz
+} FrequencyPreset;
+
+const FrequencyPreset FREQ_PRESETS[] = {
+    {'A', 100},
+    {'B', 500},
+    {'C', 1000},
+    {'D', 5000},
+    {'E', 10000}
 };
 
 #define NUM_FREQUENCIES     5
@@ -123,15 +125,19 @@ const FrequencyConfig FREQ_TABLE[] = {
  *===========================================================================*/
 
 typedef struct {
-    uint8_t freq_index;         // Current frequency index (0-4)
+    uint64_t freq_mHz;          // Requested frequency in mHz
+    Timer_PWMSolution pwm;      // PSC/ARR in use, achieved frequency, duty bits
     uint8_t duty_percent;       // Current duty cycle (0-100%)
     uint8_t pwm_enabled;        // PWM state: 0=off, 1=on
     uint32_t uptime_seconds;    // Seconds since startup
+    uint8_t uptime_ok;          // TIM16 found a 1 Hz PSC/ARR
+    char entry[12];             // Frequency being typed after F ("" = not typing)
+    uint8_t entry_active;       // 1 while typing a frequency
 } AppState;
 
 // Initialize with default values
 AppState g_state = {
-    .freq_index = 0,            // Start at 100 Hz (index 0 = 'A')
+    .freq_mHz = 0,              // Set by PWM_Configure in System_Init
     .duty_percent = 50,         // Start at 50% duty cycle
     .pwm_enabled = 0,           // Start with PWM disabled
     .uptime_seconds = 0         // Clock starts at 00:00:00
@@ -145,7 +151,7 @@ AppState g_state = {
 void System_Init(void);
 
 // PWM control functions
-void PWM_Configure(uint8_t freq_index);
+uint8_t PWM_Configure(uint64_t freq_mHz);
 void PWM_UpdateDuty(uint8_t percent);
 void PWM_Toggle(void);
 
@@ -154,10 +160,12 @@ void UI_DrawHeader(void);
 void UI_DrawStatus(void);
 void UI_DrawControls(void);
 void UI_Refresh(void);
+void UI_DrawEntry(const char *message);
 
 // Utility functions
 void Uptime_Update(void);
 void Process_KeyPress(char key);
+void Process_FreqEntry(char key);
 
 #ifdef ENABLE_BUTTONS
 void Process_Buttons(void);
@@ -291,16 +299,19 @@ void System_Init(void)
     // │ Enable clock, configure with default frequency (100Hz)             │
     // └─────────────────────────────────────────────────────────────────────┘
     RCC->APBENR2 |= RCC_APBENR2_TIM14EN;
-    PWM_Configure(0);  // Start with frequency index 0 (100 Hz)
+    PWM_Configure(FREQ_PRESETS[0].freq_hz * 1000ULL);  // Start at preset A (100 Hz)
     
     // ┌─────────────────────────────────────────────────────────────────────┐
     // │ STEP 8: Initialize TIM16 for 1-Second Uptime Clock                 │
-    // │ Prescaler: 32000 → 32MHz / 32000 = 1kHz timer clock                │
-    // │ Period: 1000 → 1kHz / 1000 = 1Hz = 1 second per update             │
+    // │ 1 Hz with zero error first: the solver finds an exact PSC/ARR      │
+    // │ pair for most SYSCLKs (32MHz → PSC 500, ARR 64000); otherwise the  │
+    // │ closest within UPTIME_MAX_ERROR_PPM, or no clock at all            │
     // └─────────────────────────────────────────────────────────────────────┘
     RCC->APBENR2 |= RCC_APBENR2_TIM16EN;
-    Timer_Init(TIM16, 32000, 1000);  // 1 second intervals at 32MHz
-    Timer_Start(TIM16);
+    g_state.uptime_ok = Timer_SetFrequency(TIM16, 1000, 0, 0) ||              // 1 Hz = 1000 mHz
+                        Timer_SetFrequency(TIM16, 1000, UPTIME_MAX_ERROR_PPM, 0);
+    if (g_state.uptime_ok)
+        Timer_Start(TIM16);
 }
 
 /*=============================================================================
@@ -310,7 +321,8 @@ void System_Init(void)
  * 
  * HOW IT WORKS:
  *   1. Stop the timer (to safely reconfigure)
- *   2. Set prescaler (PSC) and period (ARR) from frequency table
+ *   2. Let the solver pick prescaler (PSC) and period (ARR) for the
+ *      current SYSCLK: largest ARR within PWM_MAX_ERROR_PPM
  *   3. Configure channel 1 for PWM Mode 1:
  *      - Output HIGH when CNT < CCR1
  *      - Output LOW when CNT >= CCR1
@@ -319,23 +331,32 @@ void System_Init(void)
  *   6. Restart timer if PWM was previously enabled
  * 
  * PARAMETERS:
- *   freq_index: Index into FREQ_TABLE (0-4 for A-E)
+ *   freq_mHz: Frequency in mHz (1000 = 1 Hz)
+ * 
+ * RETURNS:
+ *   1 if applied, 0 if out of range (previous frequency kept)
  *===========================================================================*/
 
-void PWM_Configure(uint8_t freq_index)
+uint8_t PWM_Configure(uint64_t freq_mHz)
 {
-    // Validate index
-    if (freq_index >= NUM_FREQUENCIES)
-        return;
+    Timer_PWMSolution sol;
     
-    const FrequencyConfig *config = &FREQ_TABLE[freq_index];
+    // Validate range
+    if (freq_mHz < PWM_MIN_MHZ || freq_mHz > PWM_MAX_MHZ)
+        return 0;
     
     // Stop timer before reconfiguring (safety measure)
     Timer_Stop(TIM14);
     
-    // Configure timer with new frequency parameters
-    // Note: Timer_Init internally subtracts 1 from PSC and ARR
-    Timer_Init(TIM14, config->prescaler, config->period);
+    // Search PSC/ARR and load them (PSC-1 / ARR-1 handled inside)
+    if (!Timer_SetFrequency(TIM14, freq_mHz, PWM_MAX_ERROR_PPM, &sol))
+    {
+        if (g_state.pwm_enabled)
+            Timer_Start(TIM14);
+        return 0;
+    }
+    g_state.freq_mHz = freq_mHz;
+    g_state.pwm = sol;
     
     // Set PWM Mode 1:
     // - Output is HIGH while counter (CNT) < compare value (CCR1)
@@ -353,6 +374,7 @@ void PWM_Configure(uint8_t freq_index)
     {
         Timer_Start(TIM14);
     }
+    return 1;
 }
 
 /*=============================================================================
@@ -363,6 +385,8 @@ void PWM_Configure(uint8_t freq_index)
  * HOW IT WORKS:
  *   Duty cycle is controlled by the CCR1 (Capture/Compare Register 1).
  *   The formula is: Duty% = (CCR1 / ARR) × 100
+ *   The solver keeps ARR as large as possible, so the steps are as fine
+ *   as the timer allows (see "bit duty" on the status screen).
  *   
  *   Example at 1kHz (ARR = 1000):
  *   - 0% duty   → CCR1 = 0     → always LOW
@@ -445,6 +469,36 @@ void UI_DrawHeader(void)
     #endif
 }
 
+/*-----------------------------------------------------------------------------
+ * BOX LINE
+ * Pads a status line with spaces and closes it with '|' in column 79
+ * (buffer must hold at least 80 characters)
+ *---------------------------------------------------------------------------*/
+
+/*-----------------------------------------------------------------------------
+ * APPEND
+ * Copies text to p, stopping before end (the terminator always fits);
+ * returns the new end of the string for chaining with Fmt_*
+ *---------------------------------------------------------------------------*/
+
+static char *UI_Append(char *p, const char *text, const char *end)
+{
+    while (*text && p < end - 1)
+        *p++ = *text++;
+    *p = '\0';
+    return p;
+}
+
+static void UI_BoxLine(char *buffer)
+{
+    size_t len = strlen(buffer);
+    
+    while (len < 78)
+        buffer[len++] = ' ';
+    buffer[78] = '|';
+    buffer[79] = '\0';
+}
+
 /*-----------------------------------------------------------------------------
  * DRAW STATUS
  * Displays current PWM state, frequency, duty cycle, and visual duty bar
@@ -452,8 +506,7 @@ void UI_DrawHeader(void)
 
 void UI_DrawStatus(void)
 {
-    char buffer[100];
-    const FrequencyConfig *config = &FREQ_TABLE[g_state.freq_index];
+    char buffer[128];
     
     #ifdef ENABLE_FANCY_UI
     _USART_TxStringXY(USART2, 1, 5, "┌─ PWM STATUS ────────────────────────────────────────────────────────────────┐");
@@ -461,19 +514,38 @@ void UI_DrawStatus(void)
     _USART_TxStringXY(USART2, 1, 5, "+-- PWM STATUS ---------------------------------------------------------------+");
     #endif
     
+    const char *end = buffer + sizeof(buffer) - _FMT_DEC64_SIZE;   // room for one number
+    char *p;
+    
     // State line (ACTIVE or IDLE)
-    sprintf(buffer, "| State:      %-15s                                              |",
-            g_state.pwm_enabled ? "ACTIVE" : "IDLE (STOPPED)");
+    p = UI_Append(buffer, "| State:      ", end);
+    UI_Append(p, g_state.pwm_enabled ? "ACTIVE" : "IDLE (STOPPED)", end);
+    UI_BoxLine(buffer);
     _USART_TxStringXY(USART2, 1, 6, buffer);
     
-    // Frequency line
-    sprintf(buffer, "| Frequency:  %-6u Hz (Key: %c)                                            |",
-            config->freq_hz, config->key);
+    // Frequency line: what the timer really makes, its duty resolution and error
+    // "| Frequency:  %lu.%03lu Hz  (PSC %lu, ARR %lu, %u-bit duty, %ld ppm)"
+    p = UI_Append(buffer, "| Frequency:  ", end);
+    p += Fmt_U64(p, g_state.pwm.actual_mHz / 1000, 0, ' ');
+    *p++ = '.';
+    p += Fmt_U32(p, (uint32_t)(g_state.pwm.actual_mHz % 1000), 3, '0');
+    p = UI_Append(p, " Hz  (PSC ", end);
+    p += Fmt_U32(p, g_state.pwm.prescaler, 0, ' ');
+    p = UI_Append(p, ", ARR ", end);
+    p += Fmt_U32(p, g_state.pwm.period, 0, ' ');
+    p = UI_Append(p, ", ", end);
+    p += Fmt_U32(p, g_state.pwm.bits, 0, ' ');
+    p = UI_Append(p, "-bit duty, ", end);
+    p += Fmt_I32(p, g_state.pwm.errorPpm, 0, ' ');
+    UI_Append(p, " ppm)", end);
+    UI_BoxLine(buffer);
     _USART_TxStringXY(USART2, 1, 7, buffer);
     
     // Duty cycle percentage
-    sprintf(buffer, "| Duty Cycle: %3u%%                                                         |",
-            g_state.duty_percent);
+    p = UI_Append(buffer, "| Duty Cycle: ", end);
+    p += Fmt_U32(p, g_state.duty_percent, 3, ' ');
+    UI_Append(p, "%", end);
+    UI_BoxLine(buffer);
     _USART_TxStringXY(USART2, 1, 8, buffer);
     
     // Visual duty cycle bar (50 characters wide)
@@ -490,7 +562,12 @@ void UI_DrawStatus(void)
     _USART_TxString(USART2, "]       |");
     
     // Output pin information
-    sprintf(buffer, "| Output Pin: PA%-2d (TIM14_CH1)                                              |", PWM_PIN);
+    p = UI_Append(buffer, "| Output Pin: PA", end);
+    p += Fmt_U32(p, PWM_PIN, 0, ' ');
+    if (PWM_PIN < 10)
+        *p++ = ' ';                               // "PA%-2d"
+    UI_Append(p, " (TIM14_CH1)", end);
+    UI_BoxLine(buffer);
     _USART_TxStringXY(USART2, 1, 10, buffer);
     
     #ifdef ENABLE_FANCY_UI
@@ -521,7 +598,7 @@ void UI_DrawControls(void)
     _USART_TxStringXY(USART2, 1, 19, "| FREQUENCY SELECTION:                                                        |");
     _USART_TxStringXY(USART2, 1, 20, "|   A ........... 100 Hz      D ........... 5 kHz                            |");
     _USART_TxStringXY(USART2, 1, 21, "|   B ........... 500 Hz      E ........... 10 kHz                           |");
-    _USART_TxStringXY(USART2, 1, 22, "|   C ........... 1 kHz                                                       |");
+    _USART_TxStringXY(USART2, 1, 22, "|   C ........... 1 kHz       F ........... any frequency (type Hz, Enter)   |");
     
     #ifdef ENABLE_FANCY_UI
     _USART_TxStringXY(USART2, 1, 23, "└─────────────────────────────────────────────────────────────────────────────┘");
@@ -529,8 +606,11 @@ void UI_DrawControls(void)
     _USART_TxStringXY(USART2, 1, 23, "+-----------------------------------------------------------------------------+");
     #endif
     
-    // Initial clock display (00:00:00)
-    _USART_TxStringXY(USART2, 1, 24, "Uptime: 00:00:00");
+    // Initial clock display (00:00:00), or why there is none
+    if (g_state.uptime_ok)
+        _USART_TxStringXY(USART2, 1, 24, "Uptime: 00:00:00");
+    else
+        _USART_TxStringXY(USART2, 1, 24, "Uptime: --:--:-- (no 1 Hz PSC/ARR at this SYSCLK)");
 }
 
 /*-----------------------------------------------------------------------------
@@ -543,6 +623,34 @@ void UI_Refresh(void)
     UI_DrawStatus();
 }
 
+/*-----------------------------------------------------------------------------
+ * DRAW FREQUENCY ENTRY
+ * Row 12 shows the frequency being typed, a message, or nothing
+ *---------------------------------------------------------------------------*/
+
+void UI_DrawEntry(const char *message)
+{
+    char buffer[100];
+    const char *end = buffer + sizeof(buffer);
+    char *p = UI_Append(buffer, " ", end);
+    
+    if (g_state.entry_active)
+    {
+        p = UI_Append(p, "Frequency: ", end);
+        p = UI_Append(p, g_state.entry, end);
+        UI_Append(p, "_ Hz   (Enter = apply, Esc = cancel)", end);
+    }
+    else if (message)
+        UI_Append(p, message, end);
+    
+    // Pad to the full width so the previous text is overwritten
+    size_t len = strlen(buffer);
+    while (len < 79)
+        buffer[len++] = ' ';
+    buffer[79] = '\0';
+    _USART_TxStringXY(USART2, 1, 12, buffer);
+}
+
 /*=============================================================================
  * UPTIME CLOCK UPDATE
  * 
@@ -573,8 +681,14 @@ void Uptime_Update(void)
         uint32_t seconds = g_state.uptime_seconds % 60;         // Modulo 60
         
         // Format and display time (HH:MM:SS)
-        char time_str[20];
-        sprintf(time_str, "Uptime: %02lu:%02lu:%02lu", hours, minutes, seconds);
+        // Fmt_U32 with width 2 and '0' pad is the same as "%02lu"
+        char time_str[20] = "Uptime: ";
+        char *p = &time_str[8];
+        p += Fmt_U32(p, hours, 2, '0');
+        *p++ = ':';
+        p += Fmt_U32(p, minutes, 2, '0');
+        *p++ = ':';
+        Fmt_U32(p, seconds, 2, '0');
         _USART_TxStringXY(USART2, 1, 24, time_str);
     }
 }
@@ -590,10 +704,18 @@ void Uptime_Update(void)
  *   -/_   - Decrease duty by 5%
  *   0-9   - Set duty to 0%, 10%, 20%, ..., 90%
  *   A-E   - Select frequency (100Hz, 500Hz, 1kHz, 5kHz, 10kHz)
+ *   F     - Type any frequency in Hz (see Process_FreqEntry)
  *===========================================================================*/
 
 void Process_KeyPress(char key)
 {
+    // While typing a frequency every key belongs to the entry
+    if (g_state.entry_active)
+    {
+        Process_FreqEntry(key);
+        return;
+    }
+    
     // Convert lowercase to uppercase (for frequency keys A-E)
     if (key >= 'a' && key <= 'z')
         key = key - 32;
@@ -644,27 +766,105 @@ void Process_KeyPress(char key)
         
         // ┌─────────────────────────────────────────────────────────────────┐
         // │ A-E - Select Frequency                                          │
-        // │ Search frequency table for matching key                         │
+        // │ Search preset table for matching key                            │
         // └─────────────────────────────────────────────────────────────────┘
         case 'A': case 'B': case 'C': case 'D': case 'E':
             for (uint8_t i = 0; i < NUM_FREQUENCIES; i++)
             {
-                if (FREQ_TABLE[i].key == key)
+                if (FREQ_PRESETS[i].key == key)
                 {
-                    g_state.freq_index = i;
-                    PWM_Configure(i);
+                    PWM_Configure(FREQ_PRESETS[i].freq_hz * 1000ULL);
                     UI_Refresh();
                     break;
                 }
             }
             break;
         
+        // ┌─────────────────────────────────────────────────────────────────┐
+        // │ F - Start Typing a Frequency                                    │
+        // └─────────────────────────────────────────────────────────────────┘
+        case 'F':
+            g_state.entry[0] = '\0';
+            g_state.entry_active = 1;
+            UI_DrawEntry(0);
+            break;
+        
         default:
             // Ignore unrecognized keys
             break;
     }
 }
 
+/*=============================================================================
+ * FREQUENCY ENTRY
+ * 
+ * After F, keys build a frequency in Hz with up to 3 decimals (mHz):
+ *   0-9 and one '.'   - add to the number
+ *   Backspace         - remove the last character
+ *   Enter             - apply (out of range / unreachable is reported)
+ *   Esc               - cancel
+ *===========================================================================*/
+
+void Process_FreqEntry(char key)
+{
+    size_t len = strlen(g_state.entry);
+    const char *dot = strchr(g_state.entry, '.');
+    
+    if (key >= '0' && key <= '9')
+    {
+        // Room left, and at most 3 digits after the point
+        if (len < sizeof(g_state.entry) - 1 && !(dot && strlen(dot) > 3))
+        {
+            g_state.entry[len] = key;
+            g_state.entry[len + 1] = '\0';
+        }
+        UI_DrawEntry(0);
+    }
+    else if (key == '.' && !dot && len < sizeof(g_state.entry) - 1)
+    {
+        g_state.entry[len] = '.';
+        g_state.entry[len + 1] = '\0';
+        UI_DrawEntry(0);
+    }
+    else if ((key == '\b' || key == 127) && len > 0)
+    {
+        g_state.entry[len - 1] = '\0';
+        UI_DrawEntry(0);
+    }
+    else if (key == 27)
+    {
+        g_state.entry_active = 0;
+        UI_DrawEntry(0);
+    }
+    else if (key == '\r' || key == '\n')
+    {
+        // Hz part, then the decimals scaled to mHz ("2.5" -> 2500)
+        uint64_t mhz = 0;
+        uint8_t decimals = 0;
+        for (const char *c = g_state.entry; *c; c++)
+        {
+            if (*c == '.')
+                continue;
+            mhz = mhz * 10 + (uint64_t)(*c - '0');
+            if (dot && c > dot)
+                decimals++;
+        }
+        while (decimals++ < 3)
+            mhz *= 10;
+        
+        g_state.entry_active = 0;
+        if (PWM_Configure(mhz))
+        {
+            UI_DrawEntry(0);
+            UI_Refresh();
+        }
+        else
+        {
+            UI_DrawEntry("Frequency must be 1 Hz .. 8 MHz and reachable within 0.1%");
+        }
+    }
+}
+
 #ifdef ENABLE_BUTTONS
 /*=============================================================================
  * BUTTON INPUT PROCESSING (ENHANCEMENT)
@@ -680,8 +880,8 @@ void Process_KeyPress(char key)
  * BUTTON FUNCTIONS:
  *   S1 (PA0)  - Decrease duty by 1%
  *   S2 (PA1)  - Increase duty by 1%
- *   S3 (PA11) - Previous frequency (doesn't wrap at start)
- *   S4 (PA12) - Next frequency (doesn't wrap at end)
+ *   S3 (PA11) - Previous preset below the current frequency
+ *   S4 (PA12) - Next preset above the current frequency
  *===========================================================================*/
 
 typedef struct {
@@ -742,11 +942,15 @@ void Process_Buttons(void)
     uint8_t s3_state = _GPIO_GetPinIState(GPIOA, BTN_S3_PIN);
     if (s3_state == 0 && buttons[2].last_state == 1)  // Falling edge
     {
-        if (g_state.freq_index > 0)  // Can't go below index 0
+        // Highest preset below the current frequency (typed ones too)
+        for (int8_t i = NUM_FREQUENCIES - 1; i >= 0; i--)
         {
-            g_state.freq_index--;
-            PWM_Configure(g_state.freq_index);
-            UI_Refresh();
+            if (FREQ_PRESETS[i].freq_hz * 1000ULL < g_state.freq_mHz)
+            {
+                PWM_Configure(FREQ_PRESETS[i].freq_hz * 1000ULL);
+                UI_Refresh();
+                break;
+            }
         }
     }
     buttons[2].last_state = s3_state;
@@ -758,11 +962,15 @@ void Process_Buttons(void)
     uint8_t s4_state = _GPIO_GetPinIState(GPIOA, BTN_S4_PIN);
     if (s4_state == 0 && buttons[3].last_state == 1)  // Falling edge
     {
-        if (g_state.freq_index < NUM_FREQUENCIES - 1)  // Can't exceed last index
+        // Lowest preset above the current frequency
+        for (uint8_t i = 0; i < NUM_FREQUENCIES; i++)
         {
-            g_state.freq_index++;
-            PWM_Configure(g_state.freq_index);
-            UI_Refresh();
+            if (FREQ_PRESETS[i].freq_hz * 1000ULL > g_state.freq_mHz)
+            {
+                PWM_Configure(FREQ_PRESETS[i].freq_hz * 1000ULL);
+                UI_Refresh();
+                break;
+            }
         }
     }
     buttons[3].last_state = s4_state;
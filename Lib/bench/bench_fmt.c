@@ -0,0 +1,121 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  BENCH: fmt against sprintf
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   bench_fmt.c
+//
+//  Cycles per call for each Fmt_* function and the sprintf format it
+//  replaces, measured with the profiler (one scope per call, Begin /
+//  End overhead taken out), and a check that both wrote the same
+//  text. The table goes out on USART2 at 115200.
+//
+//  On a board: build it as main.c of a G031 project with Lib/src
+//  prof.c, fmt.c, usart.c and clock.c. newlib-nano only formats
+//  long long and double with the printf long long / floating point
+//  options turned on in the project.
+//  On the host: make -C Lib/sim bench (simulator cycles follow host
+//  time, so only the ratios mean anything there).
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include "stm32g031xx.h"
+#include "usart.h"
+#include "fmt.h"
+#include "prof.h"
+#include <stdio.h>
+#include <string.h>
+
+#define BENCH_RUNS  64u
+
+static Prof_Scope s_fmtU32 = PROF_SCOPE_INIT("Fmt_U32");
+static Prof_Scope s_sprU32 = PROF_SCOPE_INIT("sprintf %lu");
+static Prof_Scope s_fmtI32 = PROF_SCOPE_INIT("Fmt_I32 pad 8");
+static Prof_Scope s_sprI32 = PROF_SCOPE_INIT("sprintf %08ld");
+static Prof_Scope s_fmtHex = PROF_SCOPE_INIT("Fmt_Hex32");
+static Prof_Scope s_sprHex = PROF_SCOPE_INIT("sprintf %08lX");
+static Prof_Scope s_fmtU64 = PROF_SCOPE_INIT("Fmt_U64");
+static Prof_Scope s_sprU64 = PROF_SCOPE_INIT("sprintf %llu");
+static Prof_Scope s_fmtCur = PROF_SCOPE_INIT("Fmt_Cursor");
+static Prof_Scope s_sprCur = PROF_SCOPE_INIT("sprintf ESC[%u;%uH");
+static Prof_Scope s_fmtEng = PROF_SCOPE_INIT("Fmt_Engineering");
+static Prof_Scope s_sprEng = PROF_SCOPE_INIT("sprintf %.3fx10^%d");
+
+static uint32_t s_mismatches = 0;
+
+static void Same(const char *a, const char *b)
+{
+    if (strcmp(a, b) != 0)
+    {
+        s_mismatches++;
+        _USART_TxString(USART2, "mismatch: ");
+        _USART_TxString(USART2, a);
+        _USART_TxString(USART2, " / ");
+        _USART_TxString(USART2, b);
+        _USART_TxString(USART2, "\r\n");
+    }
+}
+
+// What the Practice main did before Fmt_Engineering
+static void SprintfEngineering(char *buf, uint64_t value)
+{
+    double m = (double)value;
+    int e = 0;
+
+    while (m >= 1000.0)
+    {
+        m /= 1000.0;
+        e += 3;
+    }
+    sprintf(buf, "%.3fx10^%d", m, e);
+}
+
+int main(void)
+{
+    char a[_FMT_BIN64_SIZE], b[_FMT_BIN64_SIZE];
+    uint32_t u = 7u;
+    uint64_t w = 12345u;
+
+    _USART_Init_USART2(SystemCoreClock, 115200);
+    Prof_Init();
+
+    for (uint32_t i = 0; i < BENCH_RUNS; i++)
+    {
+        u = u * 2654435761u + 12345u;                // spread over all digit counts
+        w = w * 6364136223846793005ull + 1442695040888963407ull;
+        int32_t s = (int32_t)(u >> (i & 31u)) - 100000;
+        uint64_t eng = (w >> (i & 63u)) + 1000u;
+
+        Prof_Begin(&s_fmtU32); Fmt_U32(a, u, 0, ' '); Prof_End(&s_fmtU32);
+        Prof_Begin(&s_sprU32); sprintf(b, "%lu", (unsigned long)u); Prof_End(&s_sprU32);
+        Same(a, b);
+
+        Prof_Begin(&s_fmtI32); Fmt_I32(a, s, 8, '0'); Prof_End(&s_fmtI32);
+        Prof_Begin(&s_sprI32); sprintf(b, "%08ld", (long)s); Prof_End(&s_sprI32);
+        Same(a, b);
+
+        Prof_Begin(&s_fmtHex); Fmt_Hex32(a, u, 8); Prof_End(&s_fmtHex);
+        Prof_Begin(&s_sprHex); sprintf(b, "%08lX", (unsigned long)u); Prof_End(&s_sprHex);
+        Same(a, b);
+
+        Prof_Begin(&s_fmtU64); Fmt_U64(a, w, 0, ' '); Prof_End(&s_fmtU64);
+        Prof_Begin(&s_sprU64); sprintf(b, "%llu", (unsigned long long)w); Prof_End(&s_sprU64);
+        Same(a, b);
+
+        uint8_t row = (uint8_t)(1u + u % 255u), col = (uint8_t)(1u + (u >> 8) % 255u);
+        Prof_Begin(&s_fmtCur); Fmt_Cursor(a, row, col); Prof_End(&s_fmtCur);
+        Prof_Begin(&s_sprCur); sprintf(b, "\033[%u;%uH", row, col); Prof_End(&s_sprCur);
+        Same(a, b);
+
+        // not compared: a double rounds 999.9995 up to "1000.000x10^3"
+        Prof_Begin(&s_fmtEng); Fmt_Engineering(a, eng, 3); Prof_End(&s_fmtEng);
+        Prof_Begin(&s_sprEng); SprintfEngineering(b, eng); Prof_End(&s_sprEng);
+    }
+
+    Prof_Report(USART2);
+    _USART_TxString(USART2, s_mismatches ? "outputs differ\r\n" : "outputs match\r\n");
+    _USART_TxFlush(USART2);
+
+    while (1)
+        __WFI();
+}
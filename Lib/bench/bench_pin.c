@@ -0,0 +1,126 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  BENCH: pin.h against the gpio lib
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   bench_pin.c
+//
+//  Edges on PA4 (the ICA06 marker pin) through each path, measured
+//  with the profiler: a scope is one burst of BENCH_EDGES edges
+//  written out in line (no loop in between), Begin / End overhead
+//  taken out. After the profiler table, one line per path with the
+//  cycles per edge and the edge rate at the current SYSCLK. The
+//  output goes out on USART2 at 115200.
+//
+//  On a board: build it as main.c of a G031 project with Lib/src
+//  prof.c, gpio.c, fmt.c, usart.c and clock.c, optimised (-O1 or
+//  more: pin.h only inlines to one store when the compiler inlines).
+//  A scope on PA4 shows the bursts.
+//  On the host: make -C Lib/sim bench (simulator cycles follow host
+//  time, so only the ratios mean anything there).
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include "stm32g031xx.h"
+#include "gpio.h"
+#include "pin.h"
+#include "usart.h"
+#include "fmt.h"
+#include "prof.h"
+
+#define BENCH_RUNS   64u
+#define BENCH_EDGES  16u                      // per scope: 8 high / low pairs
+
+#define MARKER_PORT  GPIOA
+#define MARKER_PIN   4
+
+static const Pin_Desc s_marker = PIN_DESC_INIT(A, 4);
+
+#define X8(stmt)  stmt; stmt; stmt; stmt; stmt; stmt; stmt; stmt
+#define X16(stmt) X8(stmt); X8(stmt)
+
+static Prof_Scope s_pinHighLow = PROF_SCOPE_INIT("Pin_High / Pin_Low");
+static Prof_Scope s_pinWrite = PROF_SCOPE_INIT("Pin_Write");
+static Prof_Scope s_pinToggle = PROF_SCOPE_INIT("Pin_Toggle");
+static Prof_Scope s_gpioSetClear = PROF_SCOPE_INIT("GPIO_Set / GPIO_Clear");
+static Prof_Scope s_gpioToggle = PROF_SCOPE_INIT("GPIO_Toggle");
+static Prof_Scope s_pinSetClear = PROF_SCOPE_INIT("_GPIO_PinSet / Clear");
+static Prof_Scope s_pinToggleOld = PROF_SCOPE_INIT("_GPIO_PinToggle");
+
+static void Bench_Line(const Prof_Scope *pScope)
+{
+    char num[_FMT_DEC64_SIZE];                        // "999.99x10^18" at most
+    uint64_t edges = (uint64_t)pScope->count * BENCH_EDGES;
+
+    if (!edges || !pScope->total)
+        return;
+
+    // cycles per edge with one decimal, edges per second at SYSCLK
+    uint32_t tenths = (uint32_t)((pScope->total * 10u + edges / 2u) / edges);
+    uint64_t rate = ((uint64_t)SystemCoreClock * edges) / pScope->total;
+
+    Fmt_Fixed(num, (int32_t)tenths, 1);
+    _USART_TxString(USART2, num);
+    _USART_TxString(USART2, " cycles/edge, ");
+    Fmt_Engineering(num, rate, 2);
+    _USART_TxString(USART2, num);
+    _USART_TxString(USART2, " edges/s  ");
+    _USART_TxString(USART2, pScope->name);
+    _USART_TxString(USART2, "\r\n");
+}
+
+int main(void)
+{
+    _USART_Init_USART2(SystemCoreClock, 115200);
+
+    RCC->IOPENR |= RCC_IOPENR_GPIOAEN;
+    _GPIO_SetPinMode(MARKER_PORT, MARKER_PIN, _GPIO_PinMode_Output);
+
+    Prof_Init();
+
+    for (uint32_t i = 0; i < BENCH_RUNS; i++)
+    {
+        Prof_Begin(&s_pinHighLow);
+        X8(Pin_High(s_marker); Pin_Low(s_marker));
+        Prof_End(&s_pinHighLow);
+
+        Prof_Begin(&s_pinWrite);
+        X8(Pin_Write(s_marker, 1); Pin_Write(s_marker, 0));
+        Prof_End(&s_pinWrite);
+
+        Prof_Begin(&s_pinToggle);
+        X16(Pin_Toggle(s_marker));
+        Prof_End(&s_pinToggle);
+
+        Prof_Begin(&s_gpioSetClear);
+        X8(GPIO_Set(MARKER_PORT, MARKER_PIN); GPIO_Clear(MARKER_PORT, MARKER_PIN));
+        Prof_End(&s_gpioSetClear);
+
+        Prof_Begin(&s_gpioToggle);
+        X16(GPIO_Toggle(MARKER_PORT, MARKER_PIN));
+        Prof_End(&s_gpioToggle);
+
+        Prof_Begin(&s_pinSetClear);
+        X8(_GPIO_PinSet(MARKER_PORT, MARKER_PIN); _GPIO_PinClear(MARKER_PORT, MARKER_PIN));
+        Prof_End(&s_pinSetClear);
+
+        Prof_Begin(&s_pinToggleOld);
+        X16(_GPIO_PinToggle(MARKER_PORT, MARKER_PIN));
+        Prof_End(&s_pinToggleOld);
+    }
+
+    Prof_Report(USART2);
+    _USART_TxString(USART2, "\r\n");
+    Bench_Line(&s_pinHighLow);
+    Bench_Line(&s_pinWrite);
+    Bench_Line(&s_pinToggle);
+    Bench_Line(&s_gpioSetClear);
+    Bench_Line(&s_gpioToggle);
+    Bench_Line(&s_pinSetClear);
+    Bench_Line(&s_pinToggleOld);
+    _USART_TxString(USART2, Pin_Driven(s_marker) ? "PA4 left high\r\n" : "PA4 low\r\n");
+    _USART_TxFlush(USART2);
+
+    while (1)
+        __WFI();
+}
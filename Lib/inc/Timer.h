@@ -11,4 +11,124 @@ void Timer14_Init_1MHzTick(uint32_t sysclkHz);
 void Timer14_Delay_us(uint16_t us);                                               // blocking microsecond delay (poll UIF)
 void Timer14_Delay_ms(uint16_t ms);                                               // blocking millisecond delay (built on us)
 
+//==================================================================================================
+// GENERAL TIMER + PWM (ICA08 / Lab02 API, every channel of TIM1/2/3/14/16/17)
+//==================================================================================================
+typedef enum                                                                     // PWM output mode
+{                                                                                // start enum
+    TIMER_PWM_MODE1 = 0,                                                         // active while CNT < CCR (normal)
+    TIMER_PWM_MODE2 = 1                                                          // active while CNT > CCR (inverted)
+} Timer_PWMMode;                                                                 // end enum
+
+typedef enum                                                                     // capture/compare channel
+{                                                                                // start enum
+    TIMER_CHANNEL1 = 1,                                                          // CH1 (every timer)
+    TIMER_CHANNEL2 = 2,                                                          // CH2 (TIM1/2/3)
+    TIMER_CHANNEL3 = 3,                                                          // CH3 (TIM1/2/3)
+    TIMER_CHANNEL4 = 4                                                           // CH4 (TIM1/2/3)
+} Timer_Channel;                                                                 // end enum
+
+typedef enum                                                                     // output polarity (CCxP / CCxNP)
+{                                                                                // start enum
+    TIMER_POLARITY_HIGH = 0,                                                     // active level = high
+    TIMER_POLARITY_LOW  = 1                                                      // active level = low
+} Timer_Polarity;                                                                // end enum
+
+void Timer_Init(TIM_TypeDef *pTimer, uint16_t prescaler, uint16_t period);       // PSC = prescaler-1, ARR = period-1
+void Timer_Start(TIM_TypeDef *pTimer);                                           // set CEN
+void Timer_Stop(TIM_TypeDef *pTimer);                                            // clear CEN
+int Timer_CheckUpdateFlag(TIM_TypeDef *pTimer);                                  // 1 if UIF set
+void Timer_ClearUpdateFlag(TIM_TypeDef *pTimer);                                 // clear UIF
+uint32_t Timer_GetARR(TIM_TypeDef *pTimer);                                      // current ARR
+uint8_t Timer_ChannelCount(TIM_TypeDef *pTimer);                                 // 4 on TIM1/2/3, 1 on TIM14/16/17
+
+void Timer_ConfigPWM(TIM_TypeDef *pTimer, Timer_Channel channel, Timer_PWMMode mode);     // OCxM PWM1/2 + preload
+void Timer_SetDuty(TIM_TypeDef *pTimer, Timer_Channel channel, uint32_t duty);            // raw CCR (0..ARR+1)
+void Timer_SetDutyPercent(TIM_TypeDef *pTimer, Timer_Channel channel, uint8_t percent);   // 0..100 % of period
+void Timer_EnableOutput(TIM_TypeDef *pTimer, Timer_Channel channel);                      // CCxE on
+void Timer_DisableOutput(TIM_TypeDef *pTimer, Timer_Channel channel);                     // CCxE off
+void Timer_SetPolarity(TIM_TypeDef *pTimer, Timer_Channel channel, Timer_Polarity polarity);  // CCxP
+void Timer_SetPreload(TIM_TypeDef *pTimer, Timer_Channel channel, uint8_t enable);        // OCxPE: new CCR at update
+
+//==================================================================================================
+// COMPLEMENTARY OUTPUTS + DEAD-TIME (TIM1 CH1..3, TIM16/17 CH1)
+//==================================================================================================
+void Timer_EnableComplementary(TIM_TypeDef *pTimer, Timer_Channel channel,       // CCxNE on, CCxNP = polarity
+                               Timer_Polarity polarity);                         // (no-op where CHxN doesn't exist)
+void Timer_DisableComplementary(TIM_TypeDef *pTimer, Timer_Channel channel);     // CCxNE off
+uint32_t Timer_SetDeadTime(TIM_TypeDef *pTimer, uint32_t deadTimeNs);            // BDTR DTG (+ CKD), returns ns applied
+
+//==================================================================================================
+// MASTER / SLAVE SYNCHRONIZED START (TIM1/2/3)
+//   Timer_SyncSlave(TIM3, TIM1); Timer_SyncSlave(TIM2, TIM1); Timer_Start(TIM1);
+//   -> all three counters start on the same timer clock, no software skew
+//==================================================================================================
+uint8_t Timer_SyncSlave(TIM_TypeDef *pSlave, TIM_TypeDef *pMaster);              // slave starts with master (1 = ok)
+void Timer_SyncRelease(TIM_TypeDef *pSlave);                                     // back to free running
+
+//==================================================================================================
+// PWM FREQUENCY SOLVER (any frequency, best duty resolution)
+//==================================================================================================
+#ifndef TIMER_PWM_DEFAULT_PPM                                                    // allow override before include
+#define TIMER_PWM_DEFAULT_PPM   1000u                                            // default error bound: 0.1 %
+#endif                                                                           // end override
+
+typedef struct                                                                   // result of the PSC/ARR search
+{                                                                                // start struct
+    uint32_t prescaler;                                                          // divider 1..65536 (PSC = prescaler-1)
+    uint32_t period;                                                             // counts per cycle (ARR = period-1)
+    uint64_t actual_mHz;                                                         // achieved frequency in mHz
+    int32_t errorPpm;                                                            // (actual - target) / target in ppm
+    uint8_t bits;                                                                // duty resolution floor(log2(period))
+} Timer_PWMSolution;                                                             // end struct
+
+uint8_t Timer_SolvePWM(uint32_t timerClkHz, uint64_t target_mHz, uint32_t maxErrorPpm,  // search PSC/ARR: 1 = within bound
+                       uint32_t maxPeriod, Timer_PWMSolution *pSol);                    // (pSol gets the closest anyway)
+uint8_t Timer_SetFrequency(TIM_TypeDef *pTimer, uint64_t target_mHz,                    // solve at Clock_GetSysclkHz() and
+                           uint32_t maxErrorPpm, Timer_PWMSolution *pSol);              // apply, duty ratios kept
+void Timer_SetDutyQ16(TIM_TypeDef *pTimer, Timer_Channel channel, uint32_t duty);       // 0..65536 = 0..100 % (full resolution)
+
+//==================================================================================================
+// SIGMA-DELTA / DITHERED PWM (16..20 bit duty through an RC filter)
+//   The target is a fraction of the period with more bits than the timer has counts. Each PWM
+//   period gets a whole CCR value and the rounding error is fed into the next ones (1st order:
+//   error integrated, 2nd order: error shaped by (1 - z^-1)^2), so the filter sees the average.
+//   Feed it from the update ISR (Timer_DitherTick) or fill DMA buffers (Timer_DitherFill + wave).
+//==================================================================================================
+typedef struct                                                                   // one dithered channel
+{                                                                                // start struct
+    TIM_TypeDef *pTimer;                                                         // timer driving the pin
+    Timer_Channel channel;                                                       // CCRx written by Tick
+    uint8_t order;                                                               // 1 or 2
+    uint8_t bits;                                                                // resolution of the value (1..24)
+    uint32_t period;                                                             // ARR + 1 at init
+    volatile uint32_t base;                                                      // whole counts of the target
+    volatile int32_t frac;                                                       // leftover counts, Q(bits)
+    int32_t err1;                                                                // last rounding error
+    int32_t err2;                                                                // the one before
+} Timer_Dither;                                                                  // end struct
+
+void Timer_DitherInit(Timer_Dither *pDither, TIM_TypeDef *pTimer, Timer_Channel channel,  // attach, value 0
+                      uint8_t order, uint8_t bits);                              // order 1/2, bits of value
+void Timer_DitherSet(Timer_Dither *pDither, uint32_t value);                     // 0..2^bits = 0..100 % duty
+uint32_t Timer_DitherNext(Timer_Dither *pDither);                                // CCR for the next period
+void Timer_DitherTick(Timer_Dither *pDither);                                    // ISR: clear UIF, write CCRx
+void Timer_DitherFill(Timer_Dither *pDither, uint16_t *pBuf, uint16_t count);    // DMA: count CCR values
+
+//==================================================================================================
+// FOLLOWING SYSCLK CHANGES (clock lib notifications)
+//   A kept timer holds its tick rate / PWM frequency across Clock_SetSysclk:
+//     PSC alone when (PSC+1) * new / old is a whole divider (a 1 MHz tick at 64 <-> 16 MHz),
+//     else PSC / ARR solved again for the old frequency and CCRs scaled to keep the duty.
+//   The new values go through the preload registers (ARPE, OCxPE set) and take effect at the next
+//   update: the period running during the switch is stretched or squeezed once, no runt pulse.
+//   SysTick gets LOAD recomputed; a tick in flight that would run long ends at once instead.
+//==================================================================================================
+#ifndef _TIMER_KEEP_MAX                                                          // allow override before include
+#define _TIMER_KEEP_MAX   4u                                                     // timers that can be kept
+#endif                                                                           // end override
+
+uint8_t Timer_KeepTiming(TIM_TypeDef *pTimer, uint8_t enable);                   // follow SYSCLK changes (1 = ok, 0 = table full)
+uint8_t Timer_SysTickInit(uint32_t tickHz);                                      // SysTick at tickHz + IRQ, kept across changes (0 = out of range)
+
 #endif                                                                           // include guard end
@@ -0,0 +1,118 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  CAPTURE (frequency / duty / jitter measurement)
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   capture.h
+//  Version History
+//    Created to check the PWM, wave and DDS outputs against the
+//    numbers the solvers promise, and to measure outside signals
+//
+//  PWM input mode on TIM2 or TIM3: TI1 feeds two channels,
+//     CH1 = rising edge  -> CCR1 = period   (and the counter resets)
+//     CH2 = falling edge -> CCR2 = high time
+//  so every period is measured by the hardware with no software
+//  timestamp error (one timer tick of resolution).
+//
+//  Two ways to collect the captures:
+//   - CAPTURE_MODE_IRQ: CC1/CC2/update interrupts. Overflows are
+//     counted, so periods longer than the counter (slow signals,
+//     seconds on TIM3 at 1 MHz) still come out right. Call
+//     Capture_IRQHandler from TIMx_IRQHandler.
+//   - CAPTURE_MODE_DMA: each rising edge bursts CCR1 + CCR2 into a
+//     circular buffer through DMAR (DMA1 channel 4), and the buffer
+//     halves are folded into the statistics in the DMA interrupt:
+//     fast signals with no interrupt per edge. Periods must fit in
+//     the counter (65536 ticks on TIM3, 2^32 on TIM2).
+//
+//  Input pins (set them to the AF with the gpio lib first):
+//     TIM2_CH1  PA0 / PA5 / PA15  AF2
+//     TIM3_CH1  PA6 / PB4 / PC6   AF1
+//  With the timebase module linked, TIM2 (and its interrupt) belongs
+//  to it: use TIM3 here.
+//  Self test: jumper the ICA08/Lab02 output PA4 (TIM14_CH1) to PA6 and
+//  measure it on TIM3.
+//
+//  Usage:
+//     _GPIO_ClockEnable(GPIOA);
+//     _GPIO_SetPinMode(GPIOA, 6, _GPIO_PinMode_AlternateFunction);
+//     _GPIO_SetPinAlternateFunction(GPIOA, 6, 1);         // TIM3_CH1
+//     Capture_Start(TIM3, 1000000, CAPTURE_MODE_IRQ);     // 1 us ticks
+//     void TIM3_IRQHandler(void) { Capture_IRQHandler(); }
+//     ...
+//     Capture_Result r;
+//     if (Capture_Read(&r)) ... r.freq_mHz, r.duty_ppm, r.jitterRms_ns
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef CAPTURE_LIB_H
+#define CAPTURE_LIB_H
+
+#include "stm32g031xx.h"
+#include <stdint.h>
+
+// DMAMUX request lines for the CH1 captures
+#define _CAPTURE_DMAREQ_TIM2_CH1  26
+#define _CAPTURE_DMAREQ_TIM3_CH1  32
+
+// Captures in the DMA ring (period + high time each), even
+#ifndef _CAPTURE_DMA_PAIRS
+#define _CAPTURE_DMA_PAIRS  16
+#endif
+
+// Overflows without an edge before the signal counts as lost (IRQ mode)
+#ifndef _CAPTURE_MAX_OVERFLOWS
+#define _CAPTURE_MAX_OVERFLOWS  1000u
+#endif
+
+typedef enum
+{
+    CAPTURE_MODE_IRQ = 0,       // interrupt per edge, overflow extension
+    CAPTURE_MODE_DMA            // DMA burst per period, no overflow extension
+} Capture_Mode;
+
+// Statistics since the last Capture_Read
+typedef struct
+{
+    uint32_t samples;           // periods measured
+    uint32_t freq_mHz;          // mean frequency
+    uint32_t duty_ppm;          // mean duty, 0..1000000
+    uint32_t period_ns;         // mean period
+    uint32_t high_ns;           // mean high time
+    uint32_t jitterPk_ns;       // longest - shortest period
+    uint32_t jitterRms_ns;      // standard deviation of the period
+    uint32_t overruns;          // edges lost (capture overwritten before read)
+    uint8_t lost;               // 1 = no edge for _CAPTURE_MAX_OVERFLOWS overflows
+} Capture_Result;
+
+/**
+ * @brief Set up PWM input mode on TIM2 or TIM3 and start counting
+ * @param tickHz Counter rate (PSC = timer clock / tickHz - 1):
+ *               resolution 1 / tickHz, top of range 65536 / tickHz on TIM3
+ * @return 1 if started, 0 for another timer or tickHz out of range
+ */
+uint8_t Capture_Start(TIM_TypeDef *pTimer, uint32_t tickHz, Capture_Mode mode);
+
+/**
+ * @brief Stop the timer, its interrupts and the DMA
+ */
+void Capture_Stop(void);
+
+/**
+ * @brief Counter rate actually set (timer clock / (PSC + 1))
+ */
+uint32_t Capture_GetTickHz(void);
+
+/**
+ * @brief Copy the statistics out and start a new window
+ * @return 1 if at least one period was measured
+ */
+uint8_t Capture_Read(Capture_Result *pResult);
+
+/**
+ * @brief CC1 / CC2 / update service (CAPTURE_MODE_IRQ).
+ *        Call from TIM2_IRQHandler or TIM3_IRQHandler.
+ */
+void Capture_IRQHandler(void);
+
+#endif // CAPTURE_LIB_H
@@ -1,9 +1,28 @@
-#ifndef CLOCK_H                                                                 // include guard start
-#define CLOCK_H                                                                 // include guard define
+#ifndef CLOCK_H                                                                  // include guard start
+#define CLOCK_H                                                                  // include guard define
 
-#include "stm32g031xx.h"                                                        // STM32G031 register definitions
+#include "stm32g031xx.h"                                                         // STM32G031 register definitions
 #include <stdint.h>                                                              // uint32_t types
 
+//==================================================================================================
+// CONFIG
+//==================================================================================================
+#ifndef _CLOCK_HSE_HZ                                                            // board crystal / external clock
+#define _CLOCK_HSE_HZ       8000000u                                             // HSE frequency (4..48 MHz)
+#endif
+
+#ifndef _CLOCK_HSE_BYPASS                                                        // 1 = external clock on OSC_IN
+#define _CLOCK_HSE_BYPASS   0                                                    // 0 = crystal
+#endif
+
+#ifndef _CLOCK_HSE_TIMEOUT                                                       // HSERDY polls before giving up
+#define _CLOCK_HSE_TIMEOUT  100000u                                              // a few ms at 16 MHz
+#endif
+
+#ifndef _CLOCK_USE_RANGE2                                                        // drop to voltage range 2 when SYSCLK <= 16 MHz (no PLL)
+#define _CLOCK_USE_RANGE2   1                                                    // 0 = always range 1
+#endif
+
 //==================================================================================================
 // PLL TARGET OPTIONS (SYSCLK after Clock_InitPll)
 //==================================================================================================
@@ -18,6 +37,29 @@ typedef enum
     PLL_64MHZ = 64                                                               // SYSCLK = 64 MHz (ICA07 requirement)
 } PLL_ClockFreq;                                                                 // enum name
 
+//==================================================================================================
+// CLOCK SOURCE + PLL SOLUTION
+//==================================================================================================
+typedef enum                                                                     // enum start
+{                                                                                // open enum
+    CLOCK_SRC_HSI16 = 0,                                                         // internal 16 MHz RC
+    CLOCK_SRC_HSE                                                                // external crystal / clock (_CLOCK_HSE_HZ)
+} Clock_Source;                                                                  // enum name
+
+typedef struct                                                                   // PLL dividers as numbers, frequencies they give
+{                                                                                // open struct
+    Clock_Source src;                                                            // PLL input oscillator
+    uint8_t m;                                                                   // input divider 1..8
+    uint8_t n;                                                                   // VCO multiplier 8..86
+    uint8_t r;                                                                   // SYSCLK divider 2..8
+    uint8_t p;                                                                   // P divider 2..32 (0 = output off)
+    uint8_t q;                                                                   // Q divider 2..8 (0 = output off)
+    uint32_t vcoHz;                                                              // src / M * N
+    uint32_t sysclkHz;                                                           // PLLRCLK = VCO / R
+    uint32_t pHz;                                                                // PLLPCLK = VCO / P
+    uint32_t qHz;                                                                // PLLQCLK = VCO / Q
+} Clock_PllConfig;                                                               // struct name
+
 //==================================================================================================
 // MCO OUTPUT SELECT + DIV OPTIONS (RCC->CFGR MCO on PA8)
 //==================================================================================================
@@ -42,11 +84,47 @@ typedef enum
     MCO_Div128 = 128                                                             // divide by 128
 } MCO_Div;                                                                       // enum name
 
+//==================================================================================================
+// CLOCK-CHANGE NOTIFICATION (drivers keep their timing when SYSCLK moves)
+//   Only real frequency changes are announced (Clock_Restore after Stop is silent):
+//     CLOCK_CHANGE_BEFORE  old clock still running, caller's interrupt state: drain / pause
+//     CLOCK_CHANGE_AFTER   new clock running, interrupts off until every listener is done:
+//                          rewrite BRR / PSC / LOAD, nothing sees a half-retimed system
+//   USART2 (_USART_Init_USART2), SysTick (Timer_SysTickInit), timers (Timer_KeepTiming) and the
+//   timebase subscribe themselves, so SYSCLK can drop to 16 MHz when idle and go to 64 MHz for a
+//   burst with Clock_SetSysclk and nothing else.
+//==================================================================================================
+#ifndef _CLOCK_LISTENERS                                                          // room in the registry
+#define _CLOCK_LISTENERS    8                                                     // subscribers at most
+#endif
+
+typedef enum                                                                      // enum start
+{                                                                                 // open enum
+    CLOCK_CHANGE_BEFORE = 0,                                                      // about to switch
+    CLOCK_CHANGE_AFTER                                                            // switched (IRQs off)
+} Clock_ChangePhase;                                                              // enum name
+
+typedef void (*Clock_ChangeCallback)(Clock_ChangePhase phase, uint32_t oldHz, uint32_t newHz); // listener
+
+//==================================================================================================
+// SWITCHING ORDER (Clock_SetSysclk / Clock_ApplyPll / Clock_InitPll)
+//   speeding up:  range 1 (wait VOSF) -> more wait states -> oscillator / PLL lock -> switch
+//   slowing down: switch -> fewer wait states -> range 2 (SYSCLK <= 16 MHz, PLL off)
+// Wait states are the fewest for the HCLK and range (range 1: 0WS <= 24, 1WS <= 48, 2WS <= 64 MHz;
+// range 2: 0WS <= 8, 1WS <= 16 MHz) and are read back before the clock moves.
+//==================================================================================================
+
 //==================================================================================================
 // API
 //==================================================================================================
-void Clock_InitPll(PLL_ClockFreq target);                                         // set SYSCLK using HSI->PLL
+void Clock_InitPll(PLL_ClockFreq target);                                         // SYSCLK = target MHz from HSI16 (solver below)
+uint32_t Clock_SetSysclk(uint32_t hz, Clock_Source src);                          // closest SYSCLK to hz: HSI16 / 2^k, HSE or PLL; returns it (0 = failed)
+uint8_t Clock_SolvePll(uint32_t targetHz, Clock_Source src, uint32_t pHz, uint32_t qHz, Clock_PllConfig *pCfg); // best M/N/R for targetHz, P/Q nearest pHz/qHz (0 = off); 1 = found
+uint32_t Clock_ApplyPll(const Clock_PllConfig *pCfg);                             // switch SYSCLK to a solved PLL; returns SYSCLK (0 = failed)
+uint8_t Clock_Restore(void);                                                      // re-apply the last setup (Stop mode wakes on HSI16)
 void Clock_EnableOutput(MCO_Select src, MCO_Div div);                             // route clock to MCO (PA8)
 uint32_t Clock_GetSysclkHz(void);                                                 // return SystemCoreClock
+uint8_t Clock_Subscribe(Clock_ChangeCallback cb);                                 // call cb around SYSCLK changes (1 = ok, 0 = registry full)
+void Clock_Unsubscribe(Clock_ChangeCallback cb);                                  // stop calling cb
 
 #endif                                                                            // include guard end
@@ -0,0 +1,97 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  DDS (direct digital synthesis on a PWM carrier)
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   dds.h
+//  Version History
+//    Created for sub-Hz sine frequencies, sweeps and chirps without
+//    retuning PSC/ARR
+//
+//  The PWM carrier stays fixed (it is the sample rate). Every sample
+//  a 32-bit phase accumulator advances by inc, and the top bits pick
+//  a sine value from a quarter-wave table:
+//     f_out = inc * f_sample / 2^32
+//  40 kHz carrier -> 9.3 uHz per step of inc, so 0.01 Hz steps are
+//  exact to well below 1 ppm of the carrier.
+//
+//  The table is built by the compiler (constant expressions in the
+//  initializer), nothing runs at start-up and no float code is linked.
+//
+//  Two ways to feed CCRx:
+//   - ISR: call Dds_Tick from TIMx_IRQHandler with UIE enabled (works
+//     on TIM14 too). Dds_Init does the timer side.
+//       void TIM14_IRQHandler(void) { Dds_Tick(&s_osc); }
+//   - DMA: let the wave module stream a buffer and refill each half
+//     with Dds_Fill from its half callback (no interrupt per sample).
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef DDS_LIB_H
+#define DDS_LIB_H
+
+#include "stm32g031xx.h"
+#include "Timer.h"
+#include <stdint.h>
+
+// One oscillator (keep it static; the ISR works on it)
+typedef struct
+{
+    volatile uint32_t phase;     // accumulator, 2^32 = one period
+    volatile uint32_t inc;       // phase step per sample
+    volatile int64_t sweep;      // added to incQ24 every sample (0 = fixed)
+    uint64_t incQ24;             // inc with 24 fraction bits while sweeping
+                                 // (both 64-bit: set with interrupts off)
+    uint32_t sweepFrom;          // inc at the start of the sweep
+    uint32_t sweepTo;            // inc at the end of the sweep
+    uint8_t sweepRepeat;         // 1 = jump back to sweepFrom (chirp train)
+    uint32_t mid;                // CCR for 0 (half of ARR + 1)
+    uint32_t amp;                // CCR swing for full scale
+    uint64_t rate_mHz;           // sample rate (PWM frequency)
+    TIM_TypeDef *pTimer;
+    volatile uint32_t *pCCR;
+} Dds_Osc;
+
+/**
+ * @brief Attach an oscillator to a running PWM channel
+ *        The sample rate is worked out from PSC/ARR and SYSCLK, the
+ *        level starts at full swing and the frequency at 0 Hz
+ * @param useIrq 1 = enable the update interrupt for Dds_Tick,
+ *               0 = samples come from Dds_Fill (DMA)
+ */
+void Dds_Init(Dds_Osc *pOsc, TIM_TypeDef *pTimer, Timer_Channel channel, uint8_t useIrq);
+
+/**
+ * @brief Output frequency in 0.01 Hz (44000 = 440.00 Hz), up to half
+ *        the sample rate. Phase continuous (no click).
+ */
+void Dds_SetFrequency(Dds_Osc *pOsc, uint32_t freq_cHz);
+
+/**
+ * @brief Peak level, 0..65535 = 0..100 % of the PWM range
+ */
+void Dds_SetLevel(Dds_Osc *pOsc, uint16_t level);
+
+/**
+ * @brief Linear sweep from -> to over duration_ms, then hold 'to'
+ *        (repeat = 1: start over, a chirp train)
+ */
+void Dds_Sweep(Dds_Osc *pOsc, uint32_t from_cHz, uint32_t to_cHz,
+               uint32_t duration_ms, uint8_t repeat);
+
+/**
+ * @brief One sample into CCRx, clears UIF. Call from TIMx_IRQHandler.
+ */
+void Dds_Tick(Dds_Osc *pOsc);
+
+/**
+ * @brief count samples into a buffer (wave module half callback)
+ */
+void Dds_Fill(Dds_Osc *pOsc, uint16_t *pBuf, uint16_t count);
+
+/**
+ * @brief sin(phase * 2pi / 2^32) in Q15 (-32767..32767)
+ */
+int32_t Dds_Sine(uint32_t phase);
+
+#endif // DDS_LIB_H
@@ -0,0 +1,142 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  DEBOUNCE (sampled button debounce, long press and auto-repeat)
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   debounce.h
+//  Version History
+//    Created to replace the Delay(200000u) after every switch edge
+//    (ICA07 Part E, Practice for Exam 3), which froze the PWM updates
+//    and everything else for the length of the bounce
+//
+//  A tick (1 ms from a wheel timer, or Debounce_Tick from your own
+//  interrupt) reads the whole IDR of each port added and runs it
+//  through a 2-bit vertical counter: bit n of cnt0 / cnt1 is the
+//  counter of pin n, so all 16 pins count with a few logic ops:
+//
+//     delta  = sample ^ state         pins that differ from the state
+//     cnt1   = (cnt1 ^ cnt0) & delta  count up while they differ,
+//     cnt0   = ~cnt0 & delta          back to 0 when they agree
+//     toggle = delta & ~(cnt0 | cnt1) wrapped: 4 samples in a row
+//     state ^= toggle
+//
+//  A pin changes state after _DEBOUNCE_SAMPLES (4) equal samples:
+//  4 ms of quiet at the default tick. Nothing is done per button
+//  unless its state changed or it is being held, so an idle tick
+//  costs the same for 3 buttons or 48.
+//
+//  Events go into one queue (lock-free, the tick writes, the loop
+//  reads, like the EXTI queue):
+//     DEBOUNCE_PRESS    debounced press
+//     DEBOUNCE_LONG     still held after _DEBOUNCE_LONG_MS (once)
+//     DEBOUNCE_REPEAT   every _DEBOUNCE_REPEAT_MS after the long
+//                       press, pins in the port's repeat mask only
+//     DEBOUNCE_RELEASE  with how long it was held
+//  Pins already pressed when their port is added report nothing
+//  until they are released.
+//
+//  Usage (ICA07 Part E, switches to ground on PA10 and PB0):
+//     Timebase_Init(); Wheel_Init();
+//     Debounce_Init();
+//     Debounce_AddPort(GPIOA, 1 << 10, 1 << 10, 0);      // active low
+//     Debounce_AddPort(GPIOB, 1 << 0, 1 << 0, 1 << 0);   // repeats
+//     Debounce_Start();                                  // 1 ms wheel timer
+//     ...
+//     Debounce_Event ev;
+//     while (Debounce_Read(&ev))
+//         if (ev.pPort == GPIOB && ev.type != DEBOUNCE_RELEASE)
+//             duty++;                                    // held: keeps going
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef DEBOUNCE_LIB_H
+#define DEBOUNCE_LIB_H
+
+#include "stm32g031xx.h"
+#include <stdint.h>
+
+// Ports that can be added
+#ifndef _DEBOUNCE_PORTS
+#define _DEBOUNCE_PORTS      2
+#endif
+
+// Events the queue can hold (power of 2, up to 128)
+#ifndef _DEBOUNCE_QUEUE_LEN
+#define _DEBOUNCE_QUEUE_LEN  16
+#endif
+
+// Sample period of Debounce_Start (the wheel tick is the finest)
+#ifndef _DEBOUNCE_TICK_MS
+#define _DEBOUNCE_TICK_MS    1u
+#endif
+
+// Held this long for DEBOUNCE_LONG, then repeats this often
+#ifndef _DEBOUNCE_LONG_MS
+#define _DEBOUNCE_LONG_MS    600u
+#endif
+#ifndef _DEBOUNCE_REPEAT_MS
+#define _DEBOUNCE_REPEAT_MS  100u
+#endif
+
+// Equal samples before a pin changes (fixed by the 2-bit counter)
+#define _DEBOUNCE_SAMPLES    4u
+
+typedef enum
+{
+    DEBOUNCE_PRESS = 0,
+    DEBOUNCE_LONG,
+    DEBOUNCE_REPEAT,
+    DEBOUNCE_RELEASE
+} Debounce_Type;
+
+typedef struct
+{
+    GPIO_TypeDef *pPort;
+    uint8_t pin;
+    uint8_t type;                // Debounce_Type
+    uint16_t heldMs;             // since the press (0 for PRESS), saturates
+} Debounce_Event;
+
+/**
+ * @brief Forget all ports and queued events (stops the wheel timer)
+ */
+void Debounce_Init(void);
+
+/**
+ * @brief Sample the pins in mask of pPort from the next tick on
+ * @param activeLow pins that read 0 when pressed
+ * @param repeat    pins that auto-repeat after the long press
+ * @return 1 if added (or the port updated), 0 if all ports are taken
+ */
+uint8_t Debounce_AddPort(GPIO_TypeDef *pPort, uint16_t mask, uint16_t activeLow, uint16_t repeat);
+
+/**
+ * @brief Sample every _DEBOUNCE_TICK_MS from a wheel timer
+ *        (Timebase_Init and Wheel_Init first)
+ */
+void Debounce_Start(void);
+void Debounce_Stop(void);
+
+/**
+ * @brief One sample of every port. Debounce_Start calls it; call it
+ *        yourself instead from a _DEBOUNCE_TICK_MS interrupt.
+ */
+void Debounce_Tick(void);
+
+/**
+ * @brief Oldest queued event (main loop only, one reader)
+ * @return 1 with *pEvent filled, 0 if nothing happened
+ */
+uint8_t Debounce_Read(Debounce_Event *pEvent);
+
+/**
+ * @brief Debounced pressed pins of pPort (chords, shift keys)
+ */
+uint16_t Debounce_Pressed(GPIO_TypeDef *pPort);
+
+/**
+ * @brief Events lost to a full queue since Debounce_Init
+ */
+uint32_t Debounce_Dropped(void);
+
+#endif // DEBOUNCE_LIB_H
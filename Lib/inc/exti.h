@@ -0,0 +1,108 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  EXTI (pin edge interrupts with a timestamped event queue)
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   exti.h
+//  Version History
+//    Created so the switches stop being polled every pass of the loop
+//    (Lab02 Process_Buttons, SWITCH_A / SWITCH_B in the Practice mains,
+//    ICA07 Part E): the loop only hears about a pin when it moved
+//
+//  Any of the 16 EXTI lines can be routed to one GPIO pin with that
+//  pin number (line 3 = PA3 or PB3 or PC3 ...), on the rising edge,
+//  the falling edge or both. Every edge becomes an event:
+//
+//     { timebase microseconds (low 32 bits), line, rising or falling }
+//
+//  stamped first thing in the interrupt, then handed to the line's
+//  callback (if any, in the interrupt) and put in one queue the loop
+//  drains with Exti_Read.
+//
+//  The queue takes no lock: the interrupts only move the tail, the
+//  reader only moves the head (free-running 8-bit counters like the
+//  scheduler's). The three EXTI vectors must share one NVIC priority
+//  (they do unless changed) so that there is only ever one writer.
+//  A full queue drops the new edge and counts it.
+//
+//  An edge the interrupt is too late to see on its own (rising and
+//  falling both pending: a bounce faster than the interrupt latency)
+//  is queued as a pair, ordered by the level the pin is at now.
+//
+//  EXTI owns EXTI0_1_IRQHandler, EXTI2_3_IRQHandler and
+//  EXTI4_15_IRQHandler (defined in exti.c). Timebase_Init first for
+//  the stamps; the pin mode (input, pull-up) is still set with gpio.h.
+//
+//  Usage (Lab02 buttons):
+//     Timebase_Init();
+//     _GPIO_SetPinMode(GPIOA, 10, _GPIO_PinMode_Input);
+//     Exti_Attach(GPIOA, 10, EXTI_EDGE_BOTH, 0);
+//     ...
+//     Exti_Event ev;
+//     while (Exti_Read(&ev))
+//         if (ev.line == 10 && !ev.rising)          // pressed (active low)
+//             ...
+//   or straight to a scheduler task:
+//     static void Sw(const Exti_Event *pEv) { Sched_Post(&s_tasks[0], pEv->line); }
+//     Exti_Attach(GPIOA, 10, EXTI_EDGE_FALLING, Sw);
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef EXTI_LIB_H
+#define EXTI_LIB_H
+
+#include "stm32g031xx.h"
+#include <stdint.h>
+
+// Edges the queue can hold (power of 2, up to 128)
+#ifndef _EXTI_QUEUE_LEN
+#define _EXTI_QUEUE_LEN  16
+#endif
+
+typedef enum
+{
+    EXTI_EDGE_RISING = 1,
+    EXTI_EDGE_FALLING = 2,
+    EXTI_EDGE_BOTH = 3
+} Exti_Edge;
+
+typedef struct
+{
+    uint32_t us;                 // Timebase_Micros32 at the interrupt
+    uint8_t line;                // pin number 0..15
+    uint8_t rising;              // 1 rising, 0 falling
+} Exti_Event;
+
+// Runs in the EXTI interrupt, before the edge is queued
+typedef void (*Exti_Callback)(const Exti_Event *pEvent);
+
+/**
+ * @brief Route pin of pPort to its EXTI line and interrupt on edge.
+ *        Takes the line over from another port if it had it.
+ * @param cb per-line callback, 0 for queue only
+ * @return 1 if set up, 0 (pin or port out of range)
+ */
+uint8_t Exti_Attach(GPIO_TypeDef *pPort, uint8_t pin, Exti_Edge edge, Exti_Callback cb);
+
+/**
+ * @brief Stop the line's interrupts (edges already queued stay)
+ */
+void Exti_Detach(uint8_t line);
+
+/**
+ * @brief Oldest queued edge (main loop only, one reader)
+ * @return 1 with *pEvent filled, 0 if nothing happened
+ */
+uint8_t Exti_Read(Exti_Event *pEvent);
+
+/**
+ * @brief Edges waiting in the queue
+ */
+uint8_t Exti_Pending(void);
+
+/**
+ * @brief Edges lost to a full queue since the start
+ */
+uint32_t Exti_Dropped(void);
+
+#endif // EXTI_LIB_H
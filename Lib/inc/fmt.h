@@ -0,0 +1,102 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  FORMAT LIBRARY (integer to text without printf)
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   fmt.h
+//  Version History
+//    Created to take sprintf off the USART / UI hot paths
+//
+//  The M0+ has no divide instruction and no FPU, so decimal digits
+//  are produced by subtracting powers of ten (no / or %), and
+//  engineering notation works on the digit string (no double).
+//
+//  Every function writes into the caller's buffer, NULL terminates
+//  it and returns the number of characters written (terminator not
+//  counted), so calls can be chained: p += Fmt_U32(p, ...);
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef FMT_LIB_H
+#define FMT_LIB_H
+
+#include <stdint.h>
+
+// =====================================================================
+// Worst case buffer sizes (including NULL)
+// =====================================================================
+#define _FMT_DEC32_SIZE   12    // "-2147483648"
+#define _FMT_DEC64_SIZE   21    // "18446744073709551615"
+#define _FMT_BIN64_SIZE   65
+#define _FMT_CURSOR_SIZE  11    // "\033[255;255H"
+
+/**
+ * @brief Unsigned 32-bit decimal, right aligned
+ * @param buf   Destination
+ * @param value Value to print
+ * @param width Minimum field width (0 = no padding)
+ * @param pad   Fill character, normally ' ' or '0'
+ * @return Characters written
+ */
+uint8_t Fmt_U32(char *buf, uint32_t value, uint8_t width, char pad);
+
+/**
+ * @brief Signed 32-bit decimal (with '0' pad the sign comes first)
+ */
+uint8_t Fmt_I32(char *buf, int32_t value, uint8_t width, char pad);
+
+/**
+ * @brief Unsigned 64-bit decimal, right aligned
+ */
+uint8_t Fmt_U64(char *buf, uint64_t value, uint8_t width, char pad);
+
+/**
+ * @brief Signed 64-bit decimal
+ */
+uint8_t Fmt_I64(char *buf, int64_t value, uint8_t width, char pad);
+
+/**
+ * @brief Upper-case hex, zero padded to digits (0 = no leading zeros)
+ * @param digits 0..8
+ */
+uint8_t Fmt_Hex32(char *buf, uint32_t value, uint8_t digits);
+
+/**
+ * @brief Upper-case hex, zero padded to digits (0 = no leading zeros)
+ * @param digits 0..16
+ */
+uint8_t Fmt_Hex64(char *buf, uint64_t value, uint8_t digits);
+
+/**
+ * @brief Binary, zero padded to digits (0 = no leading zeros)
+ * @param digits 0..32
+ */
+uint8_t Fmt_Bin32(char *buf, uint32_t value, uint8_t digits);
+
+/**
+ * @brief Binary, zero padded to digits (0 = no leading zeros)
+ * @param digits 0..64
+ */
+uint8_t Fmt_Bin64(char *buf, uint64_t value, uint8_t digits);
+
+/**
+ * @brief Fixed point decimal: value is scaled by 10^fracDigits
+ *        e.g. Fmt_Fixed(buf, 1650, 3) -> "1.650"
+ * @param fracDigits 0..9
+ */
+uint8_t Fmt_Fixed(char *buf, int32_t value, uint8_t fracDigits);
+
+/**
+ * @brief Engineering notation with exponent a multiple of 3
+ *        e.g. Fmt_Engineering(buf, 1234567, 3) -> "1.235x10^6"
+ *        (rounded half up, same output as "%.3fx10^%d")
+ * @param fracDigits Digits after the point (0..9)
+ */
+uint8_t Fmt_Engineering(char *buf, uint64_t value, uint8_t fracDigits);
+
+/**
+ * @brief ANSI cursor position sequence ESC[row;colH
+ */
+uint8_t Fmt_Cursor(char *buf, uint8_t row, uint8_t col);
+
+#endif // FMT_LIB_H
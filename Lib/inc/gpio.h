@@ -47,7 +47,7 @@ void GPIO_Set(GPIO_TypeDef*, uint16_t);
 void GPIO_Clear(GPIO_TypeDef*, uint16_t);
 
 /**
- * @brief  Toggle bit in Port
+ * @brief  Toggle bit in Port (BSRR, other pins untouched)
  * @param  Port
  * @param  pin
  */
@@ -111,7 +111,7 @@ typedef enum
 void _GPIO_ClockEnable(GPIO_TypeDef *pPort);
 
 /**
- * @brief Toggle output pin
+ * @brief Toggle output pin (BSRR, other pins untouched)
  */
 void _GPIO_PinToggle(GPIO_TypeDef *pPort, int PinNumber);
 
@@ -140,6 +140,22 @@ int _GPIO_GetPinIState(GPIO_TypeDef *pPort, int PinNumber);
  */
 int _GPIO_GetPinOState(GPIO_TypeDef *pPort, int PinNumber);
 
+//======================================================================
+// Whole-Port Writes (interrupt safe: one BSRR store, no ODR write-back)
+//======================================================================
+
+/**
+ * @brief Flip every pin in mask; the other pins are never written
+ *        (an ISR flipping the same pin in between still races)
+ */
+void _GPIO_PortToggle(GPIO_TypeDef *pPort, uint16_t mask);
+
+/**
+ * @brief Pins in mask take their bit of value, all in the same cycle
+ *        (parallel bus / LED counter); pins outside mask untouched
+ */
+void _GPIO_PortWrite(GPIO_TypeDef *pPort, uint16_t mask, uint16_t value);
+
 //======================================================================
 // Advanced Functions (ICA08+)
 //======================================================================
@@ -174,4 +190,42 @@ void _GPIO_SetSpeed(GPIO_TypeDef *pPort, int PinNumber, _GPIO_Speed speed);
  */
 void _GPIO_SetPull(GPIO_TypeDef *pPort, int PinNumber, _GPIO_Pull pull);
 
+//======================================================================
+// Batched Configuration (whole board from one const table)
+//======================================================================
+
+// One pin of a board table. Fields that do not apply to the mode are
+// still written (e.g. an input's speed), so keep them at 0 when unused.
+typedef struct
+{
+    GPIO_TypeDef *pPort;
+    uint8_t pin;                 // 0..15
+    uint8_t mode;                // _GPIO_PinMode
+    uint8_t af;                  // 0..7 (alternate function mode)
+    uint8_t type;                // _GPIO_OutputType
+    uint8_t speed;               // _GPIO_Speed
+    uint8_t pull;                // _GPIO_Pull
+    uint8_t level;               // output level set before the pin turns into an output
+} _GPIO_PinConfig;
+
+/**
+ * @brief Configure every pin of a table: the entries are folded into one
+ *        mask / value per register per port, the port clocks enabled in
+ *        one IOPENR write, then each register is written once (MODER
+ *        last, so no pin drives before its level, type and AF are set).
+ *        A later entry for the same pin wins.
+ *
+ *   static const _GPIO_PinConfig s_board[] =
+ *   {
+ *       { GPIOC, 6, _GPIO_PinMode_Output, 0, 0, 0, 0, 0 },                 // status LED, off
+ *       { GPIOA, 4, _GPIO_PinMode_AlternateFunction, 4,
+ *         _GPIO_OutputType_PushPull, _GPIO_Speed_High, 0, 0 },             // TIM14_CH1
+ *       { GPIOA, 0, _GPIO_PinMode_Input, 0, 0, 0, _GPIO_Pull_Up, 0 },      // button
+ *   };
+ *   GPIO_ConfigureBatch(s_board, sizeof(s_board) / sizeof(s_board[0]));
+ *
+ * @return 1 if applied, 0 if an entry was invalid (nothing written)
+ */
+uint8_t GPIO_ConfigureBatch(const _GPIO_PinConfig *pTable, uint16_t count);
+
 #endif
\ No newline at end of file
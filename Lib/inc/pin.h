@@ -0,0 +1,139 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  PIN (compile-time GPIO pin descriptors)
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   pin.h
+//  Version History
+//    Created for bit-banging and scope timing markers (ICA06 Part B
+//    brackets every _USART_TxByte with PA4 set / clear), where the
+//    out-of-line GPIO_Set / _GPIO_PinSet calls and their 0..15 checks
+//    cost more than the edge itself
+//
+//  A descriptor is the port and the pin's bit mask, worked out by the
+//  compiler: the port is a letter (PIN_DESC(Q, 3) does not compile) and
+//  the pin number is checked with a static assert instead of at run
+//  time. With a constant descriptor every call below inlines to one
+//  store to BSRR or BRR (toggle: one ODR load, one BSRR store).
+//
+//  Kept header-only (static inline) like ringbuf.h: nothing to add to
+//  the .emProject files. Pin modes are still set up with gpio.h.
+//
+//  Usage:
+//     static const Pin_Desc s_marker = PIN_DESC_INIT(A, 4);
+//     Pin_High(s_marker);
+//     _USART_TxByte(USART2, c);
+//     Pin_Low(s_marker);
+//   or in place:
+//     Pin_Toggle(PIN_DESC(B, 3));
+//   a 4-bit LED counter on PB4..PB7, all four change together:
+//     static const Pin_Bus s_leds = PIN_BUS_INIT(B, 4, 4);
+//     Pin_BusWrite(s_leds, count);
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef PIN_LIB_H
+#define PIN_LIB_H
+
+#include "stm32g031xx.h"
+#include <stdint.h>
+
+typedef struct
+{
+    GPIO_TypeDef *pPort;
+    uint32_t mask;               // 1 << pin
+} Pin_Desc;
+
+// Bit mask of a pin number, a compile error unless it is 0..15
+#define PIN_MASK(n)  ((uint32_t)((1u << (n)) + 0u * sizeof(struct {                     \
+                         _Static_assert((n) >= 0 && (n) <= 15, "GPIO pin must be 0..15"); \
+                         char c; })))
+
+// Initializer (static const tables) and value (in place) forms
+#define PIN_DESC_INIT(port, n)  { GPIO##port, PIN_MASK(n) }
+#define PIN_DESC(port, n)       ((Pin_Desc)PIN_DESC_INIT(port, n))
+
+/**
+ * @brief Drive the pin high (BSRR set half)
+ */
+static inline void Pin_High(Pin_Desc pin)
+{
+    pin.pPort->BSRR = pin.mask;
+}
+
+/**
+ * @brief Drive the pin low (BRR)
+ */
+static inline void Pin_Low(Pin_Desc pin)
+{
+    pin.pPort->BRR = pin.mask;
+}
+
+/**
+ * @brief Drive the pin to level (0 / non-zero) in one BSRR store
+ */
+static inline void Pin_Write(Pin_Desc pin, uint8_t level)
+{
+    pin.pPort->BSRR = level ? pin.mask : pin.mask << 16;
+}
+
+/**
+ * @brief Flip the pin: reads ODR, writes only this pin through BSRR,
+ *        so the other pins of the port are never written back
+ */
+static inline void Pin_Toggle(Pin_Desc pin)
+{
+    uint32_t odr = pin.pPort->ODR;
+    pin.pPort->BSRR = ((odr & pin.mask) << 16) | (~odr & pin.mask);
+}
+
+/**
+ * @brief Input level (IDR), 0 or 1
+ */
+static inline uint8_t Pin_Read(Pin_Desc pin)
+{
+    return (pin.pPort->IDR & pin.mask) ? 1u : 0u;
+}
+
+/**
+ * @brief Level the pin is being driven to (ODR), 0 or 1
+ */
+static inline uint8_t Pin_Driven(Pin_Desc pin)
+{
+    return (pin.pPort->ODR & pin.mask) ? 1u : 0u;
+}
+
+// =====================================================================
+// Buses: adjacent pins written as one number
+// =====================================================================
+typedef struct
+{
+    GPIO_TypeDef *pPort;
+    uint32_t mask;               // the bus pins
+    uint8_t shift;               // lowest pin
+} Pin_Bus;
+
+// width pins from first up, all of them checked
+#define PIN_BUS_INIT(port, first, width)  \
+    { GPIO##port, PIN_MASK((first) + (width) - 1) * 2u - PIN_MASK(first), (first) }
+#define PIN_BUS(port, first, width)       ((Pin_Bus)PIN_BUS_INIT(port, first, width))
+
+/**
+ * @brief Put value on the bus: every bus pin set or reset by the same
+ *        BSRR store, pins outside the bus untouched
+ */
+static inline void Pin_BusWrite(Pin_Bus bus, uint32_t value)
+{
+    uint32_t bits = (value << bus.shift) & bus.mask;
+    bus.pPort->BSRR = ((bus.mask & ~bits) << 16) | bits;
+}
+
+/**
+ * @brief Bus input levels (IDR) as a number
+ */
+static inline uint32_t Pin_BusRead(Pin_Bus bus)
+{
+    return (bus.pPort->IDR & bus.mask) >> bus.shift;
+}
+
+#endif // PIN_LIB_H
@@ -0,0 +1,116 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  POWER (tickless idle: Sleep or Stop until the next deadline)
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   power.h
+//  Version History
+//    Created so idle boards stop burning full PLL current in
+//    while(1){} and Delay() spins
+//
+//  The next deadline is the timebase alarm (the timer wheel keeps it
+//  on its next due timer). With time to spare the core goes to Stop
+//  mode, all clocks but LSI (or LSE) off, and LPTIM1 counting on
+//  that clock wakes it a little before the deadline:
+//
+//     deadline - now  > latency + _POWER_MIN_STOP_US   -> Stop
+//     otherwise (Stop blocked, USART2 still sending)   -> Sleep (WFI)
+//
+//  On the way out of Stop:
+//   - SYSCLK is HSI16 again: Clock_Restore brings back the PLL (or
+//     HSE / HSI divider) it had before
+//   - TIM2 was frozen: the LPTIM ticks slept (calibrated against the
+//     timebase at Power_Init) move the time forward with
+//     Timebase_Resync. Both ends are stamped on an LPTIM edge, so
+//     the error is a few us per Stop, not a tick.
+//   - how late the wakeup came out (LPTIM compare to time restored)
+//     is the latency budget (worst recent one): the next Stop ends
+//     that much earlier, and the last stretch is a plain Sleep on
+//     the exact TIM2 alarm. Deadlines are kept to the microsecond,
+//     Stop only shortens the wait.
+//
+//  Stop freezes every other peripheral. USART2 transmit is checked
+//  here (TC, the TX ring's TXEIE, the TX DMA channel): Sleep until
+//  the last stop bit is out. Hold Power_Block while receiving (no
+//  wakeup from Stop on USART2), or while another DMA transfer or a
+//  PWM output must keep running. Buttons on EXTI lines still wake it.
+//
+//  Owns LPTIM1 and LPTIM1_IRQHandler.
+//
+//  Usage:
+//     Timebase_Init(); Wheel_Init();
+//     Power_Init();
+//     Sched_SetIdleHook(Power_Idle);        // scheduler idles through it
+//   or without the scheduler:
+//     while (1) { __disable_irq(); if (!work) Power_Idle(); __enable_irq(); ... }
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef POWER_LIB_H
+#define POWER_LIB_H
+
+#include "stm32g031xx.h"
+#include <stdint.h>
+
+// LPTIM1 clock: 0 = LSI (32 kHz, calibrated at init), 1 = LSE crystal
+#ifndef _POWER_USE_LSE
+#define _POWER_USE_LSE      0
+#endif
+
+// Stop 0 (faster wakeup) or Stop 1 (lower current)
+#ifndef _POWER_STOP_LPMS
+#define _POWER_STOP_LPMS    PWR_CR1_LPMS_0
+#endif
+
+// Shortest Stop worth the trip, on top of the wakeup latency
+#ifndef _POWER_MIN_STOP_US
+#define _POWER_MIN_STOP_US  1000u
+#endif
+
+// Wakeup latency assumed until one is measured
+#ifndef _POWER_WAKE_US
+#define _POWER_WAKE_US      100u
+#endif
+
+// LPTIM ticks counted against the timebase at init
+#ifndef _POWER_CAL_TICKS
+#define _POWER_CAL_TICKS    1024u
+#endif
+
+typedef struct
+{
+    uint32_t stops;              // Stop mode entries
+    uint32_t sleeps;             // plain WFI
+    uint64_t stopUs;             // time spent in Stop
+    uint32_t latencyUs;          // current wakeup budget
+} Power_Stats;
+
+/**
+ * @brief LPTIM1 on LSI/LSE, Stop mode setup, tick calibration
+ *        (Timebase_Init first; takes ~32 ms on LSI)
+ */
+void Power_Init(void);
+
+/**
+ * @brief Sleep until the next interrupt, in Stop if the next deadline
+ *        allows. Call with interrupts off, returns with them off.
+ */
+void Power_Idle(void);
+
+/**
+ * @brief Keep out of Stop (nests) / allow it again
+ */
+void Power_Block(void);
+void Power_Unblock(void);
+
+/**
+ * @brief Wakeup latency budget: how long before a deadline Stop ends
+ */
+uint32_t Power_GetWakeLatencyUs(void);
+
+/**
+ * @brief Stop / Sleep counts and time
+ */
+void Power_GetStats(Power_Stats *pStats);
+
+#endif // POWER_LIB_H
@@ -0,0 +1,109 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  PROFILER (SysTick cycle counts)
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   prof.h
+//  Version History
+//    Created to measure Lib hot paths (M0+ has no DWT->CYCCNT)
+//
+//  SysTick runs from HCLK, so one count = one CPU cycle.
+//
+//  Two ways to run it:
+//   - SysTick unused: Prof_Init starts it free running over 24 bits
+//     (no interrupt). Single measurements must stay below 2^24 cycles
+//     (~0.5 s at 32 MHz).
+//   - SysTick already used for millis(): call Prof_Init after the
+//     SysTick setup and pass the ms counter to Prof_SetTickCounter.
+//     Timestamps then combine ticks * (LOAD + 1) with VAL and can
+//     span up to 2^32 cycles. A wrap whose interrupt is still pending
+//     (IRQs masked, measuring inside a handler) is counted too.
+//
+//  Usage:
+//     static Prof_Scope s_cursor = PROF_SCOPE_INIT("SetCursor");
+//     Prof_Begin(&s_cursor);
+//     _USART_SetCursor(USART2, 5, 10);
+//     Prof_End(&s_cursor);
+//     ...
+//     Prof_Report(USART2);
+//
+//  Scopes can nest (up to _PROF_MAX_DEPTH). Time spent in inner
+//  scopes is also reported as "self" time of the outer scope.
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef PROF_LIB_H
+#define PROF_LIB_H
+
+#include "stm32g031xx.h"
+#include <stdint.h>
+
+#ifndef _PROF_MAX_DEPTH
+#define _PROF_MAX_DEPTH   8
+#endif
+
+// =====================================================================
+// One named measurement point (keep it static, it registers itself)
+// =====================================================================
+typedef struct Prof_Scope
+{
+    const char *name;
+    uint32_t count;              // completed Begin/End pairs
+    uint32_t min;                // cycles
+    uint32_t max;                // cycles
+    uint64_t total;              // cycles, inclusive of nested scopes
+    uint64_t child;              // cycles spent in nested scopes
+    uint32_t start;              // timestamp of the open Begin
+    struct Prof_Scope *parent;   // enclosing scope the first time it ran
+    struct Prof_Scope *next;     // registration list
+    uint8_t registered;
+} Prof_Scope;
+
+#define PROF_SCOPE_INIT(label)  { (label), 0, 0xFFFFFFFFu, 0, 0, 0, 0, 0, 0, 0 }
+
+/**
+ * @brief Start SysTick if needed and calibrate the Begin/End overhead.
+ *        Scopes that already ran stay registered (their cycles were
+ *        counted without the overhead taken out: Prof_Reset them).
+ */
+void Prof_Init(void);
+
+/**
+ * @brief Use an existing SysTick interrupt counter (e.g. g_ms) so
+ *        timestamps extend past one SysTick period
+ * @param pTicks Counter incremented by SysTick_Handler (NULL to detach)
+ */
+void Prof_SetTickCounter(volatile uint32_t *pTicks);
+
+/**
+ * @brief Current timestamp in CPU cycles (wraps, use Prof_Elapsed)
+ */
+uint32_t Prof_Now(void);
+
+/**
+ * @brief Cycles between two Prof_Now values
+ */
+uint32_t Prof_Elapsed(uint32_t start, uint32_t end);
+
+/**
+ * @brief Open a scope
+ */
+void Prof_Begin(Prof_Scope *pScope);
+
+/**
+ * @brief Close the scope opened last and record its cycles
+ */
+void Prof_End(Prof_Scope *pScope);
+
+/**
+ * @brief Zero the statistics of every registered scope
+ */
+void Prof_Reset(void);
+
+/**
+ * @brief Print name / count / min / avg / max / self per scope,
+ *        nested scopes indented under their parent
+ */
+void Prof_Report(USART_TypeDef *uart);
+
+#endif // PROF_LIB_H
@@ -0,0 +1,95 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  EVENT QUEUE (single producer / single consumer, typed slots)
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   queue.h
+//  Version History
+//    Created so exti.c and debounce.c share one event queue instead
+//    of two copies of the same head / tail code
+//
+//  ringbuf.h moves bytes; this moves whole structs (an event, a
+//  message). Same rules: lock-free as long as one context puts and
+//  one context gets, tail only written by the producer, head only by
+//  the consumer. The indices run free over 8 bits and are masked on
+//  use, so every slot is usable (no empty one to tell full from
+//  empty) and the length must be a power of two, at most 128.
+//
+//  QUEUE_DEFINE(name, type, len) declares the queue type `name` and
+//  its static inline functions name_Reserve / _Commit / _Get /
+//  _Count / _Flush; define one per module that needs it:
+//
+//     QUEUE_DEFINE(Exti_Queue, Exti_Event, _EXTI_QUEUE_LEN)
+//     static Exti_Queue s_queue;
+//
+//     // producer (an interrupt): fill the slot in place, then publish
+//     Exti_Event *pEv = Exti_Queue_Reserve(&s_queue);
+//     if (pEv) { *pEv = ev; Exti_Queue_Commit(&s_queue); }
+//
+//     // consumer (main loop)
+//     Exti_Event ev;
+//     while (Exti_Queue_Get(&s_queue, &ev)) { ... }
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef QUEUE_LIB_H
+#define QUEUE_LIB_H
+
+#include <stdint.h>
+
+#define QUEUE_DEFINE(name, type, len)                                               \
+    _Static_assert((len) >= 2 && (len) <= 128 && ((len) & ((len) - 1)) == 0,        \
+                   #name ": length must be a power of two, 2..128");                \
+                                                                                    \
+    typedef struct                                                                  \
+    {                                                                               \
+        type slot[len];                                                             \
+        volatile uint8_t head;       /* next read (consumer owned) */               \
+        volatile uint8_t tail;       /* next write (producer owned) */              \
+        volatile uint32_t dropped;   /* Reserve calls refused while full */         \
+    } name;                                                                         \
+                                                                                    \
+    /* Producer: the next free slot, or 0 (counted in dropped) when full */         \
+    static inline type *name##_Reserve(name *pQ)                                    \
+    {                                                                               \
+        uint8_t tail = pQ->tail;                                                    \
+                                                                                    \
+        if ((uint8_t)(tail - pQ->head) >= (len))                                    \
+        {                                                                           \
+            pQ->dropped++;                                                          \
+            return 0;                                                               \
+        }                                                                           \
+        return &pQ->slot[tail & ((len) - 1u)];                                      \
+    }                                                                               \
+                                                                                    \
+    /* Producer: publish the reserved slot, after it is written */                  \
+    static inline void name##_Commit(name *pQ)                                      \
+    {                                                                               \
+        pQ->tail = (uint8_t)(pQ->tail + 1u);                                        \
+    }                                                                               \
+                                                                                    \
+    /* Consumer: copy the oldest entry out, 1 if there was one */                   \
+    static inline uint8_t name##_Get(name *pQ, type *pOut)                          \
+    {                                                                               \
+        uint8_t head = pQ->head;                                                    \
+                                                                                    \
+        if (head == pQ->tail)                                                       \
+            return 0;                                                               \
+        *pOut = pQ->slot[head & ((len) - 1u)];                                      \
+        pQ->head = (uint8_t)(head + 1u);     /* slot handed back after the copy */  \
+        return 1;                                                                   \
+    }                                                                               \
+                                                                                    \
+    static inline uint8_t name##_Count(const name *pQ)                              \
+    {                                                                               \
+        return (uint8_t)(pQ->tail - pQ->head);                                      \
+    }                                                                               \
+                                                                                    \
+    /* Consumer: drop whatever is waiting and clear the dropped count */            \
+    static inline void name##_Flush(name *pQ)                                       \
+    {                                                                               \
+        pQ->head = pQ->tail;                                                        \
+        pQ->dropped = 0;                                                            \
+    }
+
+#endif // QUEUE_LIB_H
@@ -0,0 +1,106 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  RING BUFFER (single producer / single consumer)
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   ringbuf.h
+//  Version History
+//    Created for interrupt-driven USART2 (TX/RX queues)
+//
+//  Lock-free as long as exactly one context writes (Put) and exactly
+//  one context reads (Get), e.g. main loop -> ISR or ISR -> main loop.
+//  head is only written by the producer, tail only by the consumer.
+//
+//  Kept header-only (static inline) so every project that already
+//  lists usart.c picks it up without touching its .emProject file,
+//  and so the logic has no register access and builds on any host.
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef RINGBUF_LIB_H
+#define RINGBUF_LIB_H
+
+#include <stdint.h>
+
+// =====================================================================
+// Ring descriptor (size MUST be a power of two, max 32768)
+// =====================================================================
+typedef struct
+{
+    volatile uint8_t *pData;     // storage (volatile keeps data/index order)
+    uint16_t mask;               // size - 1
+    volatile uint16_t head;      // next write index (producer owned)
+    volatile uint16_t tail;      // next read index (consumer owned)
+    uint16_t highWater;          // max bytes ever queued (producer updated)
+} Ring_Buffer;
+
+/**
+ * @brief Attach storage to a ring and empty it
+ * @param pRing Ring descriptor
+ * @param pData Storage array
+ * @param size  Storage size in bytes (power of two)
+ */
+static inline void Ring_Init(Ring_Buffer *pRing, uint8_t *pData, uint16_t size)
+{
+    pRing->pData = pData;
+    pRing->mask = (uint16_t)(size - 1u);
+    pRing->head = 0;
+    pRing->tail = 0;
+    pRing->highWater = 0;
+}
+
+/**
+ * @brief Number of bytes currently queued
+ */
+static inline uint16_t Ring_Count(const Ring_Buffer *pRing)
+{
+    return (uint16_t)((pRing->head - pRing->tail) & pRing->mask);
+}
+
+/**
+ * @brief Free space (one slot is kept empty to tell full from empty)
+ */
+static inline uint16_t Ring_Free(const Ring_Buffer *pRing)
+{
+    return (uint16_t)(pRing->mask - Ring_Count(pRing));
+}
+
+/**
+ * @brief Queue one byte (producer side)
+ * @return 1 if queued, 0 if the ring was full
+ */
+static inline uint8_t Ring_Put(Ring_Buffer *pRing, uint8_t data)
+{
+    uint16_t head = pRing->head;
+    uint16_t next = (uint16_t)((head + 1u) & pRing->mask);
+
+    if (next == pRing->tail)
+        return 0;                                   // full
+
+    pRing->pData[head] = data;                      // store before publishing
+    pRing->head = next;
+
+    uint16_t used = (uint16_t)((next - pRing->tail) & pRing->mask);
+    if (used > pRing->highWater)
+        pRing->highWater = used;
+
+    return 1;
+}
+
+/**
+ * @brief Take one byte (consumer side)
+ * @return 1 if a byte was read, 0 if the ring was empty
+ */
+static inline uint8_t Ring_Get(Ring_Buffer *pRing, uint8_t *pData)
+{
+    uint16_t tail = pRing->tail;
+
+    if (tail == pRing->head)
+        return 0;                                   // empty
+
+    *pData = pRing->pData[tail];                    // read before releasing
+    pRing->tail = (uint16_t)((tail + 1u) & pRing->mask);
+    return 1;
+}
+
+#endif // RINGBUF_LIB_H
@@ -0,0 +1,128 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  SCHED (cooperative run-to-completion scheduler)
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   sched.h
+//  Version History
+//    Created to replace the poll-everything superloops (Lab02 main,
+//    ICA07 / Practice Delay() spins) with tasks that only run when
+//    there is something for them to do
+//
+//  A task is a handler plus a small event queue. Interrupts, timer
+//  wheel callbacks and other tasks post events; the scheduler runs
+//  the most urgent task that has one, one event per call, to
+//  completion (no preemption, no per-task stack). Equal priorities
+//  take turns. With nothing queued the core sleeps in __WFI until the
+//  next interrupt.
+//
+//  Each task counts its runs, the longest and the total run time
+//  (timebase microseconds), and events dropped on a full queue. The
+//  time spent asleep gives the CPU load.
+//
+//  Porting a superloop (Lab02):
+//     enum { EV_KEY = 1, EV_SECOND, EV_BUTTONS };
+//     static void Ui(Sched_Task *pTask, uint32_t ev)
+//     {
+//         if (ev == EV_SECOND)  Uptime_Update();
+//         else if (ev >= 256)   Process_KeyPress((char)(ev - 256));
+//         else                  Process_Buttons();
+//     }
+//     static Sched_Task s_tasks[] = { SCHED_TASK_INIT("ui", Ui, 1) };
+//     static Wheel_Timer s_second, s_scan;
+//     static void Post(void *pArg) { Sched_Post(&s_tasks[0], (uint32_t)(uintptr_t)pArg); }
+//     static void Rx(uint16_t n) { ... Sched_Post(&s_tasks[0], 256 + byte) ... }
+//
+//     Timebase_Init(); Wheel_Init();
+//     Sched_Init(s_tasks, 1);
+//     Wheel_Arm(&s_second, 1000, 1000, Post, (void *)EV_SECOND);
+//     Wheel_Arm(&s_scan, 10, 10, Post, (void *)EV_BUTTONS);
+//     _USART_SetRxIdleCallback(Rx);
+//     Sched_Run();                                  // never returns
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef SCHED_LIB_H
+#define SCHED_LIB_H
+
+#include "stm32g031xx.h"
+#include <stdint.h>
+
+// Priority levels, 0 = most urgent
+#ifndef _SCHED_PRIORITIES
+#define _SCHED_PRIORITIES  4
+#endif
+
+// Events a task can hold (power of 2)
+#ifndef _SCHED_QUEUE_LEN
+#define _SCHED_QUEUE_LEN   8
+#endif
+
+typedef struct Sched_Task Sched_Task;
+
+// One event, run to completion
+typedef void (*Sched_Handler)(Sched_Task *pTask, uint32_t event);
+
+// Called instead of __WFI when nothing is queued, interrupts off;
+// return with them still off (the tickless idle goes here)
+typedef void (*Sched_IdleHook)(void);
+
+struct Sched_Task
+{
+    const char *name;
+    Sched_Handler handler;
+    uint8_t priority;
+    volatile uint8_t head;       // next event to run
+    volatile uint8_t tail;       // next free entry
+    uint32_t queue[_SCHED_QUEUE_LEN];
+    uint32_t runs;
+    uint32_t dropped;            // posts refused (queue full)
+    uint32_t maxUs;              // longest run
+    uint64_t totalUs;
+};
+
+#define SCHED_TASK_INIT(label, fn, prio)  { (label), (fn), (prio), 0, 0, {0}, 0, 0, 0, 0 }
+
+/**
+ * @brief Take a static task table (order = turn order within a priority)
+ */
+void Sched_Init(Sched_Task *pTasks, uint8_t count);
+
+/**
+ * @brief Queue an event (any context, ISR included)
+ * @return 1 if queued, 0 if the queue was full (counted in dropped)
+ */
+uint8_t Sched_Post(Sched_Task *pTask, uint32_t event);
+
+/**
+ * @brief Run one queued event, or sleep until an interrupt if none
+ * @return 1 if a task ran
+ */
+uint8_t Sched_RunOnce(void);
+
+/**
+ * @brief Sched_RunOnce forever
+ */
+void Sched_Run(void);
+
+/**
+ * @brief Replace __WFI in the idle path (NULL = plain __WFI)
+ */
+void Sched_SetIdleHook(Sched_IdleHook hook);
+
+/**
+ * @brief CPU load since the last Sched_ResetStats, 0..1000 (0.1 %)
+ */
+uint16_t Sched_GetLoad(void);
+
+/**
+ * @brief Zero the run-time statistics of every task and the load
+ */
+void Sched_ResetStats(void);
+
+/**
+ * @brief Task table with runs, max / avg / total us, drops and load
+ */
+void Sched_Report(USART_TypeDef *uart);
+
+#endif // SCHED_LIB_H
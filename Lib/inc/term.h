@@ -0,0 +1,88 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  TERMINAL RENDERER (shadow framebuffer over USART)
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   term.h
+//  Version History
+//    Created for Lab02 / Practice UI redraws
+//
+//  Draw into the back buffer with Term_PutStringXY / Term_PutCharXY
+//  (same col,row order and 1-based origin as _USART_TxStringXY), then
+//  call Term_Flush once per frame. Only cells that differ from what
+//  the terminal already shows (front buffer) are sent, joined into
+//  runs with the shortest cursor move in between.
+//
+//  Cells are single bytes: keep drawing to 7-bit ASCII (no UTF-8 box
+//  characters). The diff engine does not touch any register, so
+//  Term_FlushTo can be run on a host with a capturing writer.
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef TERM_LIB_H
+#define TERM_LIB_H
+
+#include "usart.h"
+#include <stdint.h>
+
+// =====================================================================
+// Tuning
+// =====================================================================
+#ifndef _TERM_GAP_MAX
+#define _TERM_GAP_MAX    4      // unchanged cells re-sent rather than skipped
+#endif
+
+#ifndef _TERM_STAGE_SIZE
+#define _TERM_STAGE_SIZE 64     // bytes collected before each writer call
+#endif
+
+/**
+ * @brief Output sink used by Term_FlushTo
+ * @param data Bytes to send (not NULL terminated)
+ * @param len  Number of bytes
+ */
+typedef void (*Term_Writer)(const char *data, uint16_t len);
+
+/**
+ * @brief Clear the terminal and both buffers
+ * @param uart USART used by Term_Flush (NULL for host / writer-only use)
+ */
+void Term_Init(USART_TypeDef *uart);
+
+/**
+ * @brief Fill the back buffer with spaces (nothing is sent)
+ */
+void Term_Clear(void);
+
+/**
+ * @brief Forget what the terminal shows; next flush clears and repaints
+ */
+void Term_Invalidate(void);
+
+/**
+ * @brief Write one character into the back buffer
+ * @param col Column (1.._USART_COLS)
+ * @param row Row (1.._USART_ROWS)
+ */
+void Term_PutCharXY(uint8_t col, uint8_t row, char c);
+
+/**
+ * @brief Write a string into the back buffer, clipped at the right edge
+ * @param col Column (1.._USART_COLS)
+ * @param row Row (1.._USART_ROWS)
+ */
+void Term_PutStringXY(uint8_t col, uint8_t row, const char *str);
+
+/**
+ * @brief Send the differences to the USART given to Term_Init
+ * @return Bytes sent for this frame
+ */
+uint16_t Term_Flush(void);
+
+/**
+ * @brief Send the differences through a caller supplied writer
+ * @return Bytes sent for this frame
+ */
+uint16_t Term_FlushTo(Term_Writer writer);
+
+#endif // TERM_LIB_H
@@ -0,0 +1,120 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  TIMEBASE (64-bit microsecond clock)
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   timebase.h
+//  Version History
+//    Created so every module reads one clock instead of its own
+//    (SysTick g_ms in the Practice mains, TIM14 for Timer14_Delay_us,
+//    TIM16 UIF polling for the Lab02 uptime)
+//
+//  TIM2 counts at 1 MHz over its full 32 bits (71.6 minutes a lap).
+//  The update interrupt counts laps in a 32-bit word, so
+//     time = laps : CNT   (64 bits of microseconds, ~585000 years)
+//
+//  Reading needs no lock: laps, CNT, laps again, retry if the ISR
+//  ran in between. If the ISR is held off (IRQs masked, or a higher
+//  priority ISR is the caller) UIF is still pending, and a small CNT
+//  means the wrap already happened, so one lap is added by hand.
+//  Cost: three loads and a compare, plus the SR load.
+//
+//  Channel 1 of TIM2 is a one-shot alarm at an absolute CNT value
+//  (Timebase_SetAlarm), the hook the timer wheel sleeps on.
+//  TIM2 stops in Stop mode: the power manager measures the stop on
+//  LPTIM1 and puts the time right with Timebase_Resync.
+//
+//  Timebase owns TIM2 and its interrupt (TIM2_IRQHandler is defined
+//  in timebase.c): measure with the capture module on TIM3 instead.
+//
+//  Usage:
+//     Timebase_Init();
+//     uint64_t t0 = Timebase_Micros();
+//     ...
+//     uint32_t took = Timebase_Micros32() - (uint32_t)t0;   // wrap safe
+//     Timebase_DelayUs(250);
+//
+//  SYSCLK changes made with the clock lib are followed by themselves
+//  (it keeps counting from where it was).
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef TIMEBASE_LIB_H
+#define TIMEBASE_LIB_H
+
+#include "stm32g031xx.h"
+#include <stdint.h>
+
+// Counter rate
+#ifndef _TIMEBASE_HZ
+#define _TIMEBASE_HZ  1000000u
+#endif
+
+/**
+ * @brief Start TIM2 at _TIMEBASE_HZ with the lap interrupt.
+ *        Follows Clock_SetSysclk changes by itself (calling it
+ *        again after a clock change also works): the time carries on.
+ */
+void Timebase_Init(void);
+
+/**
+ * @brief Microseconds since the first Timebase_Init (64 bits, any context)
+ */
+uint64_t Timebase_Micros(void);
+
+/**
+ * @brief Low 32 bits only (one load): intervals up to 71 minutes,
+ *        subtract as uint32_t
+ */
+static inline uint32_t Timebase_Micros32(void)
+{
+    return TIM2->CNT;
+}
+
+/**
+ * @brief Microseconds since a Timebase_Micros32 stamp
+ */
+static inline uint32_t Timebase_Since(uint32_t stamp)
+{
+    return TIM2->CNT - stamp;
+}
+
+// Runs in TIM2_IRQHandler when the alarm time is reached
+typedef void (*Timebase_AlarmCallback)(void);
+
+/**
+ * @brief One-shot alarm when the low 32 bits of the time reach atUs
+ *        (compare on TIM2 CH1). A time already passed (up to half a
+ *        lap back) fires at once. Replaces the previous alarm.
+ */
+void Timebase_SetAlarm(uint32_t atUs, Timebase_AlarmCallback cb);
+
+/**
+ * @brief Drop the pending alarm
+ */
+void Timebase_CancelAlarm(void);
+
+/**
+ * @brief Pending alarm time, if any
+ * @return 1 and *pAtUs set while an alarm is armed, else 0
+ */
+uint8_t Timebase_GetAlarm(uint32_t *pAtUs);
+
+/**
+ * @brief Move the time forward to nowUs (low word) after TIM2 was
+ *        held (Stop mode). Carries into the laps, fires an alarm
+ *        that was jumped over. Never goes back.
+ */
+void Timebase_Resync(uint32_t nowUs);
+
+/**
+ * @brief Milliseconds since start (64-bit / 1000, not for hot paths)
+ */
+uint64_t Timebase_Millis(void);
+
+/**
+ * @brief Busy wait, wrap safe, up to 2^32 - 1 us
+ */
+void Timebase_DelayUs(uint32_t us);
+
+#endif // TIMEBASE_LIB_H
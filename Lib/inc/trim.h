@@ -0,0 +1,135 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  TRIM (HSI16 auto-trim against a reference clock)
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   trim.h
+//  Version History
+//    Created to replace the hard-coded HSITRIM guess in the ICA08
+//    mains (RCC->ICSCR |= 63 << 8) with a measured one, so baud rate
+//    and PWM frequency are right on every board without a crystal
+//
+//  The reference drives TI1 of TIM16 or TIM17 through TISEL, the
+//  timer counts SYSCLK and captures every 8th reference edge:
+//
+//     error = (ticks counted - ticks expected) / ticks expected
+//
+//  over _TRIM_CAPTURES captures (256 reference periods by default:
+//  7.8 ms and ~2 ppm of resolution at 64 MHz on LSE). SYSCLK must
+//  come from HSI16 (directly or through the PLL) for there to be
+//  anything to trim.
+//
+//  References:
+//     TRIM_REF_LSE  TIM16, 32.768 kHz crystal         (best)
+//     TRIM_REF_LSI  TIM16, 32 kHz RC: only as good as the LSI itself
+//                   (a few %), catches a badly trimmed part at most
+//     TRIM_REF_HSE  TIM17, HSE / 32 (_CLOCK_HSE_HZ). A Clock_SetSysclk
+//                   on HSI16 stops HSE again: Trim_Init after it.
+//     TRIM_REF_PIN  TIM16_CH1 pin, any known edge rate from
+//                   SYSCLK * 8 / 65536 up (2 kHz at 16 MHz, 7.8 kHz
+//                   at 64 MHz): a 10 MHz GPSDO divided down to 10 kHz,
+//                   a function generator, another board's MCO
+//                   PA6 AF5 / PB8 AF2 / PD0 AF2, set with the gpio lib
+//
+//  Trim_Calibrate binary searches HSITRIM (0..127, higher = faster)
+//  for the zero crossing of the error, then keeps whichever of the two
+//  codes around it is closer: 9 measurements, under 0.1 s on LSE.
+//
+//  Tracking re-measures every periodMs from a wheel timer, interrupt
+//  driven, and moves the trim one code when the error grows past half
+//  a step (temperature drift). The timer belongs to this module while
+//  tracking: call Trim_IRQHandler from its interrupt handler.
+//
+//  Usage:
+//     Timebase_Init(); Wheel_Init();                // tracking only
+//     Clock_SetSysclk(64000000, CLOCK_SRC_HSI16);
+//     if (Trim_Init(TRIM_REF_LSE, 0))
+//         Trim_Calibrate(&status);                  // instead of ICSCR |= 63 << 8
+//     _USART_Init_USART2(64000000, 115200);
+//     Trim_StartTracking(10000);                    // every 10 s
+//     void TIM16_IRQHandler(void) { Trim_IRQHandler(); }
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef TRIM_LIB_H
+#define TRIM_LIB_H
+
+#include "stm32g031xx.h"
+#include <stdint.h>
+
+// Captures per measurement (8 reference edges each)
+#ifndef _TRIM_CAPTURES
+#define _TRIM_CAPTURES     32u
+#endif
+
+// Polls for one capture before the reference counts as gone
+#ifndef _TRIM_POLLS
+#define _TRIM_POLLS        200000u
+#endif
+
+// Windows tried before a measurement fails (a long interrupt can
+// cost one a capture)
+#ifndef _TRIM_TRIES
+#define _TRIM_TRIES        3u
+#endif
+
+// LSE start-up polls (a crystal can take a second or more)
+#ifndef _TRIM_LSE_POLLS
+#define _TRIM_LSE_POLLS    2000000u
+#endif
+
+typedef enum
+{
+    TRIM_REF_LSE = 0,
+    TRIM_REF_LSI,
+    TRIM_REF_HSE,
+    TRIM_REF_PIN
+} Trim_Ref;
+
+typedef struct
+{
+    uint8_t trim;                // HSITRIM now
+    int32_t errorPpm;            // last measured HSI16 error (+ = fast)
+    int32_t stepPpm;             // one HSITRIM code, from the last calibration
+    uint32_t adjusts;            // codes moved by tracking
+} Trim_Status;
+
+/**
+ * @brief Start the reference and set up its timer for capture
+ * @param pinHz edge rate on TIM16_CH1 for TRIM_REF_PIN (unused otherwise)
+ * @return 1 if the reference is running, 0 if it did not start or
+ *         is too slow for SYSCLK (8 periods over 65536 ticks)
+ */
+uint8_t Trim_Init(Trim_Ref ref, uint32_t pinHz);
+
+/**
+ * @brief One blocking measurement of the HSI16 error at the current trim
+ * @return 1 with *pPpm set, 0 (no reference, SYSCLK not on HSI16 or
+ *         too fast for the reference, busy)
+ */
+uint8_t Trim_Measure(int32_t *pPpm);
+
+/**
+ * @brief Search HSITRIM for the smallest error and keep it (blocking)
+ * @return 1 if trimmed, 0 if a measurement failed (trim left as it was)
+ */
+uint8_t Trim_Calibrate(Trim_Status *pStatus);
+
+/**
+ * @brief Re-measure every periodMs and nudge the trim (Trim_Calibrate first)
+ * @return 1 if started
+ */
+uint8_t Trim_StartTracking(uint32_t periodMs);
+void Trim_StopTracking(void);
+
+/**
+ * @brief Call from TIM16_IRQHandler (TIM17_IRQHandler for TRIM_REF_HSE)
+ */
+void Trim_IRQHandler(void);
+
+/**
+ * @brief Trim, last error, step size and tracking moves
+ */
+void Trim_GetStatus(Trim_Status *pStatus);
+
+#endif // TRIM_LIB_H
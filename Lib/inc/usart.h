@@ -10,11 +10,79 @@
 #define _USART_ROWS  24
 #define _USART_COLS  80
 
+// ======================================================
+// BUFFERED (INTERRUPT-DRIVEN) MODE FOR USART2
+// usart.c is compiled on its own, so these are project-level
+// settings: add _USART_BUFFERED=0 to the project's preprocessor
+// definitions (-D_USART_BUFFERED=0) to keep the original polled
+// behaviour on every call. Buffer sizes must be powers of two.
+// With interrupts masked or inside a handler, a full TX ring is
+// drained by polling TXE instead of waiting on the TX interrupt.
+// ======================================================
+#ifndef _USART_BUFFERED
+#define _USART_BUFFERED      1
+#endif
+
+#ifndef _USART_TX_BUFFSIZE
+#define _USART_TX_BUFFSIZE   256
+#endif
+
+#ifndef _USART_RX_BUFFSIZE
+#define _USART_RX_BUFFSIZE   64
+#endif
+
+// ======================================================
+// DMA TRANSMIT FOR USART2 (DMA1 Channel 2, DMAMUX request 53)
+// Two segments: the CPU fills one while DMA drains the other.
+// ======================================================
+#ifndef _USART_DMA_SEGSIZE
+#define _USART_DMA_SEGSIZE   256
+#endif
+
+#define _USART_DMAREQ_USART2_TX  53
+
+typedef void (*_USART_TxDoneCallback)(void);      // runs in DMA IRQ when TX goes idle
+
+// ======================================================
+// DMA CIRCULAR RECEIVE FOR USART2 (DMA1 Channel 3, request 52)
+// DMA fills the ring on its own; IDLE line / half / full
+// transfer interrupts report how much is waiting. Size the
+// ring for the largest burst between two consumes: past it the
+// oldest bytes are overwritten and counted in rxDropped.
+// ======================================================
+#ifndef _USART_DMA_RXSIZE
+#define _USART_DMA_RXSIZE    256
+#endif
+
+#define _USART_DMAREQ_USART2_RX  52
+
+typedef void (*_USART_RxIdleCallback)(uint16_t available);   // runs in IRQ after a burst
+
+// ======================================================
+// SYSCLK CHANGES
+// USART2 subscribes to the clock lib at init: around a
+// Clock_SetSysclk the TX side is paused, the shifter drained
+// (at most this many TC polls) and BRR recomputed for the
+// same baud at the new clock.
+// ======================================================
+#ifndef _USART_DRAIN_POLLS
+#define _USART_DRAIN_POLLS   20000u
+#endif
+
+typedef struct
+{
+    uint16_t txHighWater;   // most bytes ever waiting in TX ring
+    uint16_t rxHighWater;   // most bytes ever waiting in RX ring
+    uint32_t rxDropped;     // bytes lost because RX ring was full
+    uint32_t rxOverruns;    // hardware ORE events (RDR not read in time)
+} _USART_Stats;
+
 // ======================================================
 // FUNCTION PROTOTYPES
 // ======================================================
 
-// Initialize USART2
+// Initialize USART2 (starts buffered mode when _USART_BUFFERED,
+// keeps the baud through SYSCLK changes)
 void _USART_Init_USART2(uint32_t sysclk, uint32_t baud);
 
 // Transmit
@@ -30,4 +98,35 @@ void _USART_ClearScreen(USART_TypeDef *uart);
 void _USART_SetCursor(USART_TypeDef *uart, uint8_t row, uint8_t col);
 void _USART_TxStringXY(USART_TypeDef *uart, uint8_t col, uint8_t row, const char *str);
 
+// Buffered mode (USART2 only)
+void _USART_EnableBuffered(void);                  // switch USART2 to IRQ + rings
+void _USART_DisableBuffered(void);                 // drain TX, back to polling
+uint8_t _USART_TxByteNB(USART_TypeDef *uart, char c); // 1 = queued, 0 = ring full
+uint16_t _USART_TxStringNB(USART_TypeDef *uart, const char *str); // returns bytes queued
+uint16_t _USART_TxFree(void);                      // free bytes in TX ring
+void _USART_GetStats(_USART_Stats *stats);
+void _USART_ClearStats(void);
+void USART2_IRQHandler(void);
+
+// Wait until every queued byte (ring or DMA) has left the shifter
+void _USART_TxFlush(USART_TypeDef *uart);
+
+// DMA transmit (USART2 only, takes over from the TX ring)
+void _USART_EnableTxDMA(void);
+void _USART_DisableTxDMA(void);
+uint16_t _USART_TxDMA(const char *data, uint16_t len);       // copy + send, waits only when both segments are full
+uint8_t _USART_TxDMAZeroCopy(const void *data, uint16_t len); // send caller memory, keep it valid until done; 0 = busy
+uint8_t _USART_TxDMABusy(void);
+void _USART_SetTxDoneCallback(_USART_TxDoneCallback cb);
+void DMA1_Channel2_3_IRQHandler(void);
+
+// DMA circular receive (USART2 only, takes over from the RX ring)
+void _USART_EnableRxDMA(void);
+void _USART_DisableRxDMA(void);
+// (the RX ring instead while DMA receive is off)
+uint16_t _USART_RxAvailable(void);                 // bytes waiting (may wrap, at most the ring)
+uint16_t _USART_RxPeek(const uint8_t **span);      // contiguous bytes at *span, no copy
+void _USART_RxConsume(uint16_t n);                 // release n bytes after a peek
+void _USART_SetRxIdleCallback(_USART_RxIdleCallback cb);
+
 #endif
@@ -0,0 +1,114 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  WAVE (DMA-streamed PWM-DAC)
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   wave.h
+//  Version History
+//    Created to turn PWM + RC filter into an arbitrary waveform
+//    generator (ICA08 Part B budget DAC, Lab02 function generator)
+//
+//  DMA1 Channel 1 copies one sample from a table into CCRx on every
+//  timer update event, in circular mode, so the waveform costs no CPU
+//  per sample. The half- and full-transfer interrupts report which
+//  half of the table the DMA just finished, so that half can be
+//  refilled while the other one plays (double buffering).
+//
+//  Timers with an update DMA request: TIM1, TIM2, TIM3, TIM16, TIM17.
+//  TIM14 has none on the G0, so the ICA08 pin PA7 has to move from
+//  TIM14_CH1 (AF4) to TIM3_CH2 (AF1) for streaming.
+//
+//  Output frequency = PWM frequency / samples:
+//     PWM 40 kHz, 400 samples  -> 100 Hz sine
+//
+//  Usage:
+//     static uint16_t s_table[400];               // static: DMA reads it
+//     Timer_SetFrequency(TIM3, 40000000ull, TIMER_PWM_DEFAULT_PPM, 0);
+//     Timer_ConfigPWM(TIM3, TIMER_CHANNEL2, TIMER_PWM_MODE1);
+//     Timer_EnableOutput(TIM3, TIMER_CHANNEL2);
+//     Wave_Fill(s_table, 400, WAVE_SINE, Wave_Top(TIM3));
+//     Wave_Start(TIM3, TIMER_CHANNEL2, s_table, 400);
+//     Timer_Start(TIM3);
+//
+//  Samples are in timer counts (0..ARR+1): refill the table after a
+//  PSC/ARR change. The CCR preload set by Timer_ConfigPWM keeps every
+//  sample a full PWM period long.
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef WAVE_LIB_H
+#define WAVE_LIB_H
+
+#include "stm32g031xx.h"
+#include "Timer.h"
+#include <stdint.h>
+
+// DMAMUX request lines for the timer update events
+#define _WAVE_DMAREQ_TIM1_UP   25
+#define _WAVE_DMAREQ_TIM2_UP   31
+#define _WAVE_DMAREQ_TIM3_UP   37
+#define _WAVE_DMAREQ_TIM16_UP  46
+#define _WAVE_DMAREQ_TIM17_UP  49
+
+typedef enum
+{
+    WAVE_SINE = 0,
+    WAVE_TRIANGLE,
+    WAVE_SAW
+} Wave_Shape;
+
+// Runs in the DMA IRQ with the half the DMA has just finished reading
+typedef void (*Wave_HalfCallback)(uint16_t *pHalf, uint16_t count);
+
+/**
+ * @brief Largest sample for a timer (ARR + 1 = 100 % duty)
+ */
+uint32_t Wave_Top(TIM_TypeDef *pTimer);
+
+/**
+ * @brief Fill a table with one period of a standard shape
+ * @param pBuf  Sample table
+ * @param count Samples per period
+ * @param shape WAVE_SINE / WAVE_TRIANGLE / WAVE_SAW
+ * @param top   Full scale in timer counts (Wave_Top)
+ */
+void Wave_Fill(uint16_t *pBuf, uint16_t count, Wave_Shape shape, uint32_t top);
+
+/**
+ * @brief Resample a user shape (0..65535 = 0..100 %, any length)
+ *        into a table, linear interpolation, wraps from last to first
+ */
+void Wave_FillUser(uint16_t *pBuf, uint16_t count, const uint16_t *pShape,
+                   uint16_t len, uint32_t top);
+
+/**
+ * @brief Stream pBuf into CCRx of pTimer on every update event
+ * @return 1 if started, 0 if the timer has no update DMA request,
+ *         the channel doesn't exist or count < 2
+ * @note  Start the timer itself afterwards (or before, it doesn't
+ *        matter: the first update fetches pBuf[0])
+ */
+uint8_t Wave_Start(TIM_TypeDef *pTimer, Timer_Channel channel, uint16_t *pBuf, uint16_t count);
+
+/**
+ * @brief Stop streaming (the output keeps the last sample)
+ */
+void Wave_Stop(void);
+
+/**
+ * @brief 1 while the DMA is streaming
+ */
+uint8_t Wave_IsRunning(void);
+
+/**
+ * @brief Call cb after each half of the table has been played
+ *        (NULL to disable)
+ */
+void Wave_SetCallback(Wave_HalfCallback cb);
+
+/**
+ * @brief Full tables played since Wave_Start
+ */
+uint32_t Wave_GetCycles(void);
+
+#endif // WAVE_LIB_H
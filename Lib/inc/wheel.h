@@ -0,0 +1,94 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  WHEEL (software timers on the timebase alarm)
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   wheel.h
+//  Version History
+//    Created so periodic jobs stop costing a hardware timer each
+//    (TIM16 uptime tick) or a millis() - last poll in the main loop
+//
+//  Hierarchical timing wheel: 4 levels of 64 slots, each level 64
+//  times coarser than the one below (1 ms, 64 ms, 4.1 s, 4.4 min a
+//  slot at the default tick). A timer goes into the slot of the level
+//  its distance fits, so arming and cancelling are a list insert /
+//  unlink, whatever the number of timers. Every 64 ticks the next
+//  slot of the level above is poured down a level (cascade).
+//
+//  No periodic interrupt: the TIM2 CH1 alarm of the timebase is set
+//  for the next occupied slot, or the next cascade, whichever comes
+//  first. An idle wheel wakes once every 64 ticks.
+//
+//  Callbacks run in TIM2_IRQHandler: keep them short, set a flag or
+//  post an event for real work. They may arm and cancel timers
+//  (their own included).
+//
+//  Usage:
+//     static Wheel_Timer s_blink;
+//     static void Blink(void *pArg) { GPIO_Toggle(GPIOC, 6); }
+//     Timebase_Init();
+//     Wheel_Init();
+//     Wheel_Arm(&s_blink, 500, 500, Blink, 0);     // every 500 ms
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef WHEEL_LIB_H
+#define WHEEL_LIB_H
+
+#include "stm32g031xx.h"
+#include <stdint.h>
+
+// Length of one tick in timebase microseconds
+#ifndef _WHEEL_TICK_US
+#define _WHEEL_TICK_US  1000u
+#endif
+
+typedef void (*Wheel_Callback)(void *pArg);
+
+// One timer (keep it static: the wheel links it in place)
+typedef struct Wheel_Timer
+{
+    struct Wheel_Timer *next;
+    struct Wheel_Timer **pprev;  // link pointing at this one (0 = idle)
+    uint32_t expires;            // tick it is due
+    uint32_t period;             // ticks, 0 = one shot
+    uint16_t slot;               // slot it sits in
+    Wheel_Callback cb;
+    void *pArg;
+} Wheel_Timer;
+
+/**
+ * @brief Empty the wheel and start it at the current time
+ *        (Timebase_Init first)
+ */
+void Wheel_Init(void);
+
+/**
+ * @brief Arm (or re-arm) a timer
+ * @param delay  Ticks until the first call (0 = next tick)
+ * @param period Ticks between calls after that, 0 = one shot.
+ *               Periodic timers don't drift: each deadline is the
+ *               previous one + period.
+ */
+void Wheel_Arm(Wheel_Timer *pTimer, uint32_t delay, uint32_t period,
+               Wheel_Callback cb, void *pArg);
+
+/**
+ * @brief Stop a timer (nothing happens if it isn't armed)
+ */
+void Wheel_Cancel(Wheel_Timer *pTimer);
+
+/**
+ * @brief 1 while the timer is armed
+ */
+static inline uint8_t Wheel_IsArmed(const Wheel_Timer *pTimer)
+{
+    return pTimer->pprev ? 1 : 0;
+}
+
+/**
+ * @brief Current tick
+ */
+uint32_t Wheel_Now(void);
+
+#endif // WHEEL_LIB_H
@@ -0,0 +1,124 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  HOST SIMULATOR (register level)
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   sim.h
+//  Version History
+//    Created so Lib and the lab mains build and run on a PC
+//
+//  The peripheral blocks are mapped at their real addresses, so
+//  GPIOA, RCC, TIM14, USART2 ... from stm32g031xx.h are used as is.
+//  The pages are kept inaccessible: every register access traps into
+//  the simulator, which brings the models up to date before the
+//  access and applies the side effects (BSRR -> ODR, TDR -> stdout,
+//  PLLON -> PLLRDY, w1c flags ...) after it.
+//
+//  Modelled:
+//   - RCC     ready flags follow their ON bits, SWS follows SW,
+//             SYSCLK/HCLK/PCLK worked out from CFGR/PLLCFGR,
+//             HSI16 off by SIM_HSI_PPM and moved by HSITRIM
+//   - GPIO    BSRR/BRR -> ODR, IDR from ODR (outputs) and the
+//             levels set with Sim_SetPin (inputs, pulls otherwise)
+//   - TIM     1/2/3/14/16/17 up counting: PSC, ARR, CNT, UIF, CCxIF,
+//             UG, one pulse, rc_w0 status bits, trigger mode start
+//             from a master's counter enable (TRGO, MMS = 001),
+//             input capture from AF pins (CCxOF, CCxDE, DMAR burst),
+//             reset / trigger slave modes on TI1FP1 / TI2FP2,
+//             TISEL: TIM16 TI1 = LSI / LSE, TIM17 TI1 = HSE / 32
+//   - USART   1/2: TXE/TC, RXNE/IDLE, ICR, DMAR/DMAT.
+//             USART2 is wired to stdin/stdout (raw mode on a tty)
+//   - DMA1    channels 1..5 through DMAMUX, USART requests and
+//             timer update requests (TIM1/2/3/16/17 UDE)
+//   - LPTIM   1/2 continuous mode on PCLK / LSI / HSI16 / LSE: CNT,
+//             CMPM / ARRM, CMPOK / ARROK, ICR
+//   - Stop    WFI with SLEEPDEEP and LPMS = Stop 0/1 freezes all but
+//             the LPTIMs until an EXTI / LPTIM / RTC line; SYSCLK
+//             comes back on HSI16 with the PLL off
+//   - SysTick (PENDSTSET / PENDSTCLR in ICSR), NVIC enable/pending,
+//     EXTI edges, PRIMASK
+//
+//  Time comes from the host monotonic clock, scaled by the
+//  simulated clock tree, so delays and uptime run in real time.
+//  Interrupts are taken after a register access, in __WFI, and from
+//  a background tick (every _SIM_TICK_US) when PRIMASK is clear.
+//
+//  Environment:
+//   SIM_RUN_MS  stop the program after this many milliseconds
+//   SIM_HSI_PPM HSI16 error at the reset trim (64), e.g. 7000 for a
+//               part 0.7 % fast; each HSITRIM step adds _SIM_HSI_TRIM_PPM
+//
+//  Limits: DMA memory addresses must fit in 32 bits (link with
+//  -no-pie and keep DMA buffers static, not on the stack).
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef SIM_LIB_H
+#define SIM_LIB_H
+
+#include <stdint.h>
+
+#ifndef _SIM_TICK_US
+#define _SIM_TICK_US      100
+#endif
+
+#ifndef _SIM_HSE_HZ
+#define _SIM_HSE_HZ       8000000u
+#endif
+
+// HSI16 change per HSITRIM step
+#ifndef _SIM_HSI_TRIM_PPM
+#define _SIM_HSI_TRIM_PPM 3000
+#endif
+
+/**
+ * @brief Drive an input pin from outside (button, signal source)
+ * @param port  GPIOA .. GPIOF
+ * @param pin   0..15
+ * @param level 0 or 1
+ */
+void Sim_SetPin(GPIO_TypeDef *port, uint8_t pin, uint8_t level);
+
+/**
+ * @brief Square wave on an input pin, timed by the simulator so timer
+ *        captures see exact counts (period 0 stops it, up to 2 pins)
+ * @param periodNs Period in ns
+ * @param highNs   High time in ns (0 / >= period: constant level)
+ */
+void Sim_SetPinPwm(GPIO_TypeDef *port, uint8_t pin, uint32_t periodNs, uint32_t highNs);
+
+/**
+ * @brief Level on a pin (ODR for outputs, IDR otherwise)
+ */
+uint8_t Sim_GetPin(GPIO_TypeDef *port, uint8_t pin);
+
+/**
+ * @brief Queue bytes as if they arrived on the RX line
+ */
+void Sim_UsartFeed(USART_TypeDef *uart, const uint8_t *data, uint16_t len);
+
+/**
+ * @brief Send every transmitted byte to hook instead of stdout
+ *        (NULL restores stdout for USART2)
+ */
+typedef void (*Sim_TxHook)(USART_TypeDef *uart, uint8_t byte);
+void Sim_SetTxHook(Sim_TxHook hook);
+
+/**
+ * @brief Simulated clocks from the current RCC setup
+ */
+uint32_t Sim_GetSysclkHz(void);
+uint32_t Sim_GetHclkHz(void);
+uint32_t Sim_GetTimerClkHz(void);
+
+/**
+ * @brief Microseconds since the simulator started
+ */
+uint64_t Sim_Micros(void);
+
+/**
+ * @brief Bring every model up to date and take pending interrupts
+ */
+void Sim_Service(void);
+
+#endif // SIM_LIB_H
@@ -0,0 +1,81 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  HOST SIMULATOR - CMSIS compiler layer
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   sim_cmsis.h
+//  Version History
+//    Created for the host build (Lib/sim)
+//
+//  Stands in for cmsis_gcc.h when the firmware is built with the
+//  host gcc: same attribute macros, but the Cortex-M instructions
+//  (wfi, cpsid, dsb, ...) become calls into the simulator.
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef SIM_CMSIS_H
+#define SIM_CMSIS_H
+
+#include <stdint.h>
+
+#define __CMSIS_GCC_H                   // keep the real cmsis_gcc.h out
+
+#define __ASM                           __asm
+#define __INLINE                        inline
+#define __STATIC_INLINE                 static inline
+#define __STATIC_FORCEINLINE            __attribute__((always_inline)) static inline
+#define __NO_RETURN                     __attribute__((__noreturn__))
+#define __USED                          __attribute__((used))
+#define __WEAK                          __attribute__((weak))
+#define __PACKED                        __attribute__((packed, aligned(1)))
+#define __PACKED_STRUCT                 struct __attribute__((packed, aligned(1)))
+#define __PACKED_UNION                  union __attribute__((packed, aligned(1)))
+#define __ALIGNED(x)                    __attribute__((aligned(x)))
+#define __RESTRICT                      __restrict
+#define __COMPILER_BARRIER()            __ASM volatile("":::"memory")
+
+#define __UNALIGNED_UINT16_READ(addr)        (*(const uint16_t *)(const void *)(addr))
+#define __UNALIGNED_UINT16_WRITE(addr, val)  (void)(*(uint16_t *)(void *)(addr) = (val))
+#define __UNALIGNED_UINT32_READ(addr)        (*(const uint32_t *)(const void *)(addr))
+#define __UNALIGNED_UINT32_WRITE(addr, val)  (void)(*(uint32_t *)(void *)(addr) = (val))
+
+// =====================================================================
+// Core state kept by the simulator (sim.c)
+// =====================================================================
+void Sim_EnableIrq(void);
+void Sim_DisableIrq(void);
+uint32_t Sim_GetPrimask(void);
+uint32_t Sim_GetIpsr(void);
+void Sim_SetPrimask(uint32_t primask);
+void Sim_WaitForInterrupt(void);
+
+__STATIC_FORCEINLINE void __enable_irq(void)            { Sim_EnableIrq(); }
+__STATIC_FORCEINLINE void __disable_irq(void)           { Sim_DisableIrq(); }
+__STATIC_FORCEINLINE uint32_t __get_PRIMASK(void)       { return Sim_GetPrimask(); }
+__STATIC_FORCEINLINE void __set_PRIMASK(uint32_t pm)    { Sim_SetPrimask(pm); }
+__STATIC_FORCEINLINE uint32_t __get_IPSR(void)          { return Sim_GetIpsr(); }
+
+#define __NOP()                         __ASM volatile("nop")
+#define __WFI()                         Sim_WaitForInterrupt()
+#define __WFE()                         Sim_WaitForInterrupt()
+#define __SEV()                         ((void)0)
+#define __BKPT(value)                   __builtin_trap()
+
+__STATIC_FORCEINLINE void __ISB(void)                   { __COMPILER_BARRIER(); }
+__STATIC_FORCEINLINE void __DSB(void)                   { __COMPILER_BARRIER(); }
+__STATIC_FORCEINLINE void __DMB(void)                   { __COMPILER_BARRIER(); }
+
+__STATIC_FORCEINLINE uint32_t __REV(uint32_t value)     { return __builtin_bswap32(value); }
+__STATIC_FORCEINLINE uint32_t __REV16(uint32_t value)
+{
+    return ((value & 0x00FF00FFu) << 8) | ((value >> 8) & 0x00FF00FFu);
+}
+__STATIC_FORCEINLINE int16_t __REVSH(int16_t value)     { return (int16_t)__builtin_bswap16((uint16_t)value); }
+__STATIC_FORCEINLINE uint32_t __ROR(uint32_t op1, uint32_t op2)
+{
+    op2 %= 32u;
+    return op2 ? (op1 >> op2) | (op1 << (32u - op2)) : op1;
+}
+__STATIC_FORCEINLINE uint8_t __CLZ(uint32_t value)      { return value ? (uint8_t)__builtin_clz(value) : 32u; }
+
+#endif // SIM_CMSIS_H
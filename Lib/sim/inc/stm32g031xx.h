@@ -0,0 +1,21 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  HOST SIMULATOR - device header wrapper
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   stm32g031xx.h
+//
+//  Found first on the host include path: loads the host CMSIS layer,
+//  then the real device header (same register maps and addresses),
+//  then the simulator API.
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef SIM_STM32G031XX_H
+#define SIM_STM32G031XX_H
+
+#include "sim_cmsis.h"
+#include_next "stm32g031xx.h"
+#include "sim.h"
+
+#endif // SIM_STM32G031XX_H
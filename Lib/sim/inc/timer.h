@@ -0,0 +1,2 @@
+// SEGGER resolves "timer.h" to Timer.h on Windows; Linux is case sensitive
+#include "../../inc/Timer.h"
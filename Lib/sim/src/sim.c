@@ -0,0 +1,1869 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  HOST SIMULATOR
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   sim.c
+//
+//  Each peripheral region is one memfd mapped twice:
+//   - at the real address, PROT_NONE except while the firmware's own
+//     access is being single stepped
+//   - at an alias address that is always read/write; the models only
+//     ever touch registers through the alias (SIM_ALIAS)
+//
+//  Register access from firmware:
+//   SIGSEGV  update models, remember the old register value, open
+//            the region, set the trap flag so the CPU stops after
+//            the one instruction
+//   SIGTRAP  close the region, apply what the access did, take
+//            pending interrupts (ISRs trap the same way, nested)
+//
+//  SIGALRM is the background tick. It stays blocked between the two
+//  traps and is deferred while simulator state is being changed from
+//  the API (s_busy), so an ISR never sees a half open region.
+//
+//  x86-64 Linux only (REG_ERR / REG_EFL, trap flag).
+//
+/////////////////////////////////////////////////////////////////////////
+
+#define _GNU_SOURCE
+#include "stm32g031xx.h"
+#include <signal.h>
+#include <ucontext.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <termios.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// <termios.h> names its output delays CR0..CR3; the register names win
+#undef CR0
+#undef CR1
+#undef CR2
+#undef CR3
+
+#define SIM_EFLAGS_TF     0x100u
+#define SIM_PF_WRITE      0x2u
+#define SIM_RX_FIFO       256u
+#define SIM_NS            1000000000ull
+
+uint32_t SystemCoreClock = 16000000u;
+
+void SystemInit(void) { }
+void SystemCoreClockUpdate(void) { SystemCoreClock = Sim_GetHclkHz(); }
+
+// =====================================================================
+// Vector table (weak: unused handlers stay NULL)
+// =====================================================================
+typedef void (*Sim_Handler)(void);
+
+#define SIM_WEAK_HANDLER(name)  extern void name(void) __attribute__((weak));
+SIM_WEAK_HANDLER(SysTick_Handler)
+SIM_WEAK_HANDLER(WWDG_IRQHandler)
+SIM_WEAK_HANDLER(PVD_IRQHandler)
+SIM_WEAK_HANDLER(RTC_TAMP_IRQHandler)
+SIM_WEAK_HANDLER(FLASH_IRQHandler)
+SIM_WEAK_HANDLER(RCC_IRQHandler)
+SIM_WEAK_HANDLER(EXTI0_1_IRQHandler)
+SIM_WEAK_HANDLER(EXTI2_3_IRQHandler)
+SIM_WEAK_HANDLER(EXTI4_15_IRQHandler)
+SIM_WEAK_HANDLER(DMA1_Channel1_IRQHandler)
+SIM_WEAK_HANDLER(DMA1_Channel2_3_IRQHandler)
+SIM_WEAK_HANDLER(DMA1_Ch4_5_DMAMUX1_OVR_IRQHandler)
+SIM_WEAK_HANDLER(ADC1_IRQHandler)
+SIM_WEAK_HANDLER(TIM1_BRK_UP_TRG_COM_IRQHandler)
+SIM_WEAK_HANDLER(TIM1_CC_IRQHandler)
+SIM_WEAK_HANDLER(TIM2_IRQHandler)
+SIM_WEAK_HANDLER(TIM3_IRQHandler)
+SIM_WEAK_HANDLER(LPTIM1_IRQHandler)
+SIM_WEAK_HANDLER(LPTIM2_IRQHandler)
+SIM_WEAK_HANDLER(TIM14_IRQHandler)
+SIM_WEAK_HANDLER(TIM16_IRQHandler)
+SIM_WEAK_HANDLER(TIM17_IRQHandler)
+SIM_WEAK_HANDLER(I2C1_IRQHandler)
+SIM_WEAK_HANDLER(I2C2_IRQHandler)
+SIM_WEAK_HANDLER(SPI1_IRQHandler)
+SIM_WEAK_HANDLER(SPI2_IRQHandler)
+SIM_WEAK_HANDLER(USART1_IRQHandler)
+SIM_WEAK_HANDLER(USART2_IRQHandler)
+SIM_WEAK_HANDLER(LPUART1_IRQHandler)
+
+static Sim_Handler const s_vectors[32] =
+{
+    [WWDG_IRQn] = WWDG_IRQHandler,
+    [PVD_IRQn] = PVD_IRQHandler,
+    [RTC_TAMP_IRQn] = RTC_TAMP_IRQHandler,
+    [FLASH_IRQn] = FLASH_IRQHandler,
+    [RCC_IRQn] = RCC_IRQHandler,
+    [EXTI0_1_IRQn] = EXTI0_1_IRQHandler,
+    [EXTI2_3_IRQn] = EXTI2_3_IRQHandler,
+    [EXTI4_15_IRQn] = EXTI4_15_IRQHandler,
+    [DMA1_Channel1_IRQn] = DMA1_Channel1_IRQHandler,
+    [DMA1_Channel2_3_IRQn] = DMA1_Channel2_3_IRQHandler,
+    [DMA1_Ch4_5_DMAMUX1_OVR_IRQn] = DMA1_Ch4_5_DMAMUX1_OVR_IRQHandler,
+    [ADC1_IRQn] = ADC1_IRQHandler,
+    [TIM1_BRK_UP_TRG_COM_IRQn] = TIM1_BRK_UP_TRG_COM_IRQHandler,
+    [TIM1_CC_IRQn] = TIM1_CC_IRQHandler,
+    [TIM2_IRQn] = TIM2_IRQHandler,
+    [TIM3_IRQn] = TIM3_IRQHandler,
+    [LPTIM1_IRQn] = LPTIM1_IRQHandler,
+    [LPTIM2_IRQn] = LPTIM2_IRQHandler,
+    [TIM14_IRQn] = TIM14_IRQHandler,
+    [TIM16_IRQn] = TIM16_IRQHandler,
+    [TIM17_IRQn] = TIM17_IRQHandler,
+    [I2C1_IRQn] = I2C1_IRQHandler,
+    [I2C2_IRQn] = I2C2_IRQHandler,
+    [SPI1_IRQn] = SPI1_IRQHandler,
+    [SPI2_IRQn] = SPI2_IRQHandler,
+    [USART1_IRQn] = USART1_IRQHandler,
+    [USART2_IRQn] = USART2_IRQHandler,
+    [LPUART1_IRQn] = LPUART1_IRQHandler,
+};
+
+// =====================================================================
+// Memory regions
+// =====================================================================
+typedef struct
+{
+    uintptr_t base;
+    size_t size;
+    uint8_t *alias;
+} Sim_Region;
+
+static Sim_Region s_regions[] =
+{
+    { APBPERIPH_BASE, 0x16000u, 0 },    // TIM2 .. DBG
+    { AHBPERIPH_BASE, 0x4000u, 0 },     // DMA1 .. CRC (RCC, EXTI, FLASH)
+    { IOPORT_BASE, 0x2000u, 0 },        // GPIOA .. GPIOF
+    { SCS_BASE, 0x1000u, 0 },           // SysTick, NVIC, SCB
+};
+#define SIM_REGIONS  (sizeof(s_regions) / sizeof(s_regions[0]))
+
+static Sim_Region *Sim_FindRegion(uintptr_t addr)
+{
+    for (uint8_t i = 0; i < SIM_REGIONS; i++)
+        if (addr >= s_regions[i].base && addr < s_regions[i].base + s_regions[i].size)
+            return &s_regions[i];
+    return 0;
+}
+
+static void *Sim_Alias(const volatile void *p)
+{
+    uintptr_t addr = (uintptr_t)p;
+    Sim_Region *r = Sim_FindRegion(addr);
+    return r ? (void *)(r->alias + (addr - r->base)) : 0;
+}
+
+#define SIM_ALIAS(p)   ((__typeof__(p))Sim_Alias(p))
+
+// =====================================================================
+// Model state
+// =====================================================================
+typedef struct
+{
+    TIM_TypeDef *tim;
+    uint32_t cntMask;           // 16 or 32-bit counter
+    uint8_t channels;
+    uint8_t irqUp;
+    uint8_t irqCc;
+    uint8_t dmaUp;              // DMAMUX request on update (0 = none)
+    uint8_t dmaCc;              // DMAMUX request of CH1 (CHx = +x-1, 0 = none)
+    uint64_t frac;              // ns * Hz remainder
+    uint32_t pscCnt;            // prescaler counter
+    uint32_t pscActive;         // PSC shadow, loaded on update
+    uint32_t updates;           // update events not yet served by DMA
+    uint8_t icEdges[4];         // edges seen, for the input capture prescaler
+} Sim_Timer;
+
+static Sim_Timer s_timers[] =
+{
+    { TIM1, 0xFFFFu, 4, TIM1_BRK_UP_TRG_COM_IRQn, TIM1_CC_IRQn, 25, 20, 0, 0, 0, 0 },
+    { TIM2, 0xFFFFFFFFu, 4, TIM2_IRQn, TIM2_IRQn, 31, 26, 0, 0, 0, 0 },
+    { TIM3, 0xFFFFu, 4, TIM3_IRQn, TIM3_IRQn, 37, 32, 0, 0, 0, 0 },
+    { TIM14, 0xFFFFu, 1, TIM14_IRQn, TIM14_IRQn, 0, 0, 0, 0, 0, 0 },
+    { TIM16, 0xFFFFu, 1, TIM16_IRQn, TIM16_IRQn, 46, 44, 0, 0, 0, 0 },
+    { TIM17, 0xFFFFu, 1, TIM17_IRQn, TIM17_IRQn, 49, 47, 0, 0, 0, 0 },
+};
+#define SIM_TIMERS  (sizeof(s_timers) / sizeof(s_timers[0]))
+
+typedef struct
+{
+    USART_TypeDef *uart;
+    uint8_t irq;
+    uint8_t dmaRx;              // DMAMUX request numbers
+    uint8_t dmaTx;
+    uint8_t fifo[SIM_RX_FIFO];
+    uint16_t head, tail;
+    uint8_t rxActive;           // bytes since the last IDLE
+} Sim_Usart;
+
+static Sim_Usart s_usarts[] =
+{
+    { USART1, USART1_IRQn, 50, 51, {0}, 0, 0, 0 },
+    { USART2, USART2_IRQn, 52, 53, {0}, 0, 0, 0 },
+};
+#define SIM_USARTS  (sizeof(s_usarts) / sizeof(s_usarts[0]))
+
+typedef struct
+{
+    uint32_t mar;               // latched when the channel is enabled
+    uint32_t par;
+    uint16_t len;
+} Sim_DmaChannel;
+
+static Sim_DmaChannel s_dma[5];
+static DMA_Channel_TypeDef *const s_dmaCh[5] =
+{
+    DMA1_Channel1, DMA1_Channel2, DMA1_Channel3, DMA1_Channel4, DMA1_Channel5
+};
+static DMAMUX_Channel_TypeDef *const s_dmaMux[5] =
+{
+    DMAMUX1_Channel0, DMAMUX1_Channel1, DMAMUX1_Channel2, DMAMUX1_Channel3, DMAMUX1_Channel4
+};
+
+static GPIO_TypeDef *const s_ports[6] = { GPIOA, GPIOB, GPIOC, GPIOD, 0, GPIOF };
+static uint16_t s_pinLevel[6];          // externally driven level
+static uint16_t s_pinDriven[6];         // which pins are driven from outside
+static uint16_t s_pinLast[6];           // IDR seen by EXTI last time
+
+typedef struct
+{
+    int8_t port;                // -1 = off
+    uint8_t pin;
+    uint64_t periodNs;
+    uint64_t highNs;
+    uint64_t nextNs;            // host time of the next edge
+} Sim_PinPwm;
+
+static Sim_PinPwm s_pinPwm[2] = { { -1, 0, 0, 0, 0 }, { -1, 0, 0, 0, 0 } };
+
+static volatile sig_atomic_t s_busy = 0;
+static volatile sig_atomic_t s_tickMissed = 0;
+static uint8_t s_inIrq = 0;
+static uint8_t s_ipsr = 0;              // exception number while a handler runs
+static uint8_t s_primask = 0;
+static uint8_t s_stopped = 0;           // Stop mode: only the LPTIMs count
+static uint32_t s_nvicEnabled = 0;
+static uint32_t s_nvicPending = 0;
+static uint32_t s_sysTickPending = 0;
+static uint64_t s_sysTickFrac = 0;
+static int32_t s_hsiPpm = 0;            // SIM_HSI_PPM
+
+static uint64_t s_startNs = 0;
+static uint64_t s_lastNs = 0;
+static uint64_t s_runNs = 0;
+static uint8_t s_stdinOpen = 1;
+static uint8_t s_rawTty = 0;
+static struct termios s_termSaved;
+static Sim_TxHook s_txHook = 0;
+
+// Access in flight between SIGSEGV and SIGTRAP
+static uintptr_t s_accAddr;
+static uint32_t s_accOld;
+static uint8_t s_accWrite;
+static uint8_t s_accAlarmBlocked;
+static Sim_Region *s_accRegion;
+
+static void Sim_Deliver(void);
+static void Sim_TimerInput(uint8_t idx, uint8_t pin, uint8_t level);
+static int8_t Sim_DmaFind(uint8_t request);
+static void Sim_DmaStep(uint8_t i);
+static uint8_t *Sim_DmaMem(uint8_t i);
+
+// =====================================================================
+// Host helpers
+// =====================================================================
+static uint64_t Sim_HostNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * SIM_NS + (uint64_t)ts.tv_nsec;
+}
+
+static void Sim_RestoreTerminal(void)
+{
+    if (s_rawTty)
+        tcsetattr(STDIN_FILENO, TCSANOW, &s_termSaved);
+    s_rawTty = 0;
+}
+
+static void Sim_Exit(int code)
+{
+    Sim_RestoreTerminal();
+    _exit(code);
+}
+
+static void Sim_OnQuit(int sig)
+{
+    Sim_Exit(128 + sig);
+}
+
+// =====================================================================
+// Clock tree
+// =====================================================================
+// 16 MHz + 16 Hz per ppm
+static uint32_t Sim_HsiHz(const RCC_TypeDef *rcc)
+{
+    int32_t trim = (int32_t)((rcc->ICSCR & RCC_ICSCR_HSITRIM) >> RCC_ICSCR_HSITRIM_Pos);
+    int32_t ppm = s_hsiPpm + (trim - 64) * _SIM_HSI_TRIM_PPM;
+
+    return (uint32_t)(16000000 + 16 * ppm);
+}
+
+static uint32_t Sim_PllRHz(const RCC_TypeDef *rcc)
+{
+    uint32_t cfg = rcc->PLLCFGR;
+    uint32_t src = ((cfg & RCC_PLLCFGR_PLLSRC) == RCC_PLLCFGR_PLLSRC_HSE) ? _SIM_HSE_HZ :
+                   ((cfg & RCC_PLLCFGR_PLLSRC) == RCC_PLLCFGR_PLLSRC_HSI) ? Sim_HsiHz(rcc) : 0u;
+    uint32_t m = ((cfg & RCC_PLLCFGR_PLLM) >> RCC_PLLCFGR_PLLM_Pos) + 1u;
+    uint32_t n = (cfg & RCC_PLLCFGR_PLLN) >> RCC_PLLCFGR_PLLN_Pos;
+    uint32_t r = ((cfg & RCC_PLLCFGR_PLLR) >> RCC_PLLCFGR_PLLR_Pos) + 1u;
+
+    return (uint32_t)((uint64_t)src * n / ((uint64_t)m * r));
+}
+
+uint32_t Sim_GetSysclkHz(void)
+{
+    const RCC_TypeDef *rcc = SIM_ALIAS(RCC);
+
+    switch ((rcc->CFGR & RCC_CFGR_SWS) >> RCC_CFGR_SWS_Pos)
+    {
+        case 0: return Sim_HsiHz(rcc) >> ((rcc->CR & RCC_CR_HSIDIV) >> RCC_CR_HSIDIV_Pos);
+        case 1: return _SIM_HSE_HZ;
+        case 2: return Sim_PllRHz(rcc);
+        case 3: return 32000u;
+        case 4: return 32768u;
+        default: return Sim_HsiHz(rcc);
+    }
+}
+
+uint32_t Sim_GetHclkHz(void)
+{
+    static const uint8_t shift[16] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 3, 4, 6, 7, 8, 9 };
+    const RCC_TypeDef *rcc = SIM_ALIAS(RCC);
+    return Sim_GetSysclkHz() >> shift[(rcc->CFGR & RCC_CFGR_HPRE) >> RCC_CFGR_HPRE_Pos];
+}
+
+uint32_t Sim_GetTimerClkHz(void)
+{
+    const RCC_TypeDef *rcc = SIM_ALIAS(RCC);
+    uint32_t ppre = (rcc->CFGR & RCC_CFGR_PPRE) >> RCC_CFGR_PPRE_Pos;
+
+    if (ppre < 4u)
+        return Sim_GetHclkHz();                         // PCLK = HCLK, TIMCLK = PCLK
+    return (Sim_GetHclkHz() >> (ppre - 3u)) * 2u;       // TIMCLK = 2 x PCLK
+}
+
+// =====================================================================
+// GPIO
+// =====================================================================
+static int8_t Sim_PortIndex(const GPIO_TypeDef *port)
+{
+    for (int8_t i = 0; i < 6; i++)
+        if (s_ports[i] && s_ports[i] == port)
+            return i;
+    return -1;
+}
+
+static void Sim_GpioRefresh(uint8_t idx)
+{
+    GPIO_TypeDef *gpio = SIM_ALIAS(s_ports[idx]);
+    uint32_t idr = 0;
+
+    for (uint8_t pin = 0; pin < 16; pin++)
+    {
+        uint32_t mode = (gpio->MODER >> (2u * pin)) & 3u;
+        uint32_t pull = (gpio->PUPDR >> (2u * pin)) & 3u;
+        uint32_t bit = 1u << pin;
+        uint32_t level;
+
+        if (mode == 1u)                                 // output
+            level = gpio->ODR & bit;
+        else if (mode == 3u)                            // analog reads 0
+            level = 0;
+        else if (s_pinDriven[idx] & bit)
+            level = s_pinLevel[idx] & bit;
+        else
+            level = (pull == 1u) ? bit : 0;             // floating reads low
+
+        idr |= level;
+    }
+    gpio->IDR = idr;
+
+    // Timer inputs (capture, reset / trigger slave modes)
+    uint16_t changed = (uint16_t)(idr ^ s_pinLast[idx]);
+    for (uint8_t pin = 0; changed && pin < 16; pin++)
+        if (changed & (1u << pin))
+            Sim_TimerInput(idx, pin, (uint8_t)((idr >> pin) & 1u));
+
+    // EXTI edge detection on the lines routed to this port
+    EXTI_TypeDef *exti = SIM_ALIAS(EXTI);
+    for (uint8_t line = 0; changed && line < 16; line++)
+    {
+        uint32_t bit = 1u << line;
+        if (!(changed & bit))
+            continue;
+        uint32_t sel = (exti->EXTICR[line >> 2] >> (8u * (line & 3u))) & 0xFFu;
+        if (sel != idx)
+            continue;
+        if ((idr & bit) && (exti->RTSR1 & bit))
+            exti->RPR1 |= bit;
+        if (!(idr & bit) && (exti->FTSR1 & bit))
+            exti->FPR1 |= bit;
+    }
+    s_pinLast[idx] = (uint16_t)idr;
+}
+
+static void Sim_GpioAfter(uint8_t idx, uint32_t offset, uint32_t old, uint8_t write)
+{
+    GPIO_TypeDef *gpio = SIM_ALIAS(s_ports[idx]);
+
+    if (write)
+    {
+        switch (offset)
+        {
+            case 0x10:                                  // IDR is read only
+                gpio->IDR = old;
+                break;
+            case 0x18:                                  // BSRR: set wins over reset
+            {
+                uint32_t v = gpio->BSRR;
+                gpio->ODR = (gpio->ODR & ~(v >> 16)) | (v & 0xFFFFu);
+                gpio->BSRR = 0;
+                break;
+            }
+            case 0x28:                                  // BRR
+                gpio->ODR &= ~(gpio->BRR & 0xFFFFu);
+                gpio->BRR = 0;
+                break;
+            default:
+                break;
+        }
+    }
+    Sim_GpioRefresh(idx);
+}
+
+// =====================================================================
+// TIM (edge aligned, up counting)
+// =====================================================================
+static void Sim_TimerAdvance(Sim_Timer *t, uint64_t dtNs, uint32_t clkHz)
+{
+    TIM_TypeDef *tim = SIM_ALIAS(t->tim);
+
+    if (!(tim->CR1 & TIM_CR1_CEN) || tim->ARR == 0)
+    {
+        t->frac = 0;
+        return;
+    }
+
+    uint64_t num = dtNs * clkHz + t->frac;
+    uint64_t ticks = num / SIM_NS + t->pscCnt;
+    t->frac = num % SIM_NS;
+
+    uint64_t div = (uint64_t)t->pscActive + 1u;
+    uint64_t counts = ticks / div;
+    t->pscCnt = (uint32_t)(ticks % div);
+    if (!counts)
+        return;
+
+    uint64_t period = (uint64_t)(tim->ARR & t->cntMask) + 1u;
+    uint64_t cnt = tim->CNT & t->cntMask;
+    uint32_t sr = 0;
+
+    // CCxIF when the counter reaches CCRx (output compare channels)
+    volatile uint32_t *ccr[4] = { &tim->CCR1, &tim->CCR2, &tim->CCR3, &tim->CCR4 };
+    for (uint8_t ch = 0; ch < t->channels; ch++)
+    {
+        uint32_t ccmr = (ch < 2) ? tim->CCMR1 : tim->CCMR2;
+        if ((ccmr >> (8u * (ch & 1u))) & TIM_CCMR1_CC1S)
+            continue;                                   // input capture
+        uint64_t c = *ccr[ch] & t->cntMask;
+        if (c >= period)
+            continue;
+        if (counts >= period || ((c + period - cnt - 1u) % period) < counts)
+            sr |= TIM_SR_CC1IF << ch;
+    }
+
+    if (cnt + counts >= period)
+    {
+        if (!(tim->CR1 & TIM_CR1_UDIS))
+        {
+            sr |= TIM_SR_UIF;
+            t->pscActive = tim->PSC;
+            if (tim->DIER & TIM_DIER_UDE)
+            {
+                uint64_t n = (tim->CR1 & TIM_CR1_OPM) ? 1u : (cnt + counts) / period;
+                t->updates = (uint32_t)((t->updates + n > 0x10000u) ? 0x10000u : t->updates + n);
+            }
+        }
+        if (tim->CR1 & TIM_CR1_OPM)
+        {
+            tim->CR1 &= ~TIM_CR1_CEN;
+            cnt = 0;
+        }
+        else
+            cnt = (cnt + counts) % period;
+    }
+    else
+        cnt += counts;
+
+    tim->CNT = (uint32_t)cnt;
+    tim->SR |= sr;
+}
+
+static uint8_t Sim_TimerIsInput(const TIM_TypeDef *tim, uint8_t ch)
+{
+    uint32_t ccmr = (ch < 2) ? tim->CCMR1 : tim->CCMR2;
+    return ((ccmr >> (8u * (ch & 1u))) & TIM_CCMR1_CC1S) ? 1 : 0;
+}
+
+static void Sim_TimerCcRead(Sim_Timer *t, uint8_t ch)
+{
+    TIM_TypeDef *tim = SIM_ALIAS(t->tim);
+    if (ch < t->channels && Sim_TimerIsInput(tim, ch))
+        tim->SR &= ~(TIM_SR_CC1IF << ch);
+}
+
+// Pin -> timer input (TIx) for the alternate functions the labs use
+typedef struct
+{
+    uint8_t port;               // 0 = GPIOA ..
+    uint8_t pin;
+    uint8_t af;
+    uint8_t timer;              // index in s_timers
+    uint8_t ti;                 // 0 = TI1 ..
+} Sim_TimerPin;
+
+static const Sim_TimerPin s_timerPins[] =
+{
+    { 0, 8, 2, 0, 0 }, { 0, 9, 2, 0, 1 }, { 0, 10, 2, 0, 2 }, { 0, 11, 2, 0, 3 },   // TIM1
+    { 0, 0, 2, 1, 0 }, { 0, 5, 2, 1, 0 }, { 0, 15, 2, 1, 0 }, { 0, 1, 2, 1, 1 },    // TIM2
+    { 1, 3, 2, 1, 1 }, { 0, 2, 2, 1, 2 }, { 0, 3, 2, 1, 3 },
+    { 0, 6, 1, 2, 0 }, { 1, 4, 1, 2, 0 }, { 2, 6, 1, 2, 0 }, { 0, 7, 1, 2, 1 },     // TIM3
+    { 1, 5, 1, 2, 1 }, { 2, 7, 1, 2, 1 }, { 1, 0, 1, 2, 2 }, { 1, 1, 1, 2, 3 },
+    { 0, 4, 4, 3, 0 }, { 0, 7, 4, 3, 0 }, { 1, 1, 0, 3, 0 },                        // TIM14
+    { 0, 6, 5, 4, 0 }, { 1, 8, 2, 4, 0 }, { 0, 7, 5, 5, 0 }, { 1, 9, 2, 5, 0 },     // TIM16, TIM17
+};
+
+// One DMA request from a capture: CCRx, or a DMAR burst of DBL + 1 registers
+static void Sim_TimerCcDma(Sim_Timer *t, uint8_t ch)
+{
+    int8_t i = t->dmaCc ? Sim_DmaFind((uint8_t)(t->dmaCc + ch)) : -1;
+    if (i < 0)
+        return;
+
+    TIM_TypeDef *tim = SIM_ALIAS(t->tim);
+    DMA_Channel_TypeDef *dch = SIM_ALIAS(s_dmaCh[i]);
+    uint8_t burst = (s_dma[i].par == (uint32_t)(uintptr_t)&t->tim->DMAR);
+    uint32_t dba = (tim->DCR & TIM_DCR_DBA) >> TIM_DCR_DBA_Pos;
+    uint32_t n = burst ? ((tim->DCR & TIM_DCR_DBL) >> TIM_DCR_DBL_Pos) + 1u : 1u;
+
+    for (uint32_t k = 0; k < n && dch->CNDTR; k++)
+    {
+        uint32_t reg = burst ? dba + k : (uint32_t)((s_dma[i].par - (uint32_t)(uintptr_t)t->tim) / 4u);
+        uint32_t value = ((volatile uint32_t *)tim)[reg];
+        uint8_t *dst = Sim_DmaMem((uint8_t)i);
+        switch ((dch->CCR & DMA_CCR_MSIZE) >> DMA_CCR_MSIZE_Pos)
+        {
+            case 0: *dst = (uint8_t)value; break;
+            case 1: *(uint16_t *)dst = (uint16_t)value; break;
+            default: *(uint32_t *)dst = value; break;
+        }
+        if (reg >= 13u && reg <= 16u)                   // CCR1..CCR4 read
+            Sim_TimerCcRead(t, (uint8_t)(reg - 13u));
+        Sim_DmaStep((uint8_t)i);
+    }
+}
+
+// Edge on TIx: input captures, then the reset / trigger slave modes
+static void Sim_TimerEdge(Sim_Timer *t, uint8_t ti, uint8_t level)
+{
+    TIM_TypeDef *tim = SIM_ALIAS(t->tim);
+
+    for (uint8_t ch = 0; ch < t->channels; ch++)
+    {
+        uint32_t ccmr = (ch < 2) ? tim->CCMR1 : tim->CCMR2;
+        uint32_t ccs = (ccmr >> (8u * (ch & 1u))) & TIM_CCMR1_CC1S;
+        uint32_t ccer = tim->CCER >> (4u * ch);
+        uint8_t src = (ccs == 1u) ? ch : (ccs == 2u) ? (uint8_t)(ch ^ 1u) : 0xFFu;
+        if (src != ti || !(ccer & TIM_CCER_CC1E))
+            continue;
+        uint8_t p = (ccer & TIM_CCER_CC1P) ? 1 : 0, np = (ccer & TIM_CCER_CC1NP) ? 1 : 0;
+        if (!(p && np) && level == p)                   // 00 rising, 01 falling, 11 both
+            continue;
+        uint32_t icpsc = (ccmr >> (8u * (ch & 1u) + TIM_CCMR1_IC1PSC_Pos)) & 3u;
+        if (++t->icEdges[ch] & ((1u << icpsc) - 1u))   // ICxPSC: every 2nd / 4th / 8th edge
+            continue;
+
+        volatile uint32_t *ccr[4] = { &tim->CCR1, &tim->CCR2, &tim->CCR3, &tim->CCR4 };
+        *ccr[ch] = tim->CNT & t->cntMask;
+        if (tim->SR & (TIM_SR_CC1IF << ch))
+            tim->SR |= TIM_SR_CC1OF << ch;
+        tim->SR |= TIM_SR_CC1IF << ch;
+        if (tim->DIER & (TIM_DIER_CC1DE << ch))
+            Sim_TimerCcDma(t, ch);
+    }
+
+    // Slave mode on TI1FP1 (TS = 101) / TI2FP2 (TS = 110), polarity from CC1P / CC2P
+    uint32_t ts = (tim->SMCR & TIM_SMCR_TS) >> TIM_SMCR_TS_Pos;
+    uint32_t sms = tim->SMCR & TIM_SMCR_SMS;
+    if ((ts != 5u || ti != 0) && (ts != 6u || ti != 1))
+        return;
+    uint32_t ccer = tim->CCER >> (4u * ti);
+    uint8_t p = (ccer & TIM_CCER_CC1P) ? 1 : 0, np = (ccer & TIM_CCER_CC1NP) ? 1 : 0;
+    if (!(p && np) && level == p)
+        return;
+
+    if (sms == TIM_SMCR_SMS_2)                          // reset mode
+    {
+        tim->CNT = 0;
+        t->pscCnt = 0;
+        t->pscActive = tim->PSC;
+        tim->SR |= TIM_SR_TIF;
+        if (!(tim->CR1 & TIM_CR1_URS))
+            tim->SR |= TIM_SR_UIF;
+    }
+    else if (sms == (TIM_SMCR_SMS_2 | TIM_SMCR_SMS_1))  // trigger mode
+    {
+        tim->CR1 |= TIM_CR1_CEN;
+        tim->SR |= TIM_SR_TIF;
+    }
+}
+
+static void Sim_TimerInput(uint8_t idx, uint8_t pin, uint8_t level)
+{
+    const GPIO_TypeDef *gpio = SIM_ALIAS(s_ports[idx]);
+    if (((gpio->MODER >> (2u * pin)) & 3u) != 2u)      // alternate function only
+        return;
+    uint32_t af = (gpio->AFR[pin >> 3] >> (4u * (pin & 7u))) & 0xFu;
+
+    for (uint8_t k = 0; k < sizeof(s_timerPins) / sizeof(s_timerPins[0]); k++)
+    {
+        const Sim_TimerPin *m = &s_timerPins[k];
+        if (m->port == idx && m->pin == pin && m->af == af &&
+            !(m->ti == 0 && (SIM_ALIAS(s_timers[m->timer].tim)->TISEL & TIM_TISEL_TI1SEL)))
+            Sim_TimerEdge(&s_timers[m->timer], m->ti, level);
+    }
+}
+
+// Trigger mode slaves (SMS = 0110) whose ITRx carries this master's TRGO
+static void Sim_TimerTrigger(const Sim_Timer *master)
+{
+    static TIM_TypeDef *const itr[3][4] =
+    {
+        { 0, TIM2, TIM3, 0 },                           // TIM1
+        { TIM1, 0, TIM3, 0 },                           // TIM2
+        { TIM1, TIM2, 0, 0 },                           // TIM3
+    };
+
+    for (uint8_t i = 0; i < 3; i++)                     // TIM1/2/3 lead s_timers
+    {
+        TIM_TypeDef *slave = SIM_ALIAS(s_timers[i].tim);
+        uint32_t ts = (slave->SMCR & TIM_SMCR_TS) >> TIM_SMCR_TS_Pos;
+        if ((slave->SMCR & TIM_SMCR_SMS) != (TIM_SMCR_SMS_2 | TIM_SMCR_SMS_1) ||
+            ts > 3u || itr[i][ts] != master->tim)
+            continue;
+        slave->CR1 |= TIM_CR1_CEN;
+        slave->SR |= TIM_SR_TIF;
+        s_timers[i].frac = 0;
+    }
+}
+
+static void Sim_TimerAfter(Sim_Timer *t, uint32_t offset, uint32_t old, uint8_t write)
+{
+    TIM_TypeDef *tim = SIM_ALIAS(t->tim);
+
+    if (!write)
+    {
+        if (offset >= 0x34 && offset <= 0x40)           // reading a captured CCRx clears CCxIF
+            Sim_TimerCcRead(t, (uint8_t)((offset - 0x34) / 4u));
+        return;
+    }
+
+    switch (offset)
+    {
+        case 0x00:                                      // CR1: CEN on TRGO (MMS = enable)
+            if ((tim->CR1 & TIM_CR1_CEN) && !(old & TIM_CR1_CEN) &&
+                (tim->CR2 & TIM_CR2_MMS) == TIM_CR2_MMS_0)
+                Sim_TimerTrigger(t);
+            break;
+        case 0x10:                                      // SR: rc_w0
+            tim->SR = old & tim->SR;
+            break;
+        case 0x14:                                      // EGR
+        {
+            uint32_t egr = tim->EGR;
+            if (egr & TIM_EGR_UG)
+            {
+                tim->CNT = 0;
+                t->pscCnt = 0;
+                t->pscActive = tim->PSC;
+                if (!(tim->CR1 & TIM_CR1_URS))
+                    tim->SR |= TIM_SR_UIF;
+            }
+            tim->SR |= egr & (TIM_SR_CC1IF | TIM_SR_CC2IF | TIM_SR_CC3IF | TIM_SR_CC4IF);
+            tim->EGR = 0;
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+static uint32_t Sim_TimerLines(const Sim_Timer *t)
+{
+    const TIM_TypeDef *tim = SIM_ALIAS(t->tim);
+    uint32_t active = tim->SR & tim->DIER & 0xFFu;
+    uint32_t lines = 0;
+
+    if (active & ~0x1Eu)
+        lines |= 1u << t->irqUp;                        // update / trigger / break / com
+    if (active & 0x1Eu)
+        lines |= 1u << t->irqCc;
+    return lines;
+}
+
+// =====================================================================
+// DMA1 (USART and timer update requests)
+// =====================================================================
+static int8_t Sim_DmaFind(uint8_t request)
+{
+    for (uint8_t i = 0; i < 5; i++)
+    {
+        const DMA_Channel_TypeDef *ch = SIM_ALIAS(s_dmaCh[i]);
+        const DMAMUX_Channel_TypeDef *mux = SIM_ALIAS(s_dmaMux[i]);
+        if ((ch->CCR & DMA_CCR_EN) && (mux->CCR & DMAMUX_CxCR_DMAREQ_ID) == request)
+            return (int8_t)i;
+    }
+    return -1;
+}
+
+// One element moved: step CNDTR, raise HT/TC, reload in circular mode
+static void Sim_DmaStep(uint8_t i)
+{
+    DMA_Channel_TypeDef *ch = SIM_ALIAS(s_dmaCh[i]);
+    DMA_TypeDef *dma = SIM_ALIAS(DMA1);
+    uint32_t shift = 4u * i;
+    uint16_t left = (uint16_t)(ch->CNDTR - 1u);
+
+    if (left == s_dma[i].len / 2u)
+        dma->ISR |= (DMA_ISR_HTIF1 | DMA_ISR_GIF1) << shift;
+    if (left == 0)
+    {
+        dma->ISR |= (DMA_ISR_TCIF1 | DMA_ISR_GIF1) << shift;
+        if (ch->CCR & DMA_CCR_CIRC)
+            left = s_dma[i].len;
+    }
+    ch->CNDTR = left;
+}
+
+static uint8_t *Sim_DmaMem(uint8_t i)
+{
+    const DMA_Channel_TypeDef *ch = SIM_ALIAS(s_dmaCh[i]);
+    uint32_t index = (ch->CCR & DMA_CCR_MINC) ? (uint32_t)(s_dma[i].len - ch->CNDTR) : 0u;
+    uint32_t size = 1u << ((ch->CCR & DMA_CCR_MSIZE) >> DMA_CCR_MSIZE_Pos);
+    return (uint8_t *)(uintptr_t)(s_dma[i].mar + index * size);
+}
+
+// Update DMA requests (TIMx_UP): one memory -> peripheral transfer each
+static void Sim_TimerDma(Sim_Timer *t)
+{
+    int8_t i = t->dmaUp ? Sim_DmaFind(t->dmaUp) : -1;
+
+    if (i < 0)
+    {
+        t->updates = 0;
+        return;
+    }
+    const DMA_Channel_TypeDef *ch = SIM_ALIAS(s_dmaCh[i]);
+    for (; t->updates && ch->CNDTR; t->updates--)
+    {
+        uint32_t value = 0;
+        const uint8_t *src = Sim_DmaMem((uint8_t)i);
+        switch ((ch->CCR & DMA_CCR_MSIZE) >> DMA_CCR_MSIZE_Pos)
+        {
+            case 0: value = *src; break;
+            case 1: value = *(const uint16_t *)src; break;
+            default: value = *(const uint32_t *)src; break;
+        }
+        volatile uint32_t *dst = Sim_Alias((const volatile void *)(uintptr_t)s_dma[i].par);
+        if (dst)
+            *dst = value;
+        Sim_DmaStep((uint8_t)i);
+    }
+    t->updates = 0;
+}
+
+static uint32_t Sim_DmaLines(void)
+{
+    const DMA_TypeDef *dma = SIM_ALIAS(DMA1);
+    uint32_t lines = 0;
+
+    for (uint8_t i = 0; i < 5; i++)
+    {
+        const DMA_Channel_TypeDef *ch = SIM_ALIAS(s_dmaCh[i]);
+        uint32_t flags = (dma->ISR >> (4u * i)) & 0xEu;  // TC, HT, TE
+        if (flags & ch->CCR & 0xEu)                      // TCIE, HTIE, TEIE line up
+            lines |= 1u << ((i == 0) ? DMA1_Channel1_IRQn :
+                            (i < 3) ? DMA1_Channel2_3_IRQn : DMA1_Ch4_5_DMAMUX1_OVR_IRQn);
+    }
+    return lines;
+}
+
+// =====================================================================
+// USART
+// =====================================================================
+static void Sim_UsartEmit(Sim_Usart *u, uint8_t byte)
+{
+    if (s_txHook)
+        s_txHook(u->uart, byte);
+    else if (u->uart == USART2)
+    {
+        ssize_t n = write(STDOUT_FILENO, &byte, 1);
+        (void)n;
+    }
+}
+
+static void Sim_UsartPollStdin(Sim_Usart *u)
+{
+    if (!s_stdinOpen || u->uart != USART2)
+        return;
+
+    uint16_t free = (uint16_t)(SIM_RX_FIFO - 1u - (uint16_t)(u->head - u->tail));
+    struct pollfd pfd = { STDIN_FILENO, POLLIN, 0 };
+    if (!free || poll(&pfd, 1, 0) <= 0)
+        return;
+
+    uint8_t buf[SIM_RX_FIFO];
+    ssize_t n = read(STDIN_FILENO, buf, free);
+    if (n <= 0)
+    {
+        s_stdinOpen = 0;                                // EOF: the line stays idle
+        return;
+    }
+    for (ssize_t k = 0; k < n; k++)
+        u->fifo[(u->head++) % SIM_RX_FIFO] = buf[k];
+}
+
+static void Sim_UsartUpdate(Sim_Usart *u)
+{
+    USART_TypeDef *uart = SIM_ALIAS(u->uart);
+    uint32_t cr1 = uart->CR1;
+    uint32_t isr = uart->ISR;
+
+    // Transmitter never backs up: TXE / TC always set
+    isr |= USART_ISR_TXE_TXFNF | USART_ISR_TC;
+    isr = (cr1 & USART_CR1_TE) ? (isr | USART_ISR_TEACK) : (isr & ~USART_ISR_TEACK);
+    isr = (cr1 & USART_CR1_RE) ? (isr | USART_ISR_REACK) : (isr & ~USART_ISR_REACK);
+
+    if ((cr1 & USART_CR1_UE) && (cr1 & USART_CR1_RE))
+    {
+        Sim_UsartPollStdin(u);
+
+        int8_t rx = (uart->CR3 & USART_CR3_DMAR) ? Sim_DmaFind(u->dmaRx) : -1;
+        while (u->tail != u->head)
+        {
+            uint8_t byte = u->fifo[u->tail % SIM_RX_FIFO];
+            if (rx >= 0)
+            {
+                if (!SIM_ALIAS(s_dmaCh[rx])->CNDTR)
+                    break;
+                *Sim_DmaMem((uint8_t)rx) = byte;
+                Sim_DmaStep((uint8_t)rx);
+            }
+            else if (!(isr & USART_ISR_RXNE_RXFNE))
+            {
+                uart->RDR = byte;
+                isr |= USART_ISR_RXNE_RXFNE;
+            }
+            else
+                break;
+            u->tail++;
+            u->rxActive = 1;
+        }
+
+        // Line goes idle once everything received has been taken
+        if (u->rxActive && u->tail == u->head && !(isr & USART_ISR_RXNE_RXFNE))
+        {
+            isr |= USART_ISR_IDLE;
+            u->rxActive = 0;
+        }
+    }
+
+    // Transmit DMA: the whole block goes out at once
+    int8_t tx = (uart->CR3 & USART_CR3_DMAT) ? Sim_DmaFind(u->dmaTx) : -1;
+    if (tx >= 0 && (cr1 & USART_CR1_TE))
+    {
+        uint16_t guard = s_dma[tx].len;
+        while (SIM_ALIAS(s_dmaCh[tx])->CNDTR && guard--)
+        {
+            Sim_UsartEmit(u, *Sim_DmaMem((uint8_t)tx));
+            Sim_DmaStep((uint8_t)tx);
+        }
+    }
+
+    uart->ISR = isr;
+}
+
+static void Sim_UsartAfter(Sim_Usart *u, uint32_t offset, uint32_t old, uint8_t write)
+{
+    USART_TypeDef *uart = SIM_ALIAS(u->uart);
+
+    switch (offset)
+    {
+        case 0x18:                                      // RQR
+            if (write && (uart->RQR & USART_RQR_RXFRQ))
+                uart->ISR &= ~USART_ISR_RXNE_RXFNE;
+            uart->RQR = 0;
+            break;
+        case 0x1C:                                      // ISR is read only
+            if (write)
+                uart->ISR = old;
+            break;
+        case 0x20:                                      // ICR: write 1 to clear
+            uart->ISR &= ~(uart->ICR & 0x00123BFFu);
+            uart->ICR = 0;
+            break;
+        case 0x24:                                      // RDR: reading takes the byte
+            if (write)
+                uart->RDR = old;
+            else
+                uart->ISR &= ~USART_ISR_RXNE_RXFNE;
+            break;
+        case 0x28:                                      // TDR
+            if (write && (uart->CR1 & USART_CR1_UE) && (uart->CR1 & USART_CR1_TE))
+                Sim_UsartEmit(u, (uint8_t)uart->TDR);
+            break;
+        default:
+            break;
+    }
+    Sim_UsartUpdate(u);
+}
+
+static uint32_t Sim_UsartLines(const Sim_Usart *u)
+{
+    const USART_TypeDef *uart = SIM_ALIAS(u->uart);
+    uint32_t isr = uart->ISR;
+    uint32_t cr1 = uart->CR1;
+
+    if (((isr & USART_ISR_TXE_TXFNF) && (cr1 & USART_CR1_TXEIE_TXFNFIE)) ||
+        ((isr & USART_ISR_TC) && (cr1 & USART_CR1_TCIE)) ||
+        ((isr & USART_ISR_RXNE_RXFNE) && (cr1 & USART_CR1_RXNEIE_RXFNEIE)) ||
+        ((isr & USART_ISR_IDLE) && (cr1 & USART_CR1_IDLEIE)))
+        return 1u << u->irq;
+    return 0;
+}
+
+// =====================================================================
+// LPTIM (1/2, up counting on its kernel clock, runs in Stop mode)
+// =====================================================================
+typedef struct
+{
+    LPTIM_TypeDef *lptim;
+    uint8_t irq;
+    uint8_t selPos;             // RCC_CCIPR clock select field
+    uint64_t frac;              // ns * Hz remainder
+} Sim_Lptim;
+
+static Sim_Lptim s_lptims[] =
+{
+    { LPTIM1, LPTIM1_IRQn, RCC_CCIPR_LPTIM1SEL_Pos, 0 },
+    { LPTIM2, LPTIM2_IRQn, RCC_CCIPR_LPTIM2SEL_Pos, 0 },
+};
+#define SIM_LPTIMS  (sizeof(s_lptims) / sizeof(s_lptims[0]))
+
+static uint32_t Sim_LptimClkHz(const Sim_Lptim *l)
+{
+    const RCC_TypeDef *rcc = SIM_ALIAS(RCC);
+
+    switch ((rcc->CCIPR >> l->selPos) & 3u)
+    {
+        case 0: return s_stopped ? 0u : Sim_GetHclkHz();    // PCLK stops with the core clocks
+        case 1: return (rcc->CSR & RCC_CSR_LSIRDY) ? 32000u : 0u;
+        case 2: return s_stopped ? 0u : Sim_HsiHz(rcc);
+        default: return (rcc->BDCR & RCC_BDCR_LSERDY) ? 32768u : 0u;
+    }
+}
+
+static void Sim_LptimAdvance(Sim_Lptim *l, uint64_t dtNs)
+{
+    LPTIM_TypeDef *lp = SIM_ALIAS(l->lptim);
+    uint32_t clk = Sim_LptimClkHz(l);
+
+    if (!(lp->CR & LPTIM_CR_ENABLE) || !(lp->CR & LPTIM_CR_CNTSTRT) || !clk)
+    {
+        l->frac = 0;
+        return;
+    }
+
+    uint64_t num = dtNs * clk + l->frac;
+    uint64_t ticks = num / SIM_NS;
+    l->frac = num % SIM_NS;
+    ticks >>= (lp->CFGR & LPTIM_CFGR_PRESC) >> LPTIM_CFGR_PRESC_Pos;  // prescaler is 2^n
+    if (!ticks)
+        return;
+
+    uint64_t top = (uint64_t)(lp->ARR & 0xFFFFu) + 1u;
+    uint64_t cnt = lp->CNT & 0xFFFFu;
+    uint64_t toCmp = ((lp->CMP & 0xFFFFu) + top - cnt) % top;
+    uint64_t toArr = ((lp->ARR & 0xFFFFu) + top - cnt) % top;
+
+    if (ticks >= (toCmp ? toCmp : top) && (lp->CMP & 0xFFFFu) < top)
+        lp->ISR |= LPTIM_ISR_CMPM;
+    if (ticks >= (toArr ? toArr : top))
+        lp->ISR |= LPTIM_ISR_ARRM;
+    lp->CNT = (uint32_t)((cnt + ticks) % top);
+}
+
+static void Sim_LptimAfter(Sim_Lptim *l, uint32_t offset, uint32_t old, uint8_t write)
+{
+    LPTIM_TypeDef *lp = SIM_ALIAS(l->lptim);
+
+    if (!write)
+        return;
+
+    switch (offset)
+    {
+        case 0x00: lp->ISR = old; break;                // read only
+        case 0x04: lp->ISR &= ~lp->ICR; lp->ICR = 0; break;
+        case 0x10:                                      // CR: SNGSTRT / CNTSTRT latch
+            if (!(lp->CR & LPTIM_CR_ENABLE))
+            {
+                lp->CR = 0;
+                lp->CNT = 0;
+            }
+            break;
+        case 0x14: lp->ISR |= LPTIM_ISR_CMPOK; break;   // preload transfer done at once
+        case 0x18: lp->ISR |= LPTIM_ISR_ARROK; break;
+        case 0x1C: lp->CNT = old; break;                // read only
+        default: break;
+    }
+}
+
+static uint32_t Sim_LptimLines(const Sim_Lptim *l)
+{
+    const LPTIM_TypeDef *lp = SIM_ALIAS(l->lptim);
+    return (lp->ISR & lp->IER & 0x7Fu) ? 1u << l->irq : 0u;
+}
+
+// =====================================================================
+// DMA registers
+// =====================================================================
+static void Sim_DmaAfter(uint32_t offset, uint32_t old, uint8_t write)
+{
+    DMA_TypeDef *dma = SIM_ALIAS(DMA1);
+
+    if (!write)
+        return;
+
+    if (offset == 0x00)                                 // ISR is read only
+        dma->ISR = old;
+    else if (offset == 0x04)                            // IFCR: GIFx clears the channel
+    {
+        uint32_t ifcr = dma->IFCR;
+        for (uint8_t i = 0; i < 5; i++)
+            if (ifcr & (DMA_IFCR_CGIF1 << (4u * i)))
+                ifcr |= 0xFu << (4u * i);
+        dma->ISR &= ~ifcr;
+        dma->IFCR = 0;
+    }
+    else if (offset >= 0x08 && offset < 0x08 + 5u * 20u && ((offset - 0x08) % 20u) == 0)
+    {
+        uint8_t i = (uint8_t)((offset - 0x08) / 20u);   // CCRx: latch the setup on enable
+        const DMA_Channel_TypeDef *ch = SIM_ALIAS(s_dmaCh[i]);
+        if ((ch->CCR & DMA_CCR_EN) && !(old & DMA_CCR_EN))
+        {
+            s_dma[i].mar = ch->CMAR;
+            s_dma[i].par = ch->CPAR;
+            s_dma[i].len = (uint16_t)ch->CNDTR;
+        }
+    }
+
+    for (uint8_t k = 0; k < SIM_USARTS; k++)
+        Sim_UsartUpdate(&s_usarts[k]);
+}
+
+// =====================================================================
+// RCC / SysTick / NVIC / SCB / EXTI
+// =====================================================================
+static void Sim_RccAfter(uint32_t offset, uint8_t write)
+{
+    RCC_TypeDef *rcc = SIM_ALIAS(RCC);
+
+    if (!write)
+        return;
+
+    switch (offset)
+    {
+        case 0x00:                                      // CR: oscillators are ready at once
+        {
+            uint32_t cr = rcc->CR & ~(RCC_CR_HSIRDY | RCC_CR_HSERDY | RCC_CR_PLLRDY);
+            if (cr & RCC_CR_HSION) cr |= RCC_CR_HSIRDY;
+            if (cr & RCC_CR_HSEON) cr |= RCC_CR_HSERDY;
+            if (cr & RCC_CR_PLLON) cr |= RCC_CR_PLLRDY;
+            rcc->CR = cr;
+
+            // Reserved settings lock on silicon at something undefined: say so
+            uint32_t cfg = rcc->PLLCFGR;
+            uint32_t n = (cfg & RCC_PLLCFGR_PLLN) >> RCC_PLLCFGR_PLLN_Pos;
+            if ((cr & RCC_CR_PLLON) && (n < 8u || n > 86u || !(cfg & RCC_PLLCFGR_PLLR)))
+                fprintf(stderr, "sim: PLLCFGR 0x%08X uses a reserved N or R value\n", (unsigned)cfg);
+            break;
+        }
+        case 0x08:                                      // CFGR: switch completes at once
+        {
+            uint32_t sw = (rcc->CFGR & RCC_CFGR_SW) >> RCC_CFGR_SW_Pos;
+            rcc->CFGR = (rcc->CFGR & ~RCC_CFGR_SWS) | (sw << RCC_CFGR_SWS_Pos);
+            break;
+        }
+        case 0x5C:                                      // BDCR
+            if (rcc->BDCR & RCC_BDCR_LSEON) rcc->BDCR |= RCC_BDCR_LSERDY;
+            else rcc->BDCR &= ~RCC_BDCR_LSERDY;
+            break;
+        case 0x60:                                      // CSR
+            if (rcc->CSR & RCC_CSR_LSION) rcc->CSR |= RCC_CSR_LSIRDY;
+            else rcc->CSR &= ~RCC_CSR_LSIRDY;
+            break;
+        default:
+            break;
+    }
+}
+
+static void Sim_SysTickAdvance(uint64_t dtNs)
+{
+    SysTick_Type *st = SIM_ALIAS(SysTick);
+
+    if (!(st->CTRL & SysTick_CTRL_ENABLE_Msk) || st->LOAD == 0)
+    {
+        s_sysTickFrac = 0;
+        return;
+    }
+
+    uint32_t clk = Sim_GetHclkHz();
+    if (!(st->CTRL & SysTick_CTRL_CLKSOURCE_Msk))
+        clk /= 8u;
+
+    uint64_t num = dtNs * clk + s_sysTickFrac;
+    uint64_t ticks = num / SIM_NS;
+    s_sysTickFrac = num % SIM_NS;
+    if (!ticks)
+        return;
+
+    uint64_t period = (uint64_t)(st->LOAD & 0xFFFFFFu) + 1u;
+    uint64_t first = st->VAL & 0xFFFFFFu;               // ticks until VAL next reaches 0
+    if (!first)
+        first = period;                                 // at 0 the next tick reloads LOAD
+
+    if (ticks < first)
+    {
+        st->VAL = (uint32_t)(first - ticks) % (uint32_t)period;
+        return;
+    }
+
+    uint64_t wraps = 1u + (ticks - first) / period;
+    uint64_t rest = (ticks - first) % period;
+    st->VAL = rest ? (uint32_t)(period - rest) : 0u;
+    st->CTRL |= SysTick_CTRL_COUNTFLAG_Msk;
+    if (st->CTRL & SysTick_CTRL_TICKINT_Msk)
+    {
+        s_sysTickPending += (uint32_t)wraps;
+        if (s_sysTickPending > 1000u)                   // host stalled: don't replay forever
+            s_sysTickPending = 1000u;
+    }
+}
+
+// ICSR shows the SysTick exception pending (PENDSTSET) while a tick waits
+static void Sim_IcsrRefresh(void)
+{
+    SCB_Type *scb = SIM_ALIAS(SCB);
+    scb->ICSR = s_sysTickPending ? SCB_ICSR_PENDSTSET_Msk : 0u;
+}
+
+static void Sim_ScsAfter(uint32_t offset, uint32_t old, uint8_t write)
+{
+    SysTick_Type *st = SIM_ALIAS(SysTick);
+    NVIC_Type *nvic = SIM_ALIAS(NVIC);
+    SCB_Type *scb = SIM_ALIAS(SCB);
+
+    switch (offset)
+    {
+        case 0x010:                                     // SysTick CTRL: COUNTFLAG clears on read
+            if (write)
+                st->CTRL = (st->CTRL & ~SysTick_CTRL_COUNTFLAG_Msk) | (old & SysTick_CTRL_COUNTFLAG_Msk);
+            else
+                st->CTRL &= ~SysTick_CTRL_COUNTFLAG_Msk;
+            break;
+        case 0x018:                                     // SysTick VAL: any write clears
+            if (write)
+            {
+                st->VAL = 0;
+                st->CTRL &= ~SysTick_CTRL_COUNTFLAG_Msk;
+            }
+            break;
+        case 0x100: if (write) s_nvicEnabled |= nvic->ISER[0]; break;
+        case 0x180: if (write) s_nvicEnabled &= ~nvic->ICER[0]; break;
+        case 0x200: if (write) s_nvicPending |= nvic->ISPR[0]; break;
+        case 0x280: if (write) s_nvicPending &= ~nvic->ICPR[0]; break;
+        case 0xD04:                                     // ICSR: pend / unpend SysTick
+            if (write && (scb->ICSR & SCB_ICSR_PENDSTCLR_Msk))
+                s_sysTickPending = 0;
+            else if (write && (scb->ICSR & SCB_ICSR_PENDSTSET_Msk) && !s_sysTickPending)
+                s_sysTickPending = 1;
+            break;
+        case 0xD0C:                                     // AIRCR
+            if (write && (scb->AIRCR & SCB_AIRCR_SYSRESETREQ_Msk))
+                Sim_Exit(0);
+            break;
+        default:
+            break;
+    }
+
+    nvic->ISER[0] = nvic->ICER[0] = s_nvicEnabled;
+    nvic->ISPR[0] = nvic->ICPR[0] = s_nvicPending;
+    Sim_IcsrRefresh();
+}
+
+static void Sim_ExtiAfter(uint32_t offset, uint32_t old, uint8_t write)
+{
+    EXTI_TypeDef *exti = SIM_ALIAS(EXTI);
+
+    if (!write)
+        return;
+    if (offset == 0x0C)                                 // RPR1 / FPR1: write 1 to clear
+        exti->RPR1 = old & ~exti->RPR1;
+    else if (offset == 0x10)
+        exti->FPR1 = old & ~exti->FPR1;
+}
+
+static uint32_t Sim_ExtiLines(void)
+{
+    const EXTI_TypeDef *exti = SIM_ALIAS(EXTI);
+    uint32_t active = (exti->RPR1 | exti->FPR1) & exti->IMR1;
+    uint32_t lines = 0;
+
+    if (active & 0x0003u) lines |= 1u << EXTI0_1_IRQn;
+    if (active & 0x000Cu) lines |= 1u << EXTI2_3_IRQn;
+    if (active & 0xFFF0u) lines |= 1u << EXTI4_15_IRQn;
+    return lines;
+}
+
+// =====================================================================
+// Model update and interrupt delivery
+// =====================================================================
+static void Sim_TimersAdvance(uint64_t dtNs, uint32_t timClk)
+{
+    for (uint8_t i = 0; i < SIM_TIMERS; i++)
+    {
+        Sim_TimerAdvance(&s_timers[i], dtNs, timClk);
+        Sim_TimerDma(&s_timers[i]);
+    }
+}
+
+// Drive the generator's pin to its next level and schedule the edge after
+static void Sim_PinPwmEdge(Sim_PinPwm *g)
+{
+    uint16_t bit = (uint16_t)(1u << g->pin);
+    uint8_t high = (s_pinLevel[g->port] & bit) ? 0 : 1;
+
+    if (g->highNs == 0 || g->highNs >= g->periodNs)     // 0 % / 100 %: constant, check once a period
+    {
+        high = (g->highNs != 0);
+        g->nextNs += g->periodNs;
+    }
+    else
+        g->nextNs += high ? g->highNs : g->periodNs - g->highNs;
+
+    s_pinDriven[g->port] |= bit;
+    if (high)
+        s_pinLevel[g->port] |= bit;
+    else
+        s_pinLevel[g->port] &= (uint16_t)~bit;
+    Sim_GpioRefresh((uint8_t)g->port);
+}
+
+// TI1 of TIM16 / TIM17 from an internal clock (TISEL)
+typedef struct
+{
+    uint8_t timer;              // index in s_timers
+    uint8_t level;
+    uint32_t hz;                // 0 = pin input
+    uint64_t startNs;
+    uint64_t edges;             // edges since startNs
+    uint64_t nextNs;
+} Sim_TimerRef;
+
+static Sim_TimerRef s_timerRefs[2] = { { 4, 0, 0, 0, 0, 0 }, { 5, 0, 0, 0, 0, 0 } };
+
+static uint32_t Sim_TimerRefHz(const Sim_TimerRef *r)
+{
+    const RCC_TypeDef *rcc = SIM_ALIAS(RCC);
+    uint32_t sel = SIM_ALIAS(s_timers[r->timer].tim)->TISEL & TIM_TISEL_TI1SEL;
+
+    if (r->timer == 4 && sel == 1u)                     // TIM16: LSI
+        return (rcc->CSR & RCC_CSR_LSIRDY) ? 32000u : 0u;
+    if (r->timer == 4 && sel == 2u)                     // TIM16: LSE
+        return (rcc->BDCR & RCC_BDCR_LSERDY) ? 32768u : 0u;
+    if (r->timer == 5 && sel == 1u)                     // TIM17: HSE / 32
+        return (rcc->CR & RCC_CR_HSERDY) ? _SIM_HSE_HZ / 32u : 0u;
+    return 0;
+}
+
+static void Sim_TimerRefEdge(Sim_TimerRef *r)
+{
+    r->level ^= 1u;
+    r->edges++;
+    r->nextNs = r->startNs + ((r->edges + 1u) * SIM_NS) / (2u * r->hz);
+    Sim_TimerEdge(&s_timers[r->timer], 0, r->level);
+}
+
+static void Sim_Update(void)
+{
+    uint64_t now = Sim_HostNs();
+    uint64_t dt = now - s_lastNs;
+    s_lastNs = now;
+
+    if (s_runNs && now - s_startNs >= s_runNs)
+        Sim_Exit(0);
+    if (dt > 10u * SIM_NS)                              // suspended: skip the gap
+        dt = 0;
+
+    for (uint8_t i = 0; i < SIM_LPTIMS; i++)
+        Sim_LptimAdvance(&s_lptims[i], dt);
+    if (s_stopped)                                      // core clocks off
+        return;
+
+    // Timers run up to each generated pin / reference edge, so captures see the exact count
+    uint32_t timClk = Sim_GetTimerClkHz();
+    uint64_t t = now - dt;
+    for (uint8_t k = 0; k < 2; k++)                     // after a gap: carry on from now
+        if (s_pinPwm[k].port >= 0 && s_pinPwm[k].nextNs < t)
+            s_pinPwm[k].nextNs = t;
+    for (uint8_t k = 0; k < 2; k++)
+    {
+        Sim_TimerRef *r = &s_timerRefs[k];
+        uint32_t hz = Sim_TimerRefHz(r);
+        if (hz != r->hz || (hz && r->nextNs < t))       // new source, or after a gap
+        {
+            r->hz = hz;
+            r->startNs = t;
+            r->edges = 0;
+            r->nextNs = hz ? t + SIM_NS / (2u * hz) : 0;
+        }
+    }
+    for (uint32_t guard = 0; guard < 100000u; guard++)
+    {
+        Sim_PinPwm *g = 0;
+        Sim_TimerRef *r = 0;
+        uint64_t next = ~0ull;
+        for (uint8_t k = 0; k < 2; k++)
+            if (s_pinPwm[k].port >= 0 && s_pinPwm[k].nextNs < next)
+            {
+                g = &s_pinPwm[k];
+                next = g->nextNs;
+            }
+        for (uint8_t k = 0; k < 2; k++)
+            if (s_timerRefs[k].hz && s_timerRefs[k].nextNs < next)
+            {
+                r = &s_timerRefs[k];
+                next = r->nextNs;
+            }
+        if (next > now)
+            break;
+        if (next > t)
+        {
+            Sim_TimersAdvance(next - t, timClk);
+            t = next;
+        }
+        if (r)
+            Sim_TimerRefEdge(r);
+        else
+            Sim_PinPwmEdge(g);
+    }
+    Sim_TimersAdvance(now - t, timClk);
+    Sim_SysTickAdvance(dt);
+    Sim_IcsrRefresh();
+    for (uint8_t i = 0; i < SIM_USARTS; i++)
+        Sim_UsartUpdate(&s_usarts[i]);
+}
+
+static uint32_t Sim_Lines(void)
+{
+    uint32_t lines = s_nvicPending | Sim_DmaLines() | Sim_ExtiLines();
+
+    for (uint8_t i = 0; i < SIM_TIMERS; i++)
+        lines |= Sim_TimerLines(&s_timers[i]);
+    for (uint8_t i = 0; i < SIM_USARTS; i++)
+        lines |= Sim_UsartLines(&s_usarts[i]);
+    for (uint8_t i = 0; i < SIM_LPTIMS; i++)
+        lines |= Sim_LptimLines(&s_lptims[i]);
+    return lines & s_nvicEnabled;
+}
+
+static uint8_t Sim_IrqPriority(uint8_t irq)
+{
+    const NVIC_Type *nvic = SIM_ALIAS(NVIC);
+    return (uint8_t)(nvic->IP[irq >> 2] >> (8u * (irq & 3u)));
+}
+
+static void Sim_Deliver(void)
+{
+    if (s_inIrq || s_primask)
+        return;
+
+    s_inIrq = 1;
+    for (uint16_t guard = 0; guard < 10000u; guard++)
+    {
+        const SysTick_Type *st = SIM_ALIAS(SysTick);
+        if (s_sysTickPending && (st->CTRL & SysTick_CTRL_TICKINT_Msk))
+        {
+            s_sysTickPending--;
+            s_ipsr = 15u;
+            if (SysTick_Handler)
+                SysTick_Handler();
+            s_ipsr = 0;
+            continue;
+        }
+        s_sysTickPending = 0;
+
+        uint32_t lines = Sim_Lines();
+        if (!lines)
+            break;
+
+        // Lowest priority value first, then lowest IRQ number (NVIC order)
+        uint8_t best = 0xFFu;
+        for (uint8_t irq = 0; irq < 32; irq++)
+            if ((lines & (1u << irq)) &&
+                (best == 0xFFu || Sim_IrqPriority(irq) < Sim_IrqPriority(best)))
+                best = irq;
+
+        s_nvicPending &= ~(1u << best);
+        if (s_vectors[best])
+        {
+            s_ipsr = (uint8_t)(16u + best);
+            s_vectors[best]();
+            s_ipsr = 0;
+        }
+        else
+        {
+            fprintf(stderr, "sim: IRQ %u enabled without a handler, disabled\n", best);
+            s_nvicEnabled &= ~(1u << best);
+        }
+    }
+    s_inIrq = 0;
+}
+
+// Hold the background tick off while the API changes model state
+static void Sim_Enter(void)
+{
+    s_busy = 1;
+}
+
+static void Sim_Leave(void)
+{
+    s_busy = 0;
+    if (s_tickMissed)
+    {
+        s_tickMissed = 0;
+        Sim_Service();
+    }
+}
+
+// =====================================================================
+// Trap handlers
+// =====================================================================
+static void Sim_Protect(Sim_Region *r, int prot)
+{
+    mprotect((void *)r->base, r->size, prot);
+}
+
+static void Sim_BeforeAccess(uintptr_t addr)
+{
+    (void)addr;
+    Sim_Update();
+}
+
+static void Sim_AfterAccess(uintptr_t addr, uint32_t old, uint8_t write)
+{
+    for (uint8_t i = 0; i < SIM_TIMERS; i++)
+    {
+        uintptr_t base = (uintptr_t)s_timers[i].tim;
+        if (addr >= base && addr < base + 0x400u)
+        {
+            Sim_TimerAfter(&s_timers[i], (uint32_t)(addr - base), old, write);
+            return;
+        }
+    }
+    for (uint8_t i = 0; i < SIM_USARTS; i++)
+    {
+        uintptr_t base = (uintptr_t)s_usarts[i].uart;
+        if (addr >= base && addr < base + 0x400u)
+        {
+            Sim_UsartAfter(&s_usarts[i], (uint32_t)(addr - base), old, write);
+            return;
+        }
+    }
+    for (uint8_t i = 0; i < SIM_LPTIMS; i++)
+    {
+        uintptr_t base = (uintptr_t)s_lptims[i].lptim;
+        if (addr >= base && addr < base + 0x400u)
+        {
+            Sim_LptimAfter(&s_lptims[i], (uint32_t)(addr - base), old, write);
+            return;
+        }
+    }
+    if (addr >= IOPORT_BASE && addr < IOPORT_BASE + 0x2000u)
+    {
+        int8_t idx = Sim_PortIndex((GPIO_TypeDef *)(addr & ~0x3FFu));
+        if (idx >= 0)
+            Sim_GpioAfter((uint8_t)idx, (uint32_t)(addr & 0x3FFu), old, write);
+        return;
+    }
+    if (addr >= RCC_BASE && addr < RCC_BASE + 0x400u)
+        Sim_RccAfter((uint32_t)(addr - RCC_BASE), write);
+    else if (addr >= DMA1_BASE && addr < DMA1_BASE + 0x400u)
+        Sim_DmaAfter((uint32_t)(addr - DMA1_BASE), old, write);
+    else if (addr >= DMAMUX1_BASE && addr < DMAMUX1_BASE + 0x400u)
+        Sim_DmaAfter(0xFFFu, old, 0);
+    else if (addr >= EXTI_BASE && addr < EXTI_BASE + 0x400u)
+        Sim_ExtiAfter((uint32_t)(addr - EXTI_BASE), old, write);
+    else if (addr >= SCS_BASE && addr < SCS_BASE + 0x1000u)
+        Sim_ScsAfter((uint32_t)(addr - SCS_BASE), old, write);
+}
+
+static void Sim_OnFault(int sig, siginfo_t *si, void *context)
+{
+    ucontext_t *uc = (ucontext_t *)context;
+    uintptr_t addr = (uintptr_t)si->si_addr;
+    Sim_Region *r = Sim_FindRegion(addr);
+
+    if (!r)
+    {
+        signal(sig, SIG_DFL);                           // a real crash: fault again, for real
+        Sim_RestoreTerminal();
+        return;
+    }
+
+    s_accRegion = r;
+    s_accAddr = addr & ~(uintptr_t)3u;
+    s_accWrite = (uc->uc_mcontext.gregs[REG_ERR] & SIM_PF_WRITE) ? 1u : 0u;
+    Sim_BeforeAccess(s_accAddr);
+    s_accOld = *(uint32_t *)(r->alias + (s_accAddr - r->base));
+
+    Sim_Protect(r, PROT_READ | PROT_WRITE);
+    s_accAlarmBlocked = (uint8_t)sigismember(&uc->uc_sigmask, SIGALRM);
+    sigaddset(&uc->uc_sigmask, SIGALRM);
+    uc->uc_mcontext.gregs[REG_EFL] |= SIM_EFLAGS_TF;
+}
+
+static void Sim_OnStep(int sig, siginfo_t *si, void *context)
+{
+    ucontext_t *uc = (ucontext_t *)context;
+    (void)sig;
+    (void)si;
+
+    if (!(uc->uc_mcontext.gregs[REG_EFL] & SIM_EFLAGS_TF) || !s_accRegion)
+        return;
+
+    uc->uc_mcontext.gregs[REG_EFL] &= ~SIM_EFLAGS_TF;
+    if (!s_accAlarmBlocked)
+        sigdelset(&uc->uc_sigmask, SIGALRM);
+
+    Sim_Region *r = s_accRegion;
+    s_accRegion = 0;
+    Sim_Protect(r, PROT_NONE);
+
+    uint32_t now = *(uint32_t *)(r->alias + (s_accAddr - r->base));
+    Sim_AfterAccess(s_accAddr, s_accOld, (uint8_t)(s_accWrite || now != s_accOld));
+    Sim_Deliver();
+}
+
+static void Sim_OnTick(int sig)
+{
+    (void)sig;
+    if (s_busy)
+    {
+        s_tickMissed = 1;
+        return;
+    }
+    Sim_Update();
+    Sim_Deliver();
+}
+
+// =====================================================================
+// Core (used by sim_cmsis.h)
+// =====================================================================
+void Sim_EnableIrq(void)
+{
+    Sim_Enter();
+    s_primask = 0;
+    Sim_Deliver();
+    Sim_Leave();
+}
+
+void Sim_DisableIrq(void)
+{
+    s_primask = 1;
+}
+
+uint32_t Sim_GetPrimask(void)
+{
+    return s_primask;
+}
+
+uint32_t Sim_GetIpsr(void)
+{
+    return s_ipsr;
+}
+
+void Sim_SetPrimask(uint32_t primask)
+{
+    if (primask & 1u)
+        s_primask = 1;
+    else
+        Sim_EnableIrq();
+}
+
+// SLEEPDEEP with LPMS = Stop 0/1: only the LPTIMs keep counting and only
+// EXTI / LPTIM / RTC lines wake. On the way out SYSCLK is HSI16 again and
+// the PLL and HSE are off, as on silicon.
+#define SIM_STOP_WAKE  ((1u << EXTI0_1_IRQn) | (1u << EXTI2_3_IRQn) | (1u << EXTI4_15_IRQn) | \
+                        (1u << LPTIM1_IRQn) | (1u << LPTIM2_IRQn) | (1u << RTC_TAMP_IRQn))
+
+static void Sim_StopExit(void)
+{
+    RCC_TypeDef *rcc = SIM_ALIAS(RCC);
+
+    s_stopped = 0;
+    rcc->CR &= ~(RCC_CR_PLLON | RCC_CR_PLLRDY | RCC_CR_HSEON | RCC_CR_HSERDY);
+    rcc->CR |= RCC_CR_HSION | RCC_CR_HSIRDY;
+    rcc->CFGR &= ~(RCC_CFGR_SW | RCC_CFGR_SWS);
+}
+
+void Sim_WaitForInterrupt(void)
+{
+    Sim_Enter();
+    Sim_Update();
+    const SCB_Type *scb = SIM_ALIAS(SCB);
+    const PWR_TypeDef *pwr = SIM_ALIAS(PWR);
+    if ((scb->SCR & SCB_SCR_SLEEPDEEP_Msk) && (pwr->CR1 & PWR_CR1_LPMS) <= PWR_CR1_LPMS_0 &&
+        !Sim_Lines() && !s_sysTickPending)
+        s_stopped = 1;
+    Sim_Leave();
+
+    for (;;)
+    {
+        Sim_Enter();
+        Sim_Update();
+        uint32_t lines = Sim_Lines();
+        uint8_t wake = s_stopped ? (lines & SIM_STOP_WAKE) != 0 : (lines != 0) || s_sysTickPending;
+        if (wake && s_stopped)
+            Sim_StopExit();
+        if (wake)
+            Sim_Deliver();
+        Sim_Leave();
+        if (wake)
+            return;
+
+        struct pollfd pfd = { STDIN_FILENO, POLLIN, 0 };
+        poll(&pfd, s_stdinOpen ? 1 : 0, 1);             // sleep until input or 1 ms
+    }
+}
+
+// =====================================================================
+// PUBLIC API
+// =====================================================================
+void Sim_SetPin(GPIO_TypeDef *port, uint8_t pin, uint8_t level)
+{
+    int8_t idx = Sim_PortIndex(port);
+    if (idx < 0 || pin > 15)
+        return;
+
+    Sim_Enter();
+    s_pinDriven[idx] |= (uint16_t)(1u << pin);
+    if (level)
+        s_pinLevel[idx] |= (uint16_t)(1u << pin);
+    else
+        s_pinLevel[idx] &= (uint16_t)~(1u << pin);
+    Sim_GpioRefresh((uint8_t)idx);
+    Sim_Deliver();
+    Sim_Leave();
+}
+
+void Sim_SetPinPwm(GPIO_TypeDef *port, uint8_t pin, uint32_t periodNs, uint32_t highNs)
+{
+    int8_t idx = Sim_PortIndex(port);
+    if (idx < 0 || pin > 15)
+        return;
+
+    Sim_Enter();
+    Sim_Update();
+    Sim_PinPwm *g = 0;
+    for (uint8_t k = 0; k < 2; k++)                     // same pin, else a free slot
+        if (s_pinPwm[k].port == idx && s_pinPwm[k].pin == pin)
+            g = &s_pinPwm[k];
+    for (uint8_t k = 0; !g && k < 2; k++)
+        if (s_pinPwm[k].port < 0)
+            g = &s_pinPwm[k];
+    if (g)
+    {
+        g->port = periodNs ? idx : -1;
+        g->pin = pin;
+        g->periodNs = periodNs;
+        g->highNs = highNs;
+        g->nextNs = s_lastNs;
+        s_pinLevel[idx] &= (uint16_t)~(1u << pin);     // first edge rises now
+    }
+    Sim_Leave();
+}
+
+uint8_t Sim_GetPin(GPIO_TypeDef *port, uint8_t pin)
+{
+    int8_t idx = Sim_PortIndex(port);
+    if (idx < 0 || pin > 15)
+        return 0;
+
+    const GPIO_TypeDef *gpio = SIM_ALIAS(port);
+    uint32_t mode = (gpio->MODER >> (2u * pin)) & 3u;
+    uint32_t reg = (mode == 1u) ? gpio->ODR : gpio->IDR;
+    return (uint8_t)((reg >> pin) & 1u);
+}
+
+void Sim_UsartFeed(USART_TypeDef *uart, const uint8_t *data, uint16_t len)
+{
+    for (uint8_t i = 0; i < SIM_USARTS; i++)
+    {
+        Sim_Usart *u = &s_usarts[i];
+        if (u->uart != uart)
+            continue;
+
+        Sim_Enter();
+        while (len-- && (uint16_t)(u->head - u->tail) < SIM_RX_FIFO - 1u)
+            u->fifo[(u->head++) % SIM_RX_FIFO] = *data++;
+        Sim_UsartUpdate(u);
+        Sim_Deliver();
+        Sim_Leave();
+    }
+}
+
+void Sim_SetTxHook(Sim_TxHook hook)
+{
+    s_txHook = hook;
+}
+
+uint64_t Sim_Micros(void)
+{
+    return (Sim_HostNs() - s_startNs) / 1000u;
+}
+
+void Sim_Service(void)
+{
+    Sim_Enter();
+    s_tickMissed = 0;
+    Sim_Update();
+    Sim_Deliver();
+    s_busy = 0;
+}
+
+// =====================================================================
+// Start up: map the regions, reset values, hooks, tick
+// =====================================================================
+static void Sim_Reset(void)
+{
+    RCC_TypeDef *rcc = SIM_ALIAS(RCC);
+    rcc->CR = RCC_CR_HSION | RCC_CR_HSIRDY;
+    rcc->ICSCR = 64u << RCC_ICSCR_HSITRIM_Pos;
+    rcc->PLLCFGR = 0x00001000u;
+    rcc->CSR = 0x0C000000u;
+    SIM_ALIAS(FLASH)->ACR = 0x00000600u;
+    SIM_ALIAS(PWR)->CR1 = 0x00000208u;
+
+    for (uint8_t i = 0; i < 6; i++)
+    {
+        if (!s_ports[i])
+            continue;
+        GPIO_TypeDef *gpio = SIM_ALIAS(s_ports[i]);
+        gpio->MODER = (i == 0) ? 0xEBFFFFFFu : 0xFFFFFFFFu;
+        gpio->PUPDR = (i == 0) ? 0x24000000u : 0u;
+        gpio->OSPEEDR = (i == 0) ? 0x0C000000u : 0u;
+        Sim_GpioRefresh(i);
+    }
+
+    for (uint8_t i = 0; i < SIM_TIMERS; i++)
+        SIM_ALIAS(s_timers[i].tim)->ARR = s_timers[i].cntMask;
+
+    for (uint8_t i = 0; i < SIM_USARTS; i++)
+        SIM_ALIAS(s_usarts[i].uart)->ISR = USART_ISR_TXE_TXFNF | USART_ISR_TC;
+
+    *(volatile uint32_t *)&SIM_ALIAS(SCB)->CPUID = 0x410CC601u;       // read only to firmware
+    *(volatile uint32_t *)&SIM_ALIAS(SysTick)->CALIB = 0x40000000u;
+}
+
+__attribute__((constructor))
+static void Sim_Init(void)
+{
+    for (uint8_t i = 0; i < SIM_REGIONS; i++)
+    {
+        Sim_Region *r = &s_regions[i];
+        int fd = memfd_create("sim-periph", 0);
+        if (fd < 0 || ftruncate(fd, (off_t)r->size) < 0)
+        {
+            perror("sim: memfd");
+            _exit(1);
+        }
+        void *dev = mmap((void *)r->base, r->size, PROT_NONE,
+                         MAP_SHARED | MAP_FIXED_NOREPLACE, fd, 0);
+        void *alias = mmap(0, r->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (dev != (void *)r->base || alias == MAP_FAILED)
+        {
+            fprintf(stderr, "sim: cannot map 0x%08lx (build with -no-pie)\n", (unsigned long)r->base);
+            _exit(1);
+        }
+        r->alias = (uint8_t *)alias;
+        close(fd);
+    }
+
+    Sim_Reset();
+    setvbuf(stdout, 0, _IONBF, 0);                      // printf and TDR bytes stay in order
+
+    const char *run = getenv("SIM_RUN_MS");
+    const char *hsi = getenv("SIM_HSI_PPM");
+    s_hsiPpm = hsi ? (int32_t)strtol(hsi, 0, 10) : 0;
+    s_startNs = s_lastNs = Sim_HostNs();
+    s_runNs = run ? (uint64_t)strtoull(run, 0, 10) * 1000000u : 0u;
+
+    if (isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &s_termSaved) == 0)
+    {
+        struct termios raw = s_termSaved;
+        raw.c_lflag &= ~(tcflag_t)(ICANON | ECHO);      // keys go straight to RDR, Ctrl-C still works
+        raw.c_iflag &= ~(tcflag_t)(ICRNL);
+        raw.c_cc[VMIN] = 1;
+        raw.c_cc[VTIME] = 0;
+        tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+        s_rawTty = 1;
+        atexit(Sim_RestoreTerminal);
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sigemptyset(&sa.sa_mask);
+    sigaddset(&sa.sa_mask, SIGALRM);
+    sa.sa_flags = SA_SIGINFO | SA_NODEFER | SA_RESTART;
+    sa.sa_sigaction = Sim_OnFault;
+    sigaction(SIGSEGV, &sa, 0);
+    sa.sa_sigaction = Sim_OnStep;
+    sigaction(SIGTRAP, &sa, 0);
+
+    sa.sa_flags = SA_RESTART;
+    sa.sa_handler = Sim_OnTick;
+    sigaction(SIGALRM, &sa, 0);
+    sa.sa_handler = Sim_OnQuit;
+    sigaction(SIGINT, &sa, 0);
+    sigaction(SIGTERM, &sa, 0);
+
+    struct itimerval it = { { 0, _SIM_TICK_US }, { 0, _SIM_TICK_US } };
+    setitimer(ITIMER_REAL, &it, 0);
+}
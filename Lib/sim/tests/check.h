@@ -0,0 +1,74 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  CHECK (host test helpers)
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   check.h
+//
+//  Each test in tests/ is a main that runs on the simulator, reports
+//  every failed check and returns non-zero if there was one
+//  (make test runs them all).
+//
+//  Usage:
+//     CHECK(Ring_Count(&ring) == 3);
+//     CHECK_EQ(Fmt_U32(buf, 42), 2);
+//     return Check_Done("ring");
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef CHECK_LIB_H
+#define CHECK_LIB_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+static unsigned s_checks = 0;
+static unsigned s_failed = 0;
+
+static inline void Check_Report(int ok, const char *what, const char *file, int line)
+{
+    s_checks++;
+    if (ok)
+        return;
+    s_failed++;
+    fprintf(stderr, "%s:%d: FAILED %s\n", file, line, what);
+}
+
+static inline void Check_ReportEq(int64_t got, int64_t want, const char *what, const char *file, int line)
+{
+    s_checks++;
+    if (got == want)
+        return;
+    s_failed++;
+    fprintf(stderr, "%s:%d: FAILED %s (got %lld, want %lld)\n",
+            file, line, what, (long long)got, (long long)want);
+}
+
+static inline void Check_ReportBytes(const void *got, uint32_t gotLen, const void *want, uint32_t wantLen,
+                                     const char *what, const char *file, int line)
+{
+    uint32_t i = 0;
+
+    s_checks++;
+    while (i < gotLen && i < wantLen && ((const uint8_t *)got)[i] == ((const uint8_t *)want)[i])
+        i++;
+    if (i == gotLen && i == wantLen)
+        return;
+    s_failed++;
+    fprintf(stderr, "%s:%d: FAILED %s (%u vs %u bytes, first difference at %u)\n",
+            file, line, what, (unsigned)gotLen, (unsigned)wantLen, (unsigned)i);
+}
+
+#define CHECK(cond)             Check_Report((cond) ? 1 : 0, #cond, __FILE__, __LINE__)
+#define CHECK_EQ(got, want)     Check_ReportEq((int64_t)(got), (int64_t)(want), #got " == " #want, __FILE__, __LINE__)
+#define CHECK_BYTES(got, gotLen, want, wantLen) \
+    Check_ReportBytes((got), (gotLen), (want), (wantLen), #got " == " #want, __FILE__, __LINE__)
+
+static inline int Check_Done(const char *name)
+{
+    printf("%s: %u checks, %u failed\n", name, s_checks, s_failed);
+    return s_failed ? 1 : 0;
+}
+
+#endif // CHECK_LIB_H
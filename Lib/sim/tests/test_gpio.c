@@ -0,0 +1,242 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  TEST: batched GPIO configuration
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   test_gpio.c
+//
+//  GPIO_ConfigureBatch against the per-pin path it replaces: from the
+//  same starting registers, a table applied in one go and the same
+//  table applied entry by entry (level, type, speed, pull, AF, then
+//  mode) have to leave MODER, OTYPER, OSPEEDR, PUPDR, AFR, ODR and
+//  IOPENR identical. The header's board table, then random tables
+//  over ports A..D and F with repeated pins. A table with one bad
+//  entry (pin 16, AF 8, pull 3, mode or speed 4, port E, a pointer
+//  inside a port or past GPIOF, not a port at all) writes nothing.
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include "stm32g031xx.h"
+#include "sim.h"
+#include "gpio.h"
+#include "check.h"
+#include <stdlib.h>
+
+#define PORTS  6                                  // A, B, C, D, (E), F
+
+typedef struct
+{
+    uint32_t moder, otyper, ospeedr, pupdr, afr[2], odr;
+} Port_Regs;
+
+typedef struct
+{
+    Port_Regs port[PORTS];
+    uint32_t iopenr;
+} Board_Regs;
+
+static GPIO_TypeDef *const s_ports[PORTS] = { GPIOA, GPIOB, GPIOC, GPIOD, 0, GPIOF };
+
+static void Board_Read(Board_Regs *pRegs)
+{
+    memset(pRegs, 0, sizeof(*pRegs));
+    for (uint8_t i = 0; i < PORTS; i++)
+    {
+        GPIO_TypeDef *g = s_ports[i];
+        if (!g)
+            continue;
+        pRegs->port[i].moder = g->MODER;
+        pRegs->port[i].otyper = g->OTYPER;
+        pRegs->port[i].ospeedr = g->OSPEEDR;
+        pRegs->port[i].pupdr = g->PUPDR;
+        pRegs->port[i].afr[0] = g->AFR[0];
+        pRegs->port[i].afr[1] = g->AFR[1];
+        pRegs->port[i].odr = g->ODR;
+    }
+    pRegs->iopenr = RCC->IOPENR;
+}
+
+static void Board_Write(const Board_Regs *pRegs)
+{
+    for (uint8_t i = 0; i < PORTS; i++)
+    {
+        GPIO_TypeDef *g = s_ports[i];
+        if (!g)
+            continue;
+        g->MODER = pRegs->port[i].moder;
+        g->OTYPER = pRegs->port[i].otyper;
+        g->OSPEEDR = pRegs->port[i].ospeedr;
+        g->PUPDR = pRegs->port[i].pupdr;
+        g->AFR[0] = pRegs->port[i].afr[0];
+        g->AFR[1] = pRegs->port[i].afr[1];
+        g->ODR = pRegs->port[i].odr;
+    }
+    RCC->IOPENR = pRegs->iopenr;
+}
+
+// A random but legal starting point (not just reset values)
+static void Board_Scramble(Board_Regs *pRegs)
+{
+    for (uint8_t i = 0; i < PORTS; i++)
+    {
+        Port_Regs *p = &pRegs->port[i];
+        p->moder = (uint32_t)rand() ^ ((uint32_t)rand() << 16);
+        p->otyper = (uint32_t)rand() & 0xFFFFu;
+        p->ospeedr = (uint32_t)rand() ^ ((uint32_t)rand() << 16);
+        p->pupdr = ((uint32_t)rand() ^ ((uint32_t)rand() << 16)) & 0x55555555u;   // never 11
+        p->afr[0] = ((uint32_t)rand() ^ ((uint32_t)rand() << 16)) & 0x77777777u;
+        p->afr[1] = ((uint32_t)rand() ^ ((uint32_t)rand() << 16)) & 0x77777777u;
+        p->odr = (uint32_t)rand() & 0xFFFFu;
+    }
+    pRegs->iopenr = (uint32_t)rand() & (RCC_IOPENR_GPIOAEN | RCC_IOPENR_GPIOBEN | RCC_IOPENR_GPIOCEN);
+}
+
+// What a main did before the batch: one call per field per pin
+static void PerPin(const _GPIO_PinConfig *pTable, uint16_t count)
+{
+    for (uint16_t i = 0; i < count; i++)
+    {
+        const _GPIO_PinConfig *c = &pTable[i];
+        int pin = c->pin;
+
+        RCC->IOPENR |= 1u << (((uintptr_t)c->pPort - IOPORT_BASE) / 0x400u);
+        if (c->level)
+            _GPIO_PinSet(c->pPort, pin);
+        else
+            _GPIO_PinClear(c->pPort, pin);
+        _GPIO_SetOutputType(c->pPort, pin, (_GPIO_OutputType)c->type);
+        _GPIO_SetSpeed(c->pPort, pin, (_GPIO_Speed)c->speed);
+        _GPIO_SetPull(c->pPort, pin, (_GPIO_Pull)c->pull);
+        _GPIO_SetPinAlternateFunction(c->pPort, pin, c->af);
+        _GPIO_SetPinMode(c->pPort, pin, (_GPIO_PinMode)c->mode);
+    }
+}
+
+static void Compare(const _GPIO_PinConfig *pTable, uint16_t count, const Board_Regs *pStart)
+{
+    Board_Regs perPin, batch;
+
+    Board_Write(pStart);
+    PerPin(pTable, count);
+    Board_Read(&perPin);
+
+    Board_Write(pStart);
+    CHECK_EQ(GPIO_ConfigureBatch(pTable, count), 1);
+    Board_Read(&batch);
+
+    for (uint8_t i = 0; i < PORTS; i++)
+    {
+        CHECK_EQ(batch.port[i].moder, perPin.port[i].moder);
+        CHECK_EQ(batch.port[i].otyper, perPin.port[i].otyper);
+        CHECK_EQ(batch.port[i].ospeedr, perPin.port[i].ospeedr);
+        CHECK_EQ(batch.port[i].pupdr, perPin.port[i].pupdr);
+        CHECK_EQ(batch.port[i].afr[0], perPin.port[i].afr[0]);
+        CHECK_EQ(batch.port[i].afr[1], perPin.port[i].afr[1]);
+        CHECK_EQ(batch.port[i].odr, perPin.port[i].odr);
+    }
+    CHECK_EQ(batch.iopenr, perPin.iopenr);
+}
+
+static void TestBoard(void)
+{
+    static const _GPIO_PinConfig s_board[] =
+    {
+        { GPIOC, 6, _GPIO_PinMode_Output, 0, 0, 0, 0, 0 },                 // status LED, off
+        { GPIOA, 4, _GPIO_PinMode_AlternateFunction, 4,
+          _GPIO_OutputType_PushPull, _GPIO_Speed_High, 0, 0 },             // TIM14_CH1
+        { GPIOA, 0, _GPIO_PinMode_Input, 0, 0, 0, _GPIO_Pull_Up, 0 },      // button
+        { GPIOA, 2, _GPIO_PinMode_AlternateFunction, 1, 0, 0, 0, 0 },      // USART2 TX
+        { GPIOA, 3, _GPIO_PinMode_AlternateFunction, 1, 0, 0, 0, 0 },      // USART2 RX
+        { GPIOB, 8, _GPIO_PinMode_AlternateFunction, 2, 0, 0, 0, 0 },      // AFR[1]
+        { GPIOB, 9, _GPIO_PinMode_Output, 0,
+          _GPIO_OutputType_OpenDrain, 0, _GPIO_Pull_Up, 1 },               // open drain, released
+        { GPIOC, 6, _GPIO_PinMode_Output, 0, 0, 0, 0, 1 },                 // later entry wins: on
+    };
+    Board_Regs start;
+
+    Board_Read(&start);                           // from the reset state
+    Compare(s_board, sizeof(s_board) / sizeof(s_board[0]), &start);
+
+    CHECK_EQ((GPIOC->MODER >> 12) & 3u, _GPIO_PinMode_Output);
+    CHECK_EQ((GPIOC->ODR >> 6) & 1u, 1u);
+    CHECK_EQ((GPIOA->AFR[0] >> 16) & 0xFu, 4u);
+    CHECK_EQ(GPIOB->AFR[1] & 0xFu, 2u);
+    CHECK(RCC->IOPENR & RCC_IOPENR_GPIOCEN);
+}
+
+static void TestRandom(void)
+{
+    static const uint8_t ports[] = { 0, 1, 2, 3, 5 };
+    _GPIO_PinConfig table[24];
+    Board_Regs start;
+
+    srand(1250);
+    for (uint16_t round = 0; round < 200; round++)
+    {
+        uint16_t count = (uint16_t)(1 + rand() % 24);
+
+        for (uint16_t i = 0; i < count; i++)
+        {
+            _GPIO_PinConfig *c = &table[i];
+            c->pPort = s_ports[ports[rand() % 5]];
+            c->pin = (uint8_t)(rand() % 16);
+            c->mode = (uint8_t)(rand() % 4);
+            c->af = (uint8_t)(rand() % 8);
+            c->type = (uint8_t)(rand() % 2);
+            c->speed = (uint8_t)(rand() % 4);
+            c->pull = (uint8_t)(rand() % 3);
+            c->level = (uint8_t)(rand() % 2);
+        }
+        Board_Scramble(&start);
+        Compare(table, count, &start);
+    }
+}
+
+static void TestRejected(void)
+{
+    static const _GPIO_PinConfig s_good = { GPIOA, 5, _GPIO_PinMode_Output, 0, 0, 0, 0, 1 };
+    _GPIO_PinConfig table[2];
+    Board_Regs before, after;
+
+    GPIO_TypeDef *const bad[] =
+    {
+        (GPIO_TypeDef *)(IOPORT_BASE + 0x1000u),  // port E: not on the G031
+        (GPIO_TypeDef *)(IOPORT_BASE + 0x0404u),  // inside GPIOB
+        (GPIO_TypeDef *)(IOPORT_BASE + 0x1800u),  // past GPIOF
+        (GPIO_TypeDef *)RCC,
+    };
+
+    Board_Scramble(&before);
+    Board_Write(&before);
+    Board_Read(&before);                          // as the registers hold it
+
+    for (uint8_t i = 0; i < 9; i++)
+    {
+        table[0] = s_good;                        // a good entry first: still nothing written
+        table[1] = s_good;
+        switch (i)
+        {
+            case 0: table[1].pin = 16; break;
+            case 1: table[1].af = 8; break;
+            case 2: table[1].pull = 3; break;
+            case 3: table[1].mode = 4; break;
+            case 4: table[1].speed = 4; break;
+            default: table[1].pPort = bad[i - 5]; break;
+        }
+        CHECK_EQ(GPIO_ConfigureBatch(table, 2), 0);
+        Board_Read(&after);
+        CHECK(memcmp(&before, &after, sizeof(before)) == 0);
+    }
+
+    CHECK_EQ(GPIO_ConfigureBatch(table, 0), 1);   // empty table: nothing to do
+    Board_Read(&after);
+    CHECK(memcmp(&before, &after, sizeof(before)) == 0);
+}
+
+int main(void)
+{
+    TestBoard();
+    TestRandom();
+    TestRejected();
+    return Check_Done("gpio");
+}
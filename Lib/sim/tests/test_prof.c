@@ -0,0 +1,104 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  TEST: profiler timestamps
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   test_prof.c
+//
+//  SysTick as a 1 ms tick with the ms counter given to the profiler:
+//  with interrupts masked across a wrap the timestamp must keep going
+//  forward (the tick is still pending), and must not jump again once
+//  the handler has run. Scopes that ran before Prof_Init stay in the
+//  report, the calibration scope does not show up.
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include "stm32g031xx.h"
+#include "sim.h"
+#include "prof.h"
+#include "usart.h"
+#include "check.h"
+
+static volatile uint32_t s_ms = 0;
+
+void SysTick_Handler(void)
+{
+    s_ms++;
+}
+
+static char s_report[2048];
+static uint16_t s_reportLen = 0;
+
+static void TxHook(USART_TypeDef *uart, uint8_t byte)
+{
+    if (uart == USART2 && s_reportLen < sizeof(s_report) - 1u)
+        s_report[s_reportLen++] = (char)byte;
+}
+
+static void TestPendingWrap(void)
+{
+    uint32_t period = SysTick->LOAD + 1u;
+
+    for (uint8_t round = 0; round < 20; round++)
+    {
+        __disable_irq();
+        uint32_t t0 = Prof_Now();
+        uint32_t ms0 = s_ms;
+
+        // Spin until SysTick has wrapped with its handler held off
+        while (!(SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) || SysTick->VAL <= SysTick->LOAD / 2u)
+            ;
+        uint32_t t1 = Prof_Now();
+        CHECK_EQ(s_ms, ms0);                             // the handler really did not run
+        uint32_t masked = Prof_Elapsed(t0, t1);
+        CHECK(masked > 0u && masked < 2u * period);
+
+        __enable_irq();                                  // the tick is taken here
+        Sim_Service();
+        uint32_t ms2 = s_ms;
+        uint32_t t2 = Prof_Now();
+        if (s_ms != ms2)                                 // the host slept past a tick
+            continue;
+        CHECK(ms2 > ms0);
+        uint32_t after = Prof_Elapsed(t1, t2);
+        CHECK(after < (ms2 - ms0) * period);             // the pending period counted once
+    }
+}
+
+static void TestInitKeepsScopes(void)
+{
+    static Prof_Scope early = PROF_SCOPE_INIT("early");
+
+    Prof_Begin(&early);
+    Prof_End(&early);
+
+    Prof_Init();
+    Prof_Init();                                         // twice: still only the user's scopes
+
+    static Prof_Scope late = PROF_SCOPE_INIT("late");
+    Prof_Begin(&late);
+    Prof_End(&late);
+
+    s_reportLen = 0;
+    Prof_Report(USART2);
+    _USART_TxFlush(USART2);
+    s_report[s_reportLen] = 0;
+
+    CHECK(strstr(s_report, "\r\nearly ") != 0);
+    CHECK(strstr(s_report, "\r\nlate ") != 0);
+    CHECK(strstr(s_report, "\r\ncal ") == 0);
+}
+
+int main(void)
+{
+    Sim_SetTxHook(TxHook);
+    _USART_Init_USART2(SystemCoreClock, 115200);
+
+    SysTick_Config(SystemCoreClock / 1000u);            // 1 ms tick
+    Prof_SetTickCounter(&s_ms);
+
+    TestInitKeepsScopes();
+    TestPendingWrap();
+
+    return Check_Done("prof");
+}
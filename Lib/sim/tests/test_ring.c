@@ -0,0 +1,326 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  TEST: ring buffer, event queue and buffered USART2
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   test_ring.c
+//
+//  ringbuf.h on its own (full / empty, wrap, high water) and the
+//  typed queue.h (full, drop count, index wrap), then the USART2
+//  rings through the simulator: a TX burst longer than the ring
+//  comes out whole and in order (also with interrupts masked), RX
+//  bytes come back in order, a full RX ring drops and counts, and
+//  peek / consume walk the ring when DMA receive is off. With DMA
+//  receive on, a ring of unread bytes reads as full and a longer
+//  burst counts what it overwrote.
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include "stm32g031xx.h"
+#include "sim.h"
+#include "ringbuf.h"
+#include "queue.h"
+#include "usart.h"
+#include "check.h"
+
+#define TX_LEN  600u                     // over twice _USART_TX_BUFFSIZE
+
+static uint8_t s_tx[1024];
+static uint32_t s_txLen = 0;
+
+static void TxHook(USART_TypeDef *uart, uint8_t byte)
+{
+    if (uart == USART2 && s_txLen < sizeof(s_tx))
+        s_tx[s_txLen++] = byte;
+}
+
+// Let the simulated line deliver until n bytes wait (or 50 ms pass)
+static void WaitRx(uint16_t n)
+{
+    uint64_t start = Sim_Micros();
+
+    while (_USART_RxAvailable() < n && Sim_Micros() - start < 50000u)
+        Sim_Service();
+    Sim_Service();
+}
+
+static void TestRing(void)
+{
+    uint8_t store[8];
+    Ring_Buffer ring;
+    uint8_t c = 0;
+
+    Ring_Init(&ring, store, sizeof(store));
+    CHECK_EQ(Ring_Count(&ring), 0);
+    CHECK_EQ(Ring_Free(&ring), 7);
+    CHECK(!Ring_Get(&ring, &c));
+
+    for (uint8_t i = 0; i < 7; i++)
+        CHECK(Ring_Put(&ring, (uint8_t)('a' + i)));
+    CHECK(!Ring_Put(&ring, 'x'));                    // one slot stays empty
+    CHECK_EQ(Ring_Count(&ring), 7);
+    CHECK_EQ(Ring_Free(&ring), 0);
+    CHECK_EQ(ring.highWater, 7);
+
+    for (uint8_t i = 0; i < 7; i++)
+    {
+        CHECK(Ring_Get(&ring, &c));
+        CHECK_EQ(c, 'a' + i);
+    }
+    CHECK(!Ring_Get(&ring, &c));
+
+    // Many laps, 3 in / 3 out: order kept across the wrap
+    uint8_t next = 0, expect = 0;
+    for (uint16_t lap = 0; lap < 100; lap++)
+    {
+        for (uint8_t i = 0; i < 3; i++)
+            CHECK(Ring_Put(&ring, next++));
+        for (uint8_t i = 0; i < 3; i++)
+        {
+            CHECK(Ring_Get(&ring, &c));
+            CHECK_EQ(c, expect++);
+        }
+    }
+    CHECK_EQ(Ring_Count(&ring), 0);
+    CHECK_EQ(ring.highWater, 7);
+}
+
+typedef struct
+{
+    uint32_t stamp;
+    uint8_t id;
+} Test_Event;
+
+QUEUE_DEFINE(Test_Queue, Test_Event, 16)
+
+// queue.h: every slot usable, full drops and counts, order kept
+// while the 8-bit indices wrap past 255
+static void TestQueue(void)
+{
+    static Test_Queue q;
+    Test_Event ev = { 0, 0 };
+    uint32_t put = 0, got = 0;
+
+    CHECK_EQ(Test_Queue_Get(&q, &ev), 0);
+    for (uint8_t i = 0; i < 16; i++)
+    {
+        Test_Event *pEv = Test_Queue_Reserve(&q);
+        CHECK(pEv != 0);
+        pEv->stamp = put++;
+        pEv->id = i;
+        Test_Queue_Commit(&q);
+    }
+    CHECK_EQ(Test_Queue_Count(&q), 16);
+    CHECK(Test_Queue_Reserve(&q) == 0);              // full: nothing reserved
+    CHECK_EQ(q.dropped, 1);
+
+    for (uint16_t round = 0; round < 100; round++)   // 100 x 5 in and out: wraps twice
+    {
+        for (uint8_t i = 0; i < 5; i++)
+        {
+            CHECK(Test_Queue_Get(&q, &ev));
+            CHECK_EQ(ev.stamp, got++);
+        }
+        for (uint8_t i = 0; i < 5; i++)
+        {
+            Test_Event *pEv = Test_Queue_Reserve(&q);
+            CHECK(pEv != 0);
+            pEv->stamp = put++;
+            Test_Queue_Commit(&q);
+        }
+    }
+    CHECK_EQ(Test_Queue_Count(&q), 16);
+    CHECK_EQ(q.dropped, 1);
+
+    Test_Queue_Flush(&q);
+    CHECK_EQ(Test_Queue_Count(&q), 0);
+    CHECK_EQ(q.dropped, 0);
+    CHECK_EQ(Test_Queue_Get(&q, &ev), 0);
+}
+
+static void TestUsartTx(void)
+{
+    static char msg[TX_LEN + 1];
+
+    for (uint32_t i = 0; i < TX_LEN; i++)
+        msg[i] = (char)('A' + i % 26u);
+    msg[TX_LEN] = 0;
+
+    s_txLen = 0;
+    _USART_TxString(USART2, msg);                    // waits only while the ring is full
+    _USART_TxFlush(USART2);
+    CHECK_BYTES(s_tx, s_txLen, msg, TX_LEN);
+
+    _USART_Stats stats;
+    _USART_GetStats(&stats);
+    CHECK(stats.txHighWater >= 1 && stats.txHighWater < _USART_TX_BUFFSIZE);   // the sim line never backs up
+
+    s_txLen = 0;
+    CHECK_EQ(_USART_TxStringNB(USART2, "nb"), 2);
+    _USART_TxFlush(USART2);
+    CHECK_BYTES(s_tx, s_txLen, "nb", 2u);
+}
+
+static void TestUsartRx(void)
+{
+    uint8_t in[100];
+    char c;
+
+    for (uint8_t i = 0; i < sizeof(in); i++)
+        in[i] = (uint8_t)(i * 7u + 1u);
+
+    // In order through the ring
+    _USART_ClearStats();
+    Sim_UsartFeed(USART2, in, 40);
+    WaitRx(40);
+    CHECK_EQ(_USART_RxAvailable(), 40);
+    for (uint8_t i = 0; i < 40; i++)
+    {
+        CHECK(_USART_RxByte(USART2, &c));
+        CHECK_EQ((uint8_t)c, in[i]);
+    }
+    CHECK(!_USART_RxByte(USART2, &c));
+
+    // Nobody reading: the ring keeps the first 63 and counts the rest
+    Sim_UsartFeed(USART2, in, sizeof(in));
+    WaitRx(_USART_RX_BUFFSIZE - 1);
+    for (uint16_t n = 0; n < 200; n++)
+        Sim_Service();
+
+    _USART_Stats stats;
+    _USART_GetStats(&stats);
+    CHECK_EQ(_USART_RxAvailable(), _USART_RX_BUFFSIZE - 1);
+    CHECK_EQ(stats.rxDropped, sizeof(in) - (_USART_RX_BUFFSIZE - 1));
+    for (uint8_t i = 0; i < _USART_RX_BUFFSIZE - 1; i++)
+    {
+        CHECK(_USART_RxByte(USART2, &c));
+        CHECK_EQ((uint8_t)c, in[i]);
+    }
+}
+
+static void TestUsartPeek(void)
+{
+    uint8_t in[48];
+    uint8_t got[48];
+    uint16_t have = 0;
+    const uint8_t *span;
+
+    for (uint8_t i = 0; i < sizeof(in); i++)
+        in[i] = (uint8_t)(0xA0u + i);
+
+    // The ring read position is 40 + 63 = 103 -> 39: 48 bytes wrap
+    Sim_UsartFeed(USART2, in, sizeof(in));
+    WaitRx(sizeof(in));
+    CHECK_EQ(_USART_RxAvailable(), sizeof(in));
+
+    uint16_t first = _USART_RxPeek(&span);
+    CHECK(first > 0 && first < sizeof(in));          // stops at the end of the ring
+    while (have < sizeof(in))
+    {
+        uint16_t n = _USART_RxPeek(&span);
+        if (!n)
+            break;
+        memcpy(&got[have], span, n);
+        have = (uint16_t)(have + n);
+        _USART_RxConsume(n);
+    }
+    CHECK_BYTES(got, have, in, sizeof(in));
+    CHECK_EQ(_USART_RxAvailable(), 0);
+
+    _USART_RxConsume(5);                             // more than waiting: no effect
+    CHECK_EQ(_USART_RxAvailable(), 0);
+    CHECK_EQ(_USART_RxPeek(&span), 0);
+}
+
+// A burst over the ring with interrupts masked (a fault handler, a
+// print in a critical section): drained by polling, not a hang
+static void TestUsartTxMasked(void)
+{
+    s_txLen = 0;
+    __disable_irq();
+    for (uint32_t i = 0; i < TX_LEN; i++)
+        _USART_TxByte(USART2, (char)(i * 5u + 1u));
+    _USART_TxFlush(USART2);
+    CHECK_EQ(s_txLen, TX_LEN);
+    __enable_irq();
+
+    for (uint32_t i = 0; i < s_txLen; i++)
+        CHECK_EQ(s_tx[i], (uint8_t)(i * 5u + 1u));
+}
+
+// The simulator hands a whole feed to DMA at once: feed at most half
+// a ring per step so HT / TC come in between, as they do on the wire
+static void FeedDma(const uint8_t *data, uint16_t len)
+{
+    while (len)
+    {
+        uint16_t n = (len < _USART_DMA_RXSIZE / 2u) ? len : _USART_DMA_RXSIZE / 2u;
+
+        Sim_UsartFeed(USART2, data, n);
+        for (uint8_t i = 0; i < 4; i++)
+            Sim_Service();
+        data += n;
+        len = (uint16_t)(len - n);
+    }
+}
+
+// DMA receive: exactly a ring of unread bytes is full, not empty;
+// a longer burst keeps the newest ring's worth and counts the rest
+static void TestUsartDmaRx(void)
+{
+    static uint8_t in[_USART_DMA_RXSIZE + 40];
+    _USART_Stats stats;
+    const uint8_t *span;
+    char c;
+
+    for (uint16_t i = 0; i < sizeof(in); i++)
+        in[i] = (uint8_t)(i * 7u + 3u);
+
+    _USART_EnableRxDMA();
+    _USART_ClearStats();
+
+    FeedDma(in, 10);                                 // move off position 0 first
+    CHECK_EQ(_USART_RxAvailable(), 10);
+    _USART_RxConsume(10);
+
+    FeedDma(in, _USART_DMA_RXSIZE);
+    CHECK_EQ(_USART_RxAvailable(), _USART_DMA_RXSIZE);
+    CHECK_EQ(_USART_RxPeek(&span), _USART_DMA_RXSIZE - 10);   // up to the end of the ring
+    for (uint16_t i = 0; i < _USART_DMA_RXSIZE; i++)
+    {
+        CHECK(_USART_RxByte(USART2, &c));
+        CHECK_EQ((uint8_t)c, in[i]);
+    }
+    CHECK_EQ(_USART_RxAvailable(), 0);
+    _USART_GetStats(&stats);
+    CHECK_EQ(stats.rxDropped, 0);
+
+    FeedDma(in, sizeof(in));
+    CHECK_EQ(_USART_RxAvailable(), _USART_DMA_RXSIZE);
+    _USART_GetStats(&stats);
+    CHECK_EQ(stats.rxDropped, sizeof(in) - _USART_DMA_RXSIZE);
+    for (uint16_t i = sizeof(in) - _USART_DMA_RXSIZE; i < sizeof(in); i++)
+    {
+        CHECK(_USART_RxByte(USART2, &c));
+        CHECK_EQ((uint8_t)c, in[i]);
+    }
+    CHECK_EQ(_USART_RxAvailable(), 0);
+
+    _USART_DisableRxDMA();
+}
+
+int main(void)
+{
+    TestRing();
+    TestQueue();
+
+    Sim_SetTxHook(TxHook);
+    _USART_Init_USART2(SystemCoreClock, 115200);
+    TestUsartTx();
+    TestUsartTxMasked();
+    TestUsartRx();
+    TestUsartPeek();
+    TestUsartDmaRx();
+
+    return Check_Done("ring");
+}
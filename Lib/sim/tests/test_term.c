@@ -0,0 +1,362 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  TEST: terminal renderer
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   test_term.c
+//
+//  Frames go through Term_FlushTo into a capturing writer:
+//   - hand-worked frames are compared byte for byte (cursor home,
+//     CUP, CUF, resend over a short gap, CR LF, erase to end of
+//     line, the last-column wrap, repaint)
+//   - random frames are played into a small VT100 model, whose
+//     screen has to match what was drawn after every flush
+//   - Lab02's status box through a run of key presses: bytes per
+//     frame against redrawing every line, as UI_Refresh does now
+//  Then Term_Flush once through USART2.
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include "stm32g031xx.h"
+#include "sim.h"
+#include "term.h"
+#include "check.h"
+#include <stdlib.h>
+
+static char s_out[8192];
+static uint16_t s_outLen = 0;
+static uint16_t s_calls = 0;
+static uint16_t s_biggest = 0;
+
+static void Writer(const char *data, uint16_t len)
+{
+    if (s_outLen + len <= sizeof(s_out))
+        memcpy(&s_out[s_outLen], data, len);
+    s_outLen = (uint16_t)(s_outLen + len);
+    s_calls++;
+    if (len > s_biggest)
+        s_biggest = len;
+}
+
+static uint16_t Flush(void)
+{
+    s_outLen = 0;
+    s_calls = 0;
+    return Term_FlushTo(Writer);
+}
+
+#define CHECK_FRAME(expect)                                                   \
+    do {                                                                      \
+        uint16_t sent = Flush();                                              \
+        CHECK_EQ(sent, sizeof(expect) - 1u);                                  \
+        CHECK_BYTES(s_out, s_outLen, expect, (uint32_t)(sizeof(expect) - 1u)); \
+    } while (0)
+
+// ======================================================
+// VT100 model: the sequences the renderer uses
+// ======================================================
+static char s_screen[_USART_ROWS][_USART_COLS];
+static int s_row = 0, s_col = 0;
+static int s_pendingWrap = 0;
+static int s_bad = 0;                     // sequence the model does not know
+
+static void Vt_Clear(void)
+{
+    memset(s_screen, ' ', sizeof(s_screen));
+}
+
+static void Vt_Play(const char *p, uint16_t len)
+{
+    const char *end = p + len;
+
+    while (p < end)
+    {
+        char c = *p++;
+
+        if (c == '\r')
+        {
+            s_col = 0;
+            s_pendingWrap = 0;
+        }
+        else if (c == '\n')
+        {
+            if (s_row == _USART_ROWS - 1)
+                s_bad++;                                  // would scroll
+            else
+                s_row++;
+            s_pendingWrap = 0;
+        }
+        else if (c == '\033')
+        {
+            int n[2] = { 0, 0 }, count = 0;
+
+            if (p >= end || *p++ != '[')
+            {
+                s_bad++;
+                continue;
+            }
+            while (p < end && ((*p >= '0' && *p <= '9') || *p == ';'))
+            {
+                if (*p == ';')
+                    count++;
+                else if (count < 2)
+                    n[count] = n[count] * 10 + (*p - '0');
+                p++;
+            }
+            if (p >= end)
+            {
+                s_bad++;
+                break;
+            }
+            switch (*p++)
+            {
+                case 'H':
+                    s_row = (n[0] ? n[0] : 1) - 1;
+                    s_col = (n[1] ? n[1] : 1) - 1;
+                    break;
+                case 'C':
+                    s_col += n[0] ? n[0] : 1;
+                    if (s_col > _USART_COLS - 1)
+                        s_col = _USART_COLS - 1;
+                    break;
+                case 'K':
+                    memset(&s_screen[s_row][s_col], ' ', (size_t)(_USART_COLS - s_col));
+                    break;
+                case 'J':
+                    if (n[0] == 2)
+                        Vt_Clear();
+                    else
+                        s_bad++;
+                    break;
+                default:
+                    s_bad++;
+                    break;
+            }
+            s_pendingWrap = 0;
+        }
+        else
+        {
+            if (s_pendingWrap)
+            {
+                s_bad++;                                  // renderer never relies on the wrap
+                s_col = 0;
+                s_row++;
+                s_pendingWrap = 0;
+            }
+            s_screen[s_row][s_col] = c;
+            if (s_col == _USART_COLS - 1)
+                s_pendingWrap = 1;
+            else
+                s_col++;
+        }
+    }
+}
+
+// ======================================================
+// Tests
+// ======================================================
+static void TestFrames(void)
+{
+    Term_Init(0);                                         // cursor position unknown
+
+    Term_PutStringXY(1, 1, "Hi");
+    CHECK_FRAME("\033[HHi");
+
+    CHECK_EQ(Flush(), 0);                                 // nothing changed: nothing sent
+    CHECK_EQ(s_calls, 0);
+
+    Term_PutStringXY(1, 1, "Ho");                         // one cell, behind the cursor
+    CHECK_FRAME("\033[1;2Ho");
+
+    Term_PutCharXY(10, 1, 'X');                           // 7 ahead: CUF beats CUP
+    CHECK_FRAME("\033[7CX");
+
+    Term_PutCharXY(13, 1, 'Y');                           // 2 ahead: resend the two blanks
+    CHECK_FRAME("  Y");
+
+    Term_PutCharXY(1, 2, 'Z');                            // start of the next row
+    CHECK_FRAME("\r\nZ");
+
+    Term_PutStringXY(1, 1, "             ");              // row 1 blank again: erase
+    CHECK_FRAME("\033[H\033[K");
+
+    Term_PutCharXY(1, 3, 'A');                            // gap of 2 joined, 15 skipped
+    Term_PutCharXY(4, 3, 'B');
+    Term_PutCharXY(20, 3, 'C');
+    CHECK_FRAME("\033[3;1HA  B\033[15CC");
+
+    Term_PutCharXY(_USART_COLS, 5, 'E');                  // last column, then absolute moves
+    Term_PutCharXY(1, 6, 'F');
+    CHECK_FRAME("\033[5;80HE\033[6;1HF");
+
+    Term_Clear();                                         // every row dirty, only changes go
+    Term_PutCharXY(1, 2, 'Z');
+    Term_PutCharXY(1, 3, 'A');
+    Term_PutCharXY(4, 3, 'B');
+    Term_PutCharXY(20, 3, 'C');
+    Term_PutCharXY(_USART_COLS, 5, 'E');
+    CHECK_FRAME("\033[6;1H ");                             // one blank: cheaper than ESC [ K
+
+    Term_Invalidate();                                    // full repaint
+    CHECK_FRAME("\033[2J\033[H\r\nZ\r\nA  B\033[15CC\033[5;80HE");
+}
+
+static void TestRandom(void)
+{
+    static char drawn[_USART_ROWS][_USART_COLS];
+    char text[12];
+
+    srand(1250);
+    Term_Init(0);
+    Vt_Clear();
+    memset(drawn, ' ', sizeof(drawn));
+    s_row = s_col = 0;
+    s_pendingWrap = 0;
+    s_bad = 0;
+    s_biggest = 0;
+
+    Term_Invalidate();                                    // model and renderer agree from here
+
+    for (uint16_t frame = 0; frame < 300; frame++)
+    {
+        uint8_t edits = (uint8_t)(rand() % 12);
+
+        if (frame % 50 == 49)
+        {
+            Term_Clear();
+            memset(drawn, ' ', sizeof(drawn));
+        }
+        for (uint8_t e = 0; e < edits; e++)
+        {
+            uint8_t row = (uint8_t)(1 + rand() % _USART_ROWS);
+            uint8_t col = (uint8_t)(1 + rand() % _USART_COLS);
+            uint8_t len = (uint8_t)(rand() % (sizeof(text) - 1));
+
+            for (uint8_t i = 0; i < len; i++)
+                text[i] = (rand() % 3) ? (char)('!' + rand() % 94) : ' ';
+            text[len] = 0;
+
+            Term_PutStringXY(col, row, text);
+            for (uint8_t i = 0; i < len && col + i <= _USART_COLS; i++)
+                drawn[row - 1][col - 1 + i] = text[i];
+        }
+
+        uint16_t sent = Flush();
+        CHECK_EQ(sent, s_outLen);
+        Vt_Play(s_out, s_outLen);
+        if (memcmp(s_screen, drawn, sizeof(drawn)) != 0)
+        {
+            CHECK(!"screen matches the frame");
+            break;
+        }
+    }
+    CHECK_EQ(s_bad, 0);
+    CHECK(s_biggest <= _TERM_STAGE_SIZE);                 // writer gets staged chunks
+}
+
+// ======================================================
+// Lab02 status box (rows 5..11) as UI_Refresh draws it
+// after each key, full lines with _USART_TxStringXY
+// ======================================================
+static uint16_t Lab02_Status(uint8_t on, uint8_t duty, char lines[7][_USART_COLS + 1])
+{
+    char bar[51];
+    uint16_t direct = 0;
+
+    for (uint8_t i = 0; i < 50; i++)
+        bar[i] = (i < duty / 2u) ? '=' : ' ';
+    bar[50] = 0;
+
+    snprintf(lines[0], _USART_COLS + 1, "+-- PWM STATUS %.*s+", 63, "---------------------------------------------------------------");
+    snprintf(lines[1], _USART_COLS + 1, "| State:      %-64s|", on ? "ACTIVE" : "IDLE (STOPPED)");
+    snprintf(lines[2], _USART_COLS + 1, "| Frequency:  %-64s|", "1000.000 Hz  (PSC 0, ARR 63999, 15-bit duty, 0 ppm)");
+    snprintf(lines[3], _USART_COLS + 1, "| Duty Cycle: %3u%%%-60s|", duty, "");
+    snprintf(lines[4], _USART_COLS + 1, "| Duty Bar:   [%s]       |", bar);
+    snprintf(lines[5], _USART_COLS + 1, "| Output Pin: PA4  (TIM14_CH1)%-48s|", "");
+    snprintf(lines[6], _USART_COLS + 1, "+%.*s+", 77, "-----------------------------------------------------------------------------");
+
+    for (uint8_t i = 0; i < 7; i++)
+        direct = (uint16_t)(direct + 7u + strlen(lines[i]));   // ESC [ r ; 1 H + the line
+    return direct;
+}
+
+static void TestLab02Refresh(void)
+{
+    static const char keys[] = "++++++-- 5 9+0";
+    char lines[7][_USART_COLS + 1];
+    uint8_t on = 1, duty = 50;
+    uint32_t direct = 0, term = 0;
+
+    Term_Init(0);
+    Vt_Clear();
+    s_row = s_col = 0;
+    s_pendingWrap = 0;
+    s_bad = 0;
+    Term_Invalidate();
+
+    Lab02_Status(on, duty, lines);
+    for (uint8_t i = 0; i < 7; i++)
+        Term_PutStringXY(1, (uint8_t)(5 + i), lines[i]);
+    Flush();
+    Vt_Play(s_out, s_outLen);
+
+    for (uint8_t k = 0; k < sizeof(keys) - 1u; k++)
+    {
+        char key = keys[k];
+
+        if (key == '+')
+            duty = (uint8_t)((duty > 95) ? 100 : duty + 5);
+        else if (key == '-')
+            duty = (uint8_t)((duty < 5) ? 0 : duty - 5);
+        else if (key == ' ')
+            on = (uint8_t)!on;
+        else
+            duty = (uint8_t)((key - '0') * 10);
+
+        direct += Lab02_Status(on, duty, lines);
+        for (uint8_t i = 0; i < 7; i++)
+            Term_PutStringXY(1, (uint8_t)(5 + i), lines[i]);
+        term += Flush();
+        Vt_Play(s_out, s_outLen);
+        for (uint8_t i = 0; i < 7; i++)
+            CHECK(memcmp(s_screen[4 + i], lines[i], strlen(lines[i])) == 0);
+    }
+    CHECK_EQ(s_bad, 0);
+
+    uint32_t frames = sizeof(keys) - 1u;
+    CHECK(term * 4u < direct);                            // a key changes a few cells, not 7 lines
+    printf("term: Lab02 status refresh %lu bytes/frame (%lu redrawing every line)\n",
+           (unsigned long)(term / frames), (unsigned long)(direct / frames));
+}
+
+static char s_usartOut[256];
+static uint16_t s_usartLen = 0;
+
+static void TxHook(USART_TypeDef *uart, uint8_t byte)
+{
+    if (uart == USART2 && s_usartLen < sizeof(s_usartOut))
+        s_usartOut[s_usartLen++] = (char)byte;
+}
+
+static void TestUsart(void)
+{
+    Sim_SetTxHook(TxHook);
+    _USART_Init_USART2(SystemCoreClock, 115200);
+
+    Term_Init(USART2);                                    // clears the screen, cursor home
+    Term_PutStringXY(1, 1, "ok");
+    CHECK_EQ(Term_Flush(), 2);
+    _USART_TxFlush(USART2);
+
+    static const char expect[] = "\033[2J\033[Hok";
+    CHECK_BYTES(s_usartOut, s_usartLen, expect, (uint32_t)(sizeof(expect) - 1u));
+}
+
+int main(void)
+{
+    TestFrames();
+    TestRandom();
+    TestLab02Refresh();
+    TestUsart();
+    return Check_Done("term");
+}
@@ -0,0 +1,118 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  TEST: timer helpers
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   test_timer.c
+//
+//  Timer_SetDeadTime over the whole range of TIM1: only DTG is ever
+//  written in BDTR (the gaps between the DTG ranges, 255 and 505..511
+//  steps, used to spill into MOE / LOCK), the time applied never goes
+//  past the request by more than one step and grows with it.
+//  Duty on the 32-bit TIM2: nothing cut to 16 bits, no overflow in
+//  the percent scaling.
+//  Timer_KeepTiming across SYSCLK switches: ARR (and CCR) scale with
+//  PSC kept while that fits, PSC moves only when ARR would not.
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include "stm32g031xx.h"
+#include "sim.h"
+#include "Timer.h"
+#include "clock.h"
+#include "check.h"
+
+static void TestDeadTime(void)
+{
+    uint32_t tickNs = 1000000000u / SystemCoreClock;    // 62 ns at 16 MHz
+    uint32_t last = 0;
+    uint32_t bad = 0;
+
+    RCC->APBENR2 |= RCC_APBENR2_TIM1EN;
+    TIM1->BDTR = 0;
+
+    for (uint32_t ns = 0; ns <= 4u * 1100u * tickNs; ns += 5u)
+    {
+        uint32_t applied = Timer_SetDeadTime(TIM1, ns);
+
+        if ((TIM1->BDTR & ~TIM_BDTR_DTG) != 0u       // MOE, LOCK, ... untouched
+            || applied < last                        // monotonic
+            || applied > ns + 64u * tickNs)          // at most one x4 16-step late
+            bad++;
+        last = applied;
+    }
+    CHECK_EQ(bad, 0);
+    CHECK_EQ(TIM1->BDTR & TIM_BDTR_DTG, 0xFFu);      // clamped to the maximum
+
+    // The two gaps at tDTS = tCK_INT
+    CHECK_EQ(Timer_SetDeadTime(TIM1, 255u * 1000u / 16u), 254u * 1000u / 16u);
+    CHECK_EQ(TIM1->BDTR, 0xBFu);
+    CHECK_EQ(Timer_SetDeadTime(TIM1, 509u * 1000u / 16u), 504u * 1000u / 16u);
+    CHECK_EQ(TIM1->BDTR, 0xDFu);
+}
+
+static void TestDuty32(void)
+{
+    RCC->APBENR1 |= RCC_APBENR1_TIM2EN;
+
+    TIM2->ARR = 0xFFFFFFFFu;                         // 2^32 counts
+    CHECK_EQ(Timer_GetARR(TIM2), 0xFFFFFFFFu);
+    Timer_SetDuty(TIM2, TIMER_CHANNEL3, 0x12345678u);
+    CHECK_EQ(TIM2->CCR3, 0x12345678u);
+    Timer_SetDutyPercent(TIM2, TIMER_CHANNEL1, 50);
+    CHECK_EQ(TIM2->CCR1, 0x80000000u);
+    Timer_SetDutyPercent(TIM2, TIMER_CHANNEL2, 100);
+    CHECK_EQ(TIM2->CCR2, 0xFFFFFFFFu);               // 2^32 does not fit CCR: the top, not 0
+
+    TIM2->ARR = 99999999u;                           // 100 M counts: period * percent > 2^32
+    Timer_SetDutyPercent(TIM2, TIMER_CHANNEL4, 75);
+    CHECK_EQ(TIM2->CCR4, 75000000u);
+}
+
+static void TestRetime(void)
+{
+    RCC->APBENR1 |= RCC_APBENR1_TIM3EN;
+    RCC->APBENR2 |= RCC_APBENR2_TIM14EN | RCC_APBENR2_TIM16EN;
+
+    // At 16 MHz: TIM14 1 kHz (PSC = 15), TIM3 16 kHz 25 % (PSC = 0),
+    // TIM16 320 Hz (PSC = 0, ARR near the top)
+    TIM14->PSC = 15;
+    TIM14->ARR = 999;
+    TIM3->PSC = 0;
+    TIM3->ARR = 999;
+    TIM3->CCR1 = 250;
+    TIM16->PSC = 0;
+    TIM16->ARR = 49999;
+    TIM16->CCR1 = 10000;
+    CHECK(Timer_KeepTiming(TIM14, 1));
+    CHECK(Timer_KeepTiming(TIM3, 1));
+    CHECK(Timer_KeepTiming(TIM16, 1));
+
+    CHECK_EQ(Clock_SetSysclk(24000000u, CLOCK_SRC_HSI16), 24000000u);
+    CHECK_EQ(TIM14->PSC, 23);                        // same tick with PSC alone
+    CHECK_EQ(TIM14->ARR, 999);
+    CHECK_EQ(TIM3->PSC, 0);                          // x1.5: ARR and CCR scale
+    CHECK_EQ(TIM3->ARR, 1499);
+    CHECK_EQ(TIM3->CCR1, 375);
+    CHECK_EQ(TIM16->PSC, 1);                         // 75000 counts: PSC 2 x 37500
+    CHECK_EQ(TIM16->ARR, 37499);
+    CHECK_EQ(TIM16->CCR1, 7500);
+
+    CHECK_EQ(Clock_SetSysclk(16000000u, CLOCK_SRC_HSI16), 16000000u);
+    CHECK_EQ(TIM14->PSC, 15);                        // and back
+    CHECK_EQ(TIM3->ARR, 999);
+    CHECK_EQ(TIM3->CCR1, 250);
+    CHECK_EQ((TIM16->PSC + 1u) * (TIM16->ARR + 1u), 50000u);
+
+    CHECK(Timer_KeepTiming(TIM14, 0));
+    CHECK(Timer_KeepTiming(TIM3, 0));
+    CHECK(Timer_KeepTiming(TIM16, 0));
+}
+
+int main(void)
+{
+    TestDeadTime();
+    TestDuty32();
+    TestRetime();
+    return Check_Done("timer");
+}
@@ -1,4 +1,5 @@
-#include "timer.h"                                                                // include own header
+#include "Timer.h"                                                                // include own header
+#include "clock.h"                                                                // Clock_GetSysclkHz
 
 //==================================================================================================
 // TIM14: INIT 1MHz TICK (1us per count) like your demo: PSC = (SYSCLK/1MHz)-1
@@ -35,3 +36,584 @@ void Timer14_Delay_ms(uint16_t ms)
         Timer14_Delay_us(1000u);                                                  // 1000us = 1ms
     }                                                                             // end loop
 }                                                                                 // end function
+
+//==================================================================================================
+// GENERAL TIMER: INIT / START / STOP / UPDATE FLAG
+//==================================================================================================
+void Timer_Init(TIM_TypeDef *pTimer, uint16_t prescaler, uint16_t period)         // init PSC/ARR (actual values)
+{                                                                                 // start function
+    pTimer->CR1 &= ~TIM_CR1_CEN;                                                  // disable timer during config
+    pTimer->PSC = (uint16_t)(prescaler - 1u);                                     // registers are 0-indexed
+    pTimer->ARR = (uint16_t)(period - 1u);                                        // counts 0..period-1
+    pTimer->EGR = TIM_EGR_UG;                                                     // force update (load PSC/ARR)
+    pTimer->SR &= ~TIM_SR_UIF;                                                    // UG set UIF, clear it
+}                                                                                 // end function
+
+void Timer_Start(TIM_TypeDef *pTimer)                                             // start counting
+{                                                                                 // start function
+    pTimer->CR1 |= TIM_CR1_CEN;                                                   // counter enable
+}                                                                                 // end function
+
+void Timer_Stop(TIM_TypeDef *pTimer)                                              // stop counting
+{                                                                                 // start function
+    pTimer->CR1 &= ~TIM_CR1_CEN;                                                  // counter disable
+}                                                                                 // end function
+
+int Timer_CheckUpdateFlag(TIM_TypeDef *pTimer)                                    // poll update event
+{                                                                                 // start function
+    return (pTimer->SR & TIM_SR_UIF) ? 1 : 0;                                     // 1 = period elapsed
+}                                                                                 // end function
+
+void Timer_ClearUpdateFlag(TIM_TypeDef *pTimer)                                   // acknowledge update event
+{                                                                                 // start function
+    pTimer->SR &= ~TIM_SR_UIF;                                                    // rc_w0
+}                                                                                 // end function
+
+uint32_t Timer_GetARR(TIM_TypeDef *pTimer)                                        // read period register
+{                                                                                 // start function
+    return pTimer->ARR;                                                           // ARR (period-1), 32 bits on TIM2
+}                                                                                 // end function
+
+//==================================================================================================
+// CHANNEL HELPERS
+//   CCMR1 holds CH1 (bits 0..7) and CH2 (bits 8..15), CCMR2 holds CH3/CH4 the same way.
+//   CCER has 4 bits per channel: CCxE, CCxP, CCxNE, CCxNP.
+//==================================================================================================
+uint8_t Timer_ChannelCount(TIM_TypeDef *pTimer)                                   // channels on this timer
+{                                                                                 // start function
+    if (IS_TIM_CC4_INSTANCE(pTimer))                                              // TIM1/2/3
+        return 4u;                                                                // CH1..CH4
+    if (IS_TIM_CC1_INSTANCE(pTimer))                                              // TIM14/16/17
+        return 1u;                                                                // CH1 only
+    return 0u;                                                                    // no compare channels
+}                                                                                 // end function
+
+static uint8_t Timer_IsChannel(TIM_TypeDef *pTimer, Timer_Channel channel)        // channel exists here?
+{                                                                                 // start function
+    return (channel >= TIMER_CHANNEL1 && channel <= Timer_ChannelCount(pTimer));  // 1..count
+}                                                                                 // end function
+
+static volatile uint32_t *Timer_CCMR(TIM_TypeDef *pTimer, Timer_Channel channel)  // mode register of the channel
+{                                                                                 // start function
+    return (channel <= TIMER_CHANNEL2) ? &pTimer->CCMR1 : &pTimer->CCMR2;         // CH1/2 or CH3/4
+}                                                                                 // end function
+
+static uint32_t Timer_CCMRShift(Timer_Channel channel)                            // bit offset inside CCMRx
+{                                                                                 // start function
+    return ((uint32_t)(channel - 1u) & 1u) * 8u;                                  // odd channels 0, even 8
+}                                                                                 // end function
+
+static volatile uint32_t *Timer_CCR(TIM_TypeDef *pTimer, Timer_Channel channel)   // compare register of the channel
+{                                                                                 // start function
+    volatile uint32_t *ccr[4] = { &pTimer->CCR1, &pTimer->CCR2, &pTimer->CCR3, &pTimer->CCR4 };  // compare registers
+    return ccr[channel - 1u];                                                     // CCRx
+}                                                                                 // end function
+
+static uint32_t Timer_CCERShift(Timer_Channel channel)                            // bit offset inside CCER
+{                                                                                 // start function
+    return (uint32_t)(channel - 1u) * 4u;                                         // 4 bits per channel
+}                                                                                 // end function
+
+static uint8_t Timer_HasComplementary(TIM_TypeDef *pTimer, Timer_Channel channel) // CHxN pin exists?
+{                                                                                 // start function
+    if (pTimer == TIM1)                                                           // advanced timer
+        return (channel >= TIMER_CHANNEL1 && channel <= TIMER_CHANNEL3);          // CH1N..CH3N
+    if (pTimer == TIM16 || pTimer == TIM17)                                       // 1-channel with break
+        return (channel == TIMER_CHANNEL1);                                       // CH1N
+    return 0u;                                                                    // TIM2/3/14: none
+}                                                                                 // end function
+
+//==================================================================================================
+// PWM ON ANY CHANNEL
+//==================================================================================================
+void Timer_ConfigPWM(TIM_TypeDef *pTimer, Timer_Channel channel, Timer_PWMMode mode)  // CHx PWM mode
+{                                                                                 // start function
+    if (!Timer_IsChannel(pTimer, channel))                                        // not on this timer
+        return;                                                                   // ignore
+    volatile uint32_t *ccmr = Timer_CCMR(pTimer, channel);                        // CCMR1 or CCMR2
+    uint32_t shift = Timer_CCMRShift(channel);                                    // CH1/3 = 0, CH2/4 = 8
+    uint32_t oc = TIM_CCMR1_OC1M_2 | TIM_CCMR1_OC1M_1;                            // PWM mode 1 = 0b110
+    if (mode == TIMER_PWM_MODE2)                                                  // PWM mode 2
+        oc |= TIM_CCMR1_OC1M_0;                                                   // 0b111
+    *ccmr = (*ccmr & ~((TIM_CCMR1_OC1M | TIM_CCMR1_CC1S) << shift))               // output, clear mode bits
+          | ((oc | TIM_CCMR1_OC1PE) << shift);                                    // mode + CCR preload (glitch free)
+    if (IS_TIM_BREAK_INSTANCE(pTimer))                                            // TIM1/16/17 have a break stage
+        pTimer->BDTR |= TIM_BDTR_MOE;                                             // main output enable
+}                                                                                 // end function
+
+void Timer_SetDuty(TIM_TypeDef *pTimer, Timer_Channel channel, uint32_t duty)     // raw compare value
+{                                                                                 // start function
+    if (!Timer_IsChannel(pTimer, channel))                                        // not on this timer
+        return;                                                                   // ignore
+    *Timer_CCR(pTimer, channel) = duty;                                           // high while CNT < CCRx
+}                                                                                 // end function
+
+void Timer_SetDutyPercent(TIM_TypeDef *pTimer, Timer_Channel channel, uint8_t percent)  // duty in %
+{                                                                                 // start function
+    if (percent > 100u)                                                           // clamp
+        percent = 100u;                                                           // 100 % max
+    uint64_t period = (uint64_t)pTimer->ARR + 1u;                                 // counts per period (to 2^32)
+    uint64_t duty = (period * percent) / 100u;                                    // scale to counts
+    if (duty > 0xFFFFFFFFu)                                                       // 100 % of a 2^32 period
+        duty = 0xFFFFFFFFu;                                                       // CCR holds 32 bits
+    Timer_SetDuty(pTimer, channel, (uint32_t)duty);                               // high while CNT < CCRx
+}                                                                                 // end function
+
+void Timer_EnableOutput(TIM_TypeDef *pTimer, Timer_Channel channel)               // drive the pin
+{                                                                                 // start function
+    if (!Timer_IsChannel(pTimer, channel))                                        // not on this timer
+        return;                                                                   // ignore
+    pTimer->CCER |= TIM_CCER_CC1E << Timer_CCERShift(channel);                    // CCx output enable
+}                                                                                 // end function
+
+void Timer_DisableOutput(TIM_TypeDef *pTimer, Timer_Channel channel)              // release the pin
+{                                                                                 // start function
+    if (!Timer_IsChannel(pTimer, channel))                                        // not on this timer
+        return;                                                                   // ignore
+    pTimer->CCER &= ~(TIM_CCER_CC1E << Timer_CCERShift(channel));                 // CCx output disable
+}                                                                                 // end function
+
+void Timer_SetPolarity(TIM_TypeDef *pTimer, Timer_Channel channel, Timer_Polarity polarity)  // active high/low
+{                                                                                 // start function
+    if (!Timer_IsChannel(pTimer, channel))                                        // not on this timer
+        return;                                                                   // ignore
+    uint32_t bit = TIM_CCER_CC1P << Timer_CCERShift(channel);                     // CCxP
+    if (polarity == TIMER_POLARITY_LOW)                                           // active low
+        pTimer->CCER |= bit;                                                      // invert the pin
+    else                                                                          // active high
+        pTimer->CCER &= ~bit;                                                     // pin = OCxREF
+}                                                                                 // end function
+
+void Timer_SetPreload(TIM_TypeDef *pTimer, Timer_Channel channel, uint8_t enable) // CCR buffered or immediate
+{                                                                                 // start function
+    if (!Timer_IsChannel(pTimer, channel))                                        // not on this timer
+        return;                                                                   // ignore
+    volatile uint32_t *ccmr = Timer_CCMR(pTimer, channel);                        // CCMR1 or CCMR2
+    uint32_t bit = TIM_CCMR1_OC1PE << Timer_CCMRShift(channel);                   // OCxPE
+    if (enable)                                                                   // buffered
+        *ccmr |= bit;                                                             // CCRx takes effect at update
+    else                                                                          // immediate
+        *ccmr &= ~bit;                                                            // CCRx takes effect now
+}                                                                                 // end function
+
+//==================================================================================================
+// COMPLEMENTARY OUTPUTS + DEAD-TIME
+//   CHxN is the inverse of CHx with the dead-time inserted on both edges, so a half bridge
+//   never has both switches on. DTG encodes the dead-time in tDTS steps (tDTS = tCK_INT << CKD):
+//     0xxxxxxx  DTG[6:0] * 1          0..127
+//     10xxxxxx  (64 + DTG[5:0]) * 2   128..254
+//     110xxxxx  (32 + DTG[4:0]) * 8   256..504
+//     111xxxxx  (32 + DTG[4:0]) * 16  512..1008
+//==================================================================================================
+void Timer_EnableComplementary(TIM_TypeDef *pTimer, Timer_Channel channel,
+                               Timer_Polarity polarity)                           // drive CHxN
+{                                                                                 // start function
+    if (!Timer_HasComplementary(pTimer, channel))                                 // no CHxN here
+        return;                                                                   // ignore
+    uint32_t shift = Timer_CCERShift(channel);                                    // channel bits
+    uint32_t ccer = pTimer->CCER & ~(TIM_CCER_CC1NP << shift);                    // clear CCxNP
+    if (polarity == TIMER_POLARITY_LOW)                                           // active low
+        ccer |= TIM_CCER_CC1NP << shift;                                          // invert CHxN
+    pTimer->CCER = ccer | (TIM_CCER_CC1NE << shift);                              // CCxN output enable
+    pTimer->BDTR |= TIM_BDTR_MOE;                                                 // main output enable
+}                                                                                 // end function
+
+void Timer_DisableComplementary(TIM_TypeDef *pTimer, Timer_Channel channel)       // release CHxN
+{                                                                                 // start function
+    if (!Timer_HasComplementary(pTimer, channel))                                 // no CHxN here
+        return;                                                                   // ignore
+    pTimer->CCER &= ~(TIM_CCER_CC1NE << Timer_CCERShift(channel));                // CCxN output disable
+}                                                                                 // end function
+
+uint32_t Timer_SetDeadTime(TIM_TypeDef *pTimer, uint32_t deadTimeNs)              // program DTG
+{                                                                                 // start function
+    if (!IS_TIM_BREAK_INSTANCE(pTimer))                                           // no BDTR
+        return 0u;                                                                // nothing applied
+
+    uint32_t clkHz = Clock_GetSysclkHz();                                         // timer clock = SYSCLK (APB /1)
+    uint64_t ticks = ((uint64_t)deadTimeNs * clkHz + 500000000u) / 1000000000u;   // nearest tCK_INT count
+    uint32_t ckd = 0;                                                             // tDTS = tCK_INT << ckd
+    while (ckd < 2u && (ticks >> ckd) > 1008u)                                    // too long for DTG
+        ckd++;                                                                    // slower tDTS (x2, x4)
+    uint32_t t = (uint32_t)((ticks + ((1u << ckd) >> 1)) >> ckd);                 // in tDTS steps
+    if (t > 1008u)                                                                // still too long
+        t = 1008u;                                                                // clamp to the maximum
+
+    uint32_t dtg;                                                                 // encoded value
+    if (t <= 127u)                                                                // 1 step
+        dtg = t;                                                                  // 0xxxxxxx
+    else if (t <= 255u)                                                           // 2 steps (255 -> 254)
+    {                                                                             // start else if
+        t &= ~1u;                                                                 // round down to the step
+        dtg = 0x80u | (t / 2u - 64u);                                             // 10xxxxxx
+    }                                                                             // end else if
+    else if (t <= 511u)                                                           // 8 steps (505..511 -> 504)
+    {                                                                             // start else if
+        t &= ~7u;                                                                 // round down to the step
+        dtg = 0xC0u | (t / 8u - 32u);                                             // 110xxxxx
+    }                                                                             // end else if
+    else                                                                          // 16 steps
+    {                                                                             // start else
+        t &= ~15u;                                                                // round down to the step
+        dtg = 0xE0u | (t / 16u - 32u);                                            // 111xxxxx
+    }                                                                             // end else
+
+    pTimer->CR1 = (pTimer->CR1 & ~TIM_CR1_CKD) | (ckd << TIM_CR1_CKD_Pos);        // tDTS divider
+    pTimer->BDTR = (pTimer->BDTR & ~TIM_BDTR_DTG) | (dtg & TIM_BDTR_DTG);         // dead-time (before LOCK)
+    return (uint32_t)(((uint64_t)(t << ckd) * 1000000000u + clkHz / 2u) / clkHz); // ns actually inserted
+}                                                                                 // end function
+
+//==================================================================================================
+// MASTER / SLAVE SYNCHRONIZED START
+//   The master puts its counter enable on TRGO (MMS = 001, MSM delays the master by the
+//   synchronisation stage), the slave sits in trigger mode (SMS = 0110) on the ITRx that carries
+//   the master's TRGO, so setting CEN on the master sets CEN on every slave in the same clock.
+//   Only starting is shared: each timer still has to be stopped on its own.
+//==================================================================================================
+static int8_t Timer_ITR(TIM_TypeDef *pSlave, TIM_TypeDef *pMaster)                // ITRx of master seen by slave
+{                                                                                 // start function
+    if (pSlave == TIM1)                                                           // TIM1 slave
+        return (pMaster == TIM2) ? 1 : (pMaster == TIM3) ? 2 : -1;                // ITR1 = TIM2, ITR2 = TIM3
+    if (pSlave == TIM2)                                                           // TIM2 slave
+        return (pMaster == TIM1) ? 0 : (pMaster == TIM3) ? 2 : -1;                // ITR0 = TIM1, ITR2 = TIM3
+    if (pSlave == TIM3)                                                           // TIM3 slave
+        return (pMaster == TIM1) ? 0 : (pMaster == TIM2) ? 1 : -1;                // ITR0 = TIM1, ITR1 = TIM2
+    return -1;                                                                    // TIM14/16/17: no slave mode
+}                                                                                 // end function
+
+uint8_t Timer_SyncSlave(TIM_TypeDef *pSlave, TIM_TypeDef *pMaster)                // chain slave to master
+{                                                                                 // start function
+    int8_t itr = Timer_ITR(pSlave, pMaster);                                      // trigger input
+    if (itr < 0)                                                                  // not connected
+        return 0;                                                                 // fail
+
+    pMaster->CR2 = (pMaster->CR2 & ~TIM_CR2_MMS) | TIM_CR2_MMS_0;                 // TRGO = counter enable
+    pMaster->SMCR |= TIM_SMCR_MSM;                                                // delay master to match slaves
+
+    pSlave->CR1 &= ~TIM_CR1_CEN;                                                  // slave waits for the trigger
+    pSlave->SMCR = (pSlave->SMCR & ~(TIM_SMCR_SMS | TIM_SMCR_TS))                 // clear mode and trigger
+                 | ((uint32_t)itr << TIM_SMCR_TS_Pos)                             // TS = ITRx
+                 | TIM_SMCR_SMS_2 | TIM_SMCR_SMS_1;                               // SMS = 0110 trigger mode
+    return 1;                                                                     // linked
+}                                                                                 // end function
+
+void Timer_SyncRelease(TIM_TypeDef *pSlave)                                       // unlink a slave
+{                                                                                 // start function
+    if (!IS_TIM_SLAVE_INSTANCE(pSlave))                                           // TIM14/16/17
+        return;                                                                   // nothing to undo
+    pSlave->SMCR &= ~(TIM_SMCR_SMS | TIM_SMCR_TS);                                // slave mode disabled
+}                                                                                 // end function
+
+//==================================================================================================
+// PWM FREQUENCY SOLVER
+//   f = timerClk / (prescaler * period). The best duty resolution is the largest period, i.e. the
+//   smallest prescaler, so the search walks prescaler upward from the smallest one that fits the
+//   counter and stops at the first candidate inside the error bound. If nothing fits, the
+//   closest candidate is reported and 0 returned. All maths in mHz, integer only.
+//==================================================================================================
+static uint8_t Timer_Log2(uint64_t value)                                         // floor(log2(value))
+{                                                                                 // start function
+    uint8_t bits = 0;                                                             // result
+    while (value > 1u)                                                            // until one bit left
+    {                                                                             // start loop
+        value >>= 1;                                                              // drop a bit
+        bits++;                                                                   // count it
+    }                                                                             // end loop
+    return bits;                                                                  // bit depth
+}                                                                                 // end function
+
+uint8_t Timer_SolvePWM(uint32_t timerClkHz, uint64_t target_mHz, uint32_t maxErrorPpm,
+                       uint32_t maxPeriod, Timer_PWMSolution *pSol)              // search PSC/ARR
+{                                                                                 // start function
+    if (!pSol)                                                                    // nowhere to report
+        return 0;                                                                 // fail
+    *pSol = (Timer_PWMSolution){ 0 };                                             // all zero = no candidate
+    if (!target_mHz || maxPeriod < 2u)                                            // nothing to solve
+        return 0;                                                                 // fail
+
+    uint64_t clk_mHz = (uint64_t)timerClkHz * 1000u;                              // timer clock in mHz
+    uint64_t total = (clk_mHz + target_mHz / 2u) / target_mHz;                    // ideal prescaler * period
+    if (total < 2u)                                                               // above timerClk / 2
+        return 0;                                                                 // fail
+
+    uint64_t psc = (total + maxPeriod - 1u) / maxPeriod;                          // smallest prescaler that fits
+    if (psc == 0u)                                                                // very high frequency
+        psc = 1u;                                                                 // no division
+    uint8_t found = 0;                                                            // inside the bound yet?
+    uint64_t bestPpm = ~0ull;                                                     // closest so far
+
+    for (; psc <= 65536u; psc++)                                                  // walk prescaler upward
+    {                                                                             // start loop
+        uint64_t step = target_mHz * psc;                                         // mHz per count of period
+        uint64_t period = (clk_mHz + step / 2u) / step;                           // nearest period
+        if (period > maxPeriod)                                                   // rounded past the counter
+            continue;                                                             // next prescaler
+        if (period < 2u)                                                          // no duty left to resolve
+            break;                                                                // stop
+
+        uint64_t made = target_mHz * psc * period;                                // clk_mHz if exact
+        uint64_t diff = (clk_mHz > made) ? (clk_mHz - made) : (made - clk_mHz);   // |error| in clock units
+        uint64_t ppm = (diff * 1000000u + made / 2u) / made;                      // relative error
+
+        if (ppm < bestPpm)                                                        // closer than before
+        {                                                                         // start if
+            bestPpm = ppm;                                                        // remember
+            pSol->prescaler = (uint32_t)psc;                                      // divider
+            pSol->period = (uint32_t)period;                                      // counts per cycle
+            pSol->actual_mHz = (clk_mHz + (psc * period) / 2u) / (psc * period);  // achieved frequency
+            pSol->errorPpm = (clk_mHz >= made) ? (int32_t)ppm : -(int32_t)ppm;    // faster = positive
+            pSol->bits = Timer_Log2(period);                                      // duty resolution
+        }                                                                         // end if
+        if (ppm <= maxErrorPpm)                                                   // first fit = largest period
+        {                                                                         // start if
+            found = 1;                                                            // done
+            break;                                                                // stop searching
+        }                                                                         // end if
+    }                                                                             // end loop
+    return found;                                                                 // 1 = inside bound
+}                                                                                 // end function
+
+uint8_t Timer_SetFrequency(TIM_TypeDef *pTimer, uint64_t target_mHz,
+                           uint32_t maxErrorPpm, Timer_PWMSolution *pSol)         // solve + apply
+{                                                                                 // start function
+    Timer_PWMSolution sol;                                                        // local result
+    uint32_t maxPeriod = IS_TIM_32B_COUNTER_INSTANCE(pTimer) ? 0xFFFFFFFFu : 0x10000u;  // counter width
+
+    uint8_t ok = Timer_SolvePWM(Clock_GetSysclkHz(), target_mHz, maxErrorPpm, maxPeriod, &sol);  // timer clock = SYSCLK (APB /1)
+    if (pSol)                                                                     // caller wants the numbers
+        *pSol = sol;                                                              // copy (closest if not ok)
+    if (!ok)                                                                      // outside the bound
+        return 0;                                                                 // leave the timer alone
+
+    uint64_t oldPeriod = (uint64_t)pTimer->ARR + 1u;                              // for rescaling the duty
+    volatile uint32_t *ccr[4] = { &pTimer->CCR1, &pTimer->CCR2, &pTimer->CCR3, &pTimer->CCR4 };  // compare registers
+    uint8_t channels = Timer_ChannelCount(pTimer);                                // channels present
+
+    pTimer->PSC = sol.prescaler - 1u;                                             // new prescaler
+    pTimer->ARR = sol.period - 1u;                                                // new period
+    for (uint8_t ch = 0; ch < channels; ch++)                                     // keep each duty ratio
+        *ccr[ch] = (uint32_t)(((uint64_t)*ccr[ch] * sol.period + oldPeriod / 2u) / oldPeriod);  // scale CCR
+    pTimer->EGR = TIM_EGR_UG;                                                     // load PSC/ARR/CCR now, CNT = 0
+    pTimer->SR &= ~TIM_SR_UIF;                                                    // UG set UIF, clear it
+    return 1;                                                                     // applied
+}                                                                                 // end function
+
+void Timer_SetDutyQ16(TIM_TypeDef *pTimer, Timer_Channel channel, uint32_t duty)  // duty as a 16-bit fraction
+{                                                                                 // start function
+    if (duty > 0x10000u)                                                          // clamp
+        duty = 0x10000u;                                                          // 100 %
+    if (!Timer_IsChannel(pTimer, channel))                                        // not on this timer
+        return;                                                                   // ignore
+    uint64_t period = (uint64_t)pTimer->ARR + 1u;                                 // counts per cycle
+    *Timer_CCR(pTimer, channel) = (uint32_t)((period * duty + 0x8000u) >> 16);    // nearest count (32-bit on TIM2)
+}                                                                                 // end function
+
+//==================================================================================================
+// SIGMA-DELTA / DITHERED PWM
+//   target counts = value * period / 2^bits = base + frac / 2^bits. Only frac is noise shaped:
+//     v = frac + err1            (1st order)     v = frac + 2*err1 - err2      (2nd order)
+//     q = v rounded to counts,   CCR = base + q, err = v - q * 2^bits
+//   Everything stays in 32 bits (|v| < 4 * 2^bits), a few cycles per period on the M0+.
+//   Within one count of 0 % / 100 % the 2nd order swing would be clipped (biasing the average),
+//   so it runs 1st order there.
+//==================================================================================================
+void Timer_DitherInit(Timer_Dither *pDither, TIM_TypeDef *pTimer, Timer_Channel channel,
+                      uint8_t order, uint8_t bits)                                // attach to a PWM channel
+{                                                                                 // start function
+    if (!pDither || !Timer_IsChannel(pTimer, channel))                            // nothing to drive
+        return;                                                                   // ignore
+    if (bits < 1u || bits > 24u)                                                  // keep v inside 32 bits
+        bits = 16u;                                                               // default 16-bit
+    pDither->pTimer = pTimer;                                                     // remember the output
+    pDither->channel = channel;                                                   // CCRx
+    pDither->order = (order == 2u) ? 2u : 1u;                                     // 1st unless 2nd asked
+    pDither->bits = bits;                                                         // value resolution
+    pDither->period = pTimer->ARR + 1u;                                           // counts per PWM period
+    pDither->err1 = 0;                                                            // no error yet
+    pDither->err2 = 0;                                                            // no error yet
+    Timer_DitherSet(pDither, 0u);                                                 // start at 0 %
+}                                                                                 // end function
+
+void Timer_DitherSet(Timer_Dither *pDither, uint32_t value)                       // new target
+{                                                                                 // start function
+    uint32_t full = 1ul << pDither->bits;                                         // 100 %
+    if (value > full)                                                             // clamp
+        value = full;                                                             // 100 %
+    uint64_t counts = (uint64_t)value * pDither->period;                          // target, Q(bits)
+
+    uint32_t primask = __get_PRIMASK();                                           // base + frac as one
+    __disable_irq();                                                              // (Tick may run in between)
+    pDither->base = (uint32_t)(counts >> pDither->bits);                          // whole counts
+    pDither->frac = (int32_t)(counts & (full - 1u));                              // fraction of a count
+    __set_PRIMASK(primask);                                                       // restore
+}                                                                                 // end function
+
+uint32_t Timer_DitherNext(Timer_Dither *pDither)                                  // one modulator step
+{                                                                                 // start function
+    int32_t one = (int32_t)(1ul << pDither->bits);                                // one count, Q(bits)
+    int32_t v = pDither->frac + pDither->err1;                                    // 1st order: CCR base..base+1
+    if (pDither->order == 2u && pDither->base >= 1u &&                            // 2nd order: base-1..base+2,
+        pDither->base + 2u <= pDither->period)                                    // only where that fits
+        v += pDither->err1 - pDither->err2;                                       // frac + 2*err1 - err2
+
+    int32_t q = (v + (one >> 1)) >> pDither->bits;                                // nearest whole count
+    int32_t out = (int32_t)pDither->base + q;                                     // CCR candidate
+    if (out < 0)                                                                  // below 0 %
+        out = 0;                                                                  // clamp
+    else if (out > (int32_t)pDither->period)                                      // above 100 %
+        out = (int32_t)pDither->period;                                           // clamp
+
+    int32_t err = v - (out - (int32_t)pDither->base) * one;                       // what was left out
+    if (err > one)                                                                // only if the target itself
+        err = one;                                                                // is out of range: keep the
+    else if (err < -one)                                                          // error from winding up
+        err = -one;                                                               // (stays stable)
+    pDither->err2 = pDither->err1;                                                // shift history
+    pDither->err1 = err;                                                          // newest error
+    return (uint32_t)out;                                                         // CCR value
+}                                                                                 // end function
+
+void Timer_DitherTick(Timer_Dither *pDither)                                      // from TIMx_IRQHandler
+{                                                                                 // start function
+    pDither->pTimer->SR = (uint32_t)~TIM_SR_UIF;                                  // rc_w0: clears UIF only
+    *Timer_CCR(pDither->pTimer, pDither->channel) = Timer_DitherNext(pDither);    // preload: used next period
+}                                                                                 // end function
+
+void Timer_DitherFill(Timer_Dither *pDither, uint16_t *pBuf, uint16_t count)      // block for DMA streaming
+{                                                                                 // start function
+    while (count--)                                                               // every sample
+        *pBuf++ = (uint16_t)Timer_DitherNext(pDither);                            // next CCR
+}                                                                                 // end function
+
+//==================================================================================================
+// FOLLOWING SYSCLK CHANGES
+//   Runs as a clock lib listener, AFTER phase only (IRQs off, new clock already running). PSC,
+//   ARR and CCR are all preloaded here, so nothing reaches the counter before the next update.
+//   No search runs here: ARR is scaled by new / old with PSC kept, or, where that does not fit
+//   the counter, the PSC x ARR product is kept and split with the smallest PSC that fits.
+//   SysTick has no preload for VAL (any write clears it): LOAD is the next tick's length, and a
+//   tick already longer than that is cut short with the interrupt pended by hand, so no tick is
+//   lost and none runs long.
+//==================================================================================================
+static TIM_TypeDef *s_kept[_TIMER_KEEP_MAX];                                      // timers following SYSCLK
+static uint32_t s_sysTickHz = 0;                                                  // SysTick rate kept (0 = none)
+
+static uint32_t Timer_SysTickLoad(uint32_t clkHz, uint32_t tickHz)                // LOAD for tickHz at clkHz
+{                                                                                 // start function
+    return (clkHz + tickHz / 2u) / tickHz - 1u;                                   // nearest, minus the zero count
+}                                                                                 // end function
+
+static void Timer_Retime(TIM_TypeDef *pTimer, uint32_t oldHz, uint32_t newHz)     // keep one timer's timing
+{                                                                                 // start function
+    uint64_t psc = (uint64_t)pTimer->PSC + 1u;                                    // divider now
+    uint64_t scaled = psc * newHz;                                                // divider * new clock
+
+    if (scaled % oldHz == 0u && scaled / oldHz >= 1u && scaled / oldHz <= 65536u) // same tick rate with PSC alone
+    {                                                                             // start if
+        pTimer->PSC = (uint32_t)(scaled / oldHz) - 1u;                            // preloaded: from the next update
+        return;                                                                   // ARR / CCR untouched
+    }                                                                             // end if
+
+    uint64_t oldPeriod = (uint64_t)pTimer->ARR + 1u;                              // counts per cycle now
+    uint64_t maxPeriod = IS_TIM_32B_COUNTER_INSTANCE(pTimer) ? 0x100000000u : 0x10000u;  // counter width
+    uint64_t period = (oldPeriod * newHz + oldHz / 2u) / oldHz;                   // same PSC, ARR scaled
+    if (period < 2u || period > maxPeriod)                                        // does not fit: PSC moves too
+    {                                                                             // start if
+        uint64_t counts = psc * oldPeriod;                                        // PSC x ARR product (to 2^48)
+        uint64_t total = counts / oldHz * newHz                                   // kept at the new clock,
+                       + ((counts % oldHz) * newHz + oldHz / 2u) / oldHz;         // split so it cannot overflow
+        psc = (total + maxPeriod - 1u) / maxPeriod;                               // smallest PSC that fits
+        if (psc > 0x10000u)                                                       // slower than the timer goes
+            psc = 0x10000u;                                                       // slowest it can do
+        period = (total + psc / 2u) / psc;                                        // counts per cycle
+        if (period > maxPeriod)                                                   // clamped PSC
+            period = maxPeriod;                                                   // slowest period
+        if (period < 2u)                                                          // faster than it goes
+            return;                                                               // leave it running as is
+    }                                                                             // end if
+
+    uint8_t channels = Timer_ChannelCount(pTimer);                                // channels present
+    pTimer->CR1 |= TIM_CR1_ARPE;                                                  // ARR through its preload
+    for (uint8_t ch = TIMER_CHANNEL1; ch <= channels; ch++)                       // every channel
+    {                                                                             // start loop
+        uint32_t shift = Timer_CCMRShift((Timer_Channel)ch);                      // field in CCMRx
+        volatile uint32_t *ccmr = Timer_CCMR(pTimer, (Timer_Channel)ch);          // CCMR1 or CCMR2
+        if (*ccmr & (TIM_CCMR1_CC1S << shift))                                    // input capture
+            continue;                                                             // CCR is not ours to scale
+        *ccmr |= TIM_CCMR1_OC1PE << shift;                                        // CCR through its preload
+        volatile uint32_t *ccr = Timer_CCR(pTimer, (Timer_Channel)ch);            // compare register
+        *ccr = (uint32_t)(((uint64_t)*ccr * period + oldPeriod / 2u) / oldPeriod);      // same duty ratio
+    }                                                                             // end loop
+    pTimer->PSC = (uint32_t)psc - 1u;                                             // new prescaler
+    pTimer->ARR = (uint32_t)(period - 1u);                                        // new period (no UG: no cut)
+}                                                                                 // end function
+
+static void Timer_OnClockChange(Clock_ChangePhase phase, uint32_t oldHz, uint32_t newHz)  // clock lib listener
+{                                                                                 // start function
+    if (phase != CLOCK_CHANGE_AFTER || !oldHz || !newHz)                          // only once the clock moved
+        return;                                                                   // nothing to do yet
+
+    for (uint8_t i = 0; i < _TIMER_KEEP_MAX; i++)                                 // every kept timer
+        if (s_kept[i])                                                            // slot in use
+            Timer_Retime(s_kept[i], oldHz, newHz);                                // same timing, new clock
+
+    if (s_sysTickHz && (SysTick->CTRL & SysTick_CTRL_ENABLE_Msk))                 // SysTick kept and running
+    {                                                                             // start if
+        uint32_t load = Timer_SysTickLoad(newHz, s_sysTickHz);                    // next tick length
+        if (load > SysTick_LOAD_RELOAD_Msk)                                       // does not fit 24 bits
+            load = SysTick_LOAD_RELOAD_Msk;                                       // slowest it can do
+        SysTick->LOAD = load;                                                     // used at the next reload
+        if (SysTick->VAL > load)                                                  // this tick would run long
+        {                                                                         // start if
+            SysTick->VAL = 0u;                                                    // restart from the new LOAD
+            SCB->ICSR = SCB_ICSR_PENDSTSET_Msk;                                   // and count the tick now
+        }                                                                         // end if
+    }                                                                             // end if
+}                                                                                 // end function
+
+uint8_t Timer_KeepTiming(TIM_TypeDef *pTimer, uint8_t enable)                     // follow SYSCLK changes
+{                                                                                 // start function
+    uint8_t free = _TIMER_KEEP_MAX;                                               // first empty slot
+    uint8_t ok = 1;                                                               // result
+
+    uint32_t primask = __get_PRIMASK();                                           // save interrupt state
+    __disable_irq();                                                              // table vs. a switch in an ISR
+    for (uint8_t i = 0; i < _TIMER_KEEP_MAX; i++)                                 // look through the table
+    {                                                                             // start loop
+        if (s_kept[i] == pTimer)                                                  // already there
+        {                                                                         // start if
+            if (!enable)                                                          // let it go
+                s_kept[i] = 0;                                                    // free the slot
+            free = _TIMER_KEEP_MAX + 1u;                                          // handled
+            break;                                                                // done
+        }                                                                         // end if
+        if (!s_kept[i] && free == _TIMER_KEEP_MAX)                                // first hole
+            free = i;                                                             // remember it
+    }                                                                             // end loop
+    if (enable && free < _TIMER_KEEP_MAX)                                         // new entry
+        s_kept[free] = pTimer;                                                    // keep it
+    else if (enable && free == _TIMER_KEEP_MAX)                                   // table full
+        ok = 0;                                                                   // fail
+    __set_PRIMASK(primask);                                                       // restore
+
+    if (ok && enable)                                                             // something to follow
+        ok = Clock_Subscribe(Timer_OnClockChange);                                // once is enough (no duplicates)
+    return ok;                                                                    // 1 = kept / released
+}                                                                                 // end function
+
+uint8_t Timer_SysTickInit(uint32_t tickHz)                                        // SysTick tick + interrupt
+{                                                                                 // start function
+    if (!tickHz)                                                                  // no rate
+        return 0;                                                                 // fail
+    uint32_t load = Timer_SysTickLoad(Clock_GetSysclkHz(), tickHz);               // counts per tick - 1
+    if (load == 0u || load > SysTick_LOAD_RELOAD_Msk)                             // outside 24 bits
+        return 0;                                                                 // fail
+
+    s_sysTickHz = tickHz;                                                         // rate to keep
+    SysTick->LOAD = load;                                                         // reload value
+    SysTick->VAL = 0u;                                                            // clear current value
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk |                                  // use CPU clock
+                    SysTick_CTRL_TICKINT_Msk |                                    // enable interrupt
+                    SysTick_CTRL_ENABLE_Msk;                                      // enable SysTick
+    return Clock_Subscribe(Timer_OnClockChange);                                  // follow SYSCLK from now on
+}                                                                                 // end function
@@ -0,0 +1,348 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  CAPTURE
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   capture.c
+//
+//  PWM input: CC1S = 01 (TI1), CC2S = 10 (TI1 too), CC1 rising,
+//  CC2 falling, slave reset mode on TI1FP1 so CCR1 is the period.
+//  URS = 1 keeps the slave resets from setting UIF: UIF only marks a
+//  real overflow, which is what the IRQ mode extends the count with.
+//
+//  Statistics are kept in ticks against the first period of the
+//  window (deviations stay small, so their squares fit in 64 bits)
+//  and only turned into Hz / ns in Capture_Read.
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include "capture.h"
+#include "clock.h"
+
+static TIM_TypeDef *s_pTimer = 0;
+static Capture_Mode s_mode = CAPTURE_MODE_IRQ;
+static uint32_t s_tickHz = 0;
+static uint64_t s_top = 0;                 // ARR + 1
+
+// IRQ mode state
+static volatile uint32_t s_ovf = 0;        // overflows since the last rising edge
+static uint64_t s_high = 0;                // last high time (ticks)
+static uint8_t s_skip = 1;                 // next period is partial: drop it
+
+// DMA ring: { CCR1, CCR2 } per rising edge
+static uint32_t s_ring[2 * _CAPTURE_DMA_PAIRS];
+
+// Window statistics (ticks)
+static struct
+{
+    uint32_t n;
+    uint64_t sum;
+    uint64_t sumHigh;
+    uint64_t ref;              // first period
+    int64_t sumDev;            // sum of (period - ref)
+    uint64_t sumSq;            // sum of (period - ref)^2
+    uint64_t min;
+    uint64_t max;
+    uint32_t overruns;
+} s_stat;
+
+// ======================================================
+// Statistics
+// ======================================================
+static void Capture_Clear(void)
+{
+    s_stat.n = 0;
+    s_stat.sum = 0;
+    s_stat.sumHigh = 0;
+    s_stat.sumDev = 0;
+    s_stat.sumSq = 0;
+    s_stat.overruns = 0;
+}
+
+static void Capture_Record(uint64_t period, uint64_t high)
+{
+    if (!period)
+        return;
+    if (!s_stat.n)
+    {
+        s_stat.ref = period;
+        s_stat.min = period;
+        s_stat.max = period;
+    }
+
+    int64_t dev = (int64_t)(period - s_stat.ref);
+    if (dev > 0xFFFFFF)                             // clamp: squares fit 2^16 samples
+        dev = 0xFFFFFF;
+    else if (dev < -0xFFFFFF)
+        dev = -0xFFFFFF;
+
+    s_stat.n++;
+    s_stat.sum += period;
+    s_stat.sumHigh += (high < period) ? high : period;
+    s_stat.sumDev += dev;
+    s_stat.sumSq += (uint64_t)(dev * dev);
+    if (period < s_stat.min)
+        s_stat.min = period;
+    if (period > s_stat.max)
+        s_stat.max = period;
+}
+
+static uint32_t Capture_Sqrt(uint64_t x)
+{
+    uint64_t root = 0;
+    uint64_t bit = 1ull << 62;
+
+    while (bit > x)
+        bit >>= 2;
+    while (bit)
+    {
+        if (x >= root + bit)
+        {
+            x -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+            root >>= 1;
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+static uint32_t Capture_Clamp(uint64_t value)
+{
+    return (value > 0xFFFFFFFFull) ? 0xFFFFFFFFu : (uint32_t)value;
+}
+
+static uint32_t Capture_TicksToNs(uint64_t ticks)
+{
+    return Capture_Clamp((ticks * 1000000000ull + s_tickHz / 2u) / s_tickHz);
+}
+
+uint8_t Capture_Read(Capture_Result *pResult)
+{
+    if (!pResult || !s_tickHz)
+        return 0;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t n = s_stat.n;
+    uint64_t sum = s_stat.sum;
+    uint64_t sumHigh = s_stat.sumHigh;
+    int64_t sumDev = s_stat.sumDev;
+    uint64_t sumSq = s_stat.sumSq;
+    uint64_t spread = s_stat.max - s_stat.min;
+    pResult->overruns = s_stat.overruns;
+    pResult->lost = (s_mode == CAPTURE_MODE_IRQ && s_ovf >= _CAPTURE_MAX_OVERFLOWS) ? 1 : 0;
+    Capture_Clear();
+    __set_PRIMASK(primask);
+
+    pResult->samples = n;
+    pResult->freq_mHz = 0;
+    pResult->duty_ppm = 0;
+    pResult->period_ns = 0;
+    pResult->high_ns = 0;
+    pResult->jitterPk_ns = 0;
+    pResult->jitterRms_ns = 0;
+    if (!n)
+        return 0;
+
+    // Mean period in Q16 ticks keeps sub-tick resolution for the frequency
+    uint64_t meanQ16 = ((sum << 16) + n / 2u) / n;
+    if (meanQ16)
+        pResult->freq_mHz = Capture_Clamp((((uint64_t)s_tickHz * 1000u << 16) + meanQ16 / 2u) / meanQ16);
+    pResult->period_ns = Capture_TicksToNs((sum + n / 2u) / n);
+    pResult->high_ns = Capture_TicksToNs((sumHigh + n / 2u) / n);
+    pResult->jitterPk_ns = Capture_TicksToNs(spread);
+
+    while (sum >= (1ull << 40))                      // room for the x 10^6
+    {
+        sum >>= 1;
+        sumHigh >>= 1;
+    }
+    pResult->duty_ppm = (uint32_t)((sumHigh * 1000000u + sum / 2u) / sum);
+
+    // Variance (ticks^2) = E[d^2] - E[d]^2, d = period - ref; root in Q8
+    int64_t meanDev = sumDev / (int64_t)n;
+    uint64_t meanSq = (uint64_t)(meanDev * meanDev);
+    uint64_t var = sumSq / n;
+    var = (var > meanSq) ? var - meanSq : 0;
+    if (var > 0x7FFFFFFFFFFFull)
+        var = 0x7FFFFFFFFFFFull;
+    uint64_t rmsQ8 = Capture_Sqrt(var << 16);
+    pResult->jitterRms_ns = Capture_Clamp(((rmsQ8 * 1000000000ull) / s_tickHz + 128u) >> 8);
+    return 1;
+}
+
+// ======================================================
+// Setup
+// ======================================================
+static uint8_t Capture_Request(TIM_TypeDef *pTimer)
+{
+    if (pTimer == TIM2) return _CAPTURE_DMAREQ_TIM2_CH1;
+    if (pTimer == TIM3) return _CAPTURE_DMAREQ_TIM3_CH1;
+    return 0;
+}
+
+uint8_t Capture_Start(TIM_TypeDef *pTimer, uint32_t tickHz, Capture_Mode mode)
+{
+    uint32_t clk = Clock_GetSysclkHz();
+    uint8_t request = Capture_Request(pTimer);
+
+    if (!request || !tickHz || tickHz > clk)
+        return 0;
+    uint32_t psc = (clk + tickHz / 2u) / tickHz - 1u;
+    if (psc > 0xFFFFu)
+        return 0;
+
+    Capture_Stop();
+    RCC->APBENR1 |= (pTimer == TIM2) ? RCC_APBENR1_TIM2EN : RCC_APBENR1_TIM3EN;
+
+    s_pTimer = pTimer;
+    s_mode = mode;
+    s_tickHz = clk / (psc + 1u);
+    s_ovf = 0;
+    s_high = 0;
+    s_skip = 1;
+    Capture_Clear();
+
+    pTimer->CR1 = TIM_CR1_URS;                       // only overflows set UIF
+    pTimer->DIER = 0;
+    pTimer->PSC = psc;
+    pTimer->ARR = (pTimer == TIM2) ? 0xFFFFFFFFu : 0xFFFFu;
+    s_top = (uint64_t)pTimer->ARR + 1u;
+    pTimer->CCER = 0;                                // CCxS only writable with CCxE off
+    pTimer->CCMR1 = TIM_CCMR1_CC1S_0                 // CC1 <- TI1
+                  | TIM_CCMR1_CC2S_1;                // CC2 <- TI1 too
+    pTimer->CCER = TIM_CCER_CC1E                     // CC1 rising
+                 | TIM_CCER_CC2E | TIM_CCER_CC2P;    // CC2 falling
+    pTimer->SMCR = TIM_SMCR_TS_2 | TIM_SMCR_TS_0     // TS = 101: TI1FP1
+                 | TIM_SMCR_SMS_2;                   // SMS = 0100: reset mode
+    pTimer->EGR = TIM_EGR_UG;                        // load PSC
+    pTimer->SR = 0;
+    pTimer->CR1 |= TIM_CR1_CEN;                      // count first: no capture of a stopped counter
+
+    if (mode == CAPTURE_MODE_DMA)
+    {
+        RCC->AHBENR |= RCC_AHBENR_DMA1EN;
+        pTimer->DCR = (13u << TIM_DCR_DBA_Pos)       // burst from CCR1 (0x34 / 4)
+                    | (1u << TIM_DCR_DBL_Pos);       // 2 registers: CCR1, CCR2
+
+        DMA1_Channel4->CCR = 0;
+        DMAMUX1_Channel3->CCR = request;             // DMAMUX ch3 feeds DMA ch4
+        DMA1_Channel4->CPAR = (uint32_t)(uintptr_t)&pTimer->DMAR;
+        DMA1_Channel4->CMAR = (uint32_t)(uintptr_t)s_ring;
+        DMA1_Channel4->CNDTR = 2u * _CAPTURE_DMA_PAIRS;
+        DMA1->IFCR = DMA_IFCR_CGIF4;
+        DMA1_Channel4->CCR = DMA_CCR_MINC | DMA_CCR_CIRC             // periph -> mem, loop
+                           | DMA_CCR_MSIZE_1 | DMA_CCR_PSIZE_1       // 32-bit both sides
+                           | DMA_CCR_PL_0
+                           | DMA_CCR_HTIE | DMA_CCR_TCIE | DMA_CCR_TEIE;
+        DMA1_Channel4->CCR |= DMA_CCR_EN;
+        NVIC_EnableIRQ(DMA1_Ch4_5_DMAMUX1_OVR_IRQn);
+        pTimer->DIER = TIM_DIER_CC1DE;               // burst on every rising edge
+    }
+    else
+    {
+        pTimer->DIER = TIM_DIER_CC1IE | TIM_DIER_CC2IE | TIM_DIER_UIE;
+        NVIC_EnableIRQ((pTimer == TIM2) ? TIM2_IRQn : TIM3_IRQn);
+    }
+    return 1;
+}
+
+void Capture_Stop(void)
+{
+    if (!s_pTimer)
+        return;
+    s_pTimer->CR1 &= ~TIM_CR1_CEN;
+    s_pTimer->DIER = 0;
+    if (s_mode == CAPTURE_MODE_DMA)
+        DMA1_Channel4->CCR &= ~DMA_CCR_EN;
+    s_pTimer = 0;
+}
+
+uint32_t Capture_GetTickHz(void)
+{
+    return s_tickHz;
+}
+
+// ======================================================
+// IRQ mode: overflow extension
+// An overflow and an edge pending together: the rising edge resets
+// the counter, so a pending overflow always came before it; a falling
+// capture in the top half of the range came before the wrap.
+// ======================================================
+void Capture_IRQHandler(void)
+{
+    TIM_TypeDef *pTimer = s_pTimer;
+    if (!pTimer)
+        return;
+
+    uint32_t sr = pTimer->SR;
+    uint8_t wrapped = (sr & TIM_SR_UIF) ? 1 : 0;
+
+    if (sr & (TIM_SR_CC1OF | TIM_SR_CC2OF))
+    {
+        s_stat.overruns++;
+        pTimer->SR = (uint32_t)~(TIM_SR_CC1OF | TIM_SR_CC2OF);
+    }
+    if (sr & TIM_SR_CC2IF)
+    {
+        uint32_t c2 = pTimer->CCR2;                  // read clears CC2IF
+        s_high = (uint64_t)(s_ovf + ((wrapped && c2 < s_top / 2u) ? 1u : 0u)) * s_top + c2;
+    }
+    if (wrapped)
+    {
+        pTimer->SR = (uint32_t)~TIM_SR_UIF;
+        if (s_ovf < _CAPTURE_MAX_OVERFLOWS)
+            s_ovf++;
+        else
+            s_skip = 1;                              // signal lost: next period is partial
+    }
+    if (sr & TIM_SR_CC1IF)
+    {
+        uint64_t period = (uint64_t)s_ovf * s_top + pTimer->CCR1;
+        s_ovf = 0;
+        if (s_skip)
+            s_skip = 0;
+        else
+            Capture_Record(period, s_high);
+    }
+}
+
+// ======================================================
+// DMA mode: fold each finished half of the ring
+// ======================================================
+static void Capture_Fold(const uint32_t *pPairs, uint32_t count)
+{
+    for (uint32_t k = 0; k < count; k++, pPairs += 2)
+    {
+        if (s_skip)                                  // first edge after start
+        {
+            s_skip = 0;
+            continue;
+        }
+        Capture_Record(pPairs[0], pPairs[1]);
+    }
+}
+
+void DMA1_Ch4_5_DMAMUX1_OVR_IRQHandler(void)
+{
+    uint32_t isr = DMA1->ISR;
+
+    if (isr & DMA_ISR_TEIF4)
+    {
+        DMA1->IFCR = DMA_IFCR_CGIF4;
+        Capture_Stop();
+        return;
+    }
+    if (isr & DMA_ISR_HTIF4)
+    {
+        DMA1->IFCR = DMA_IFCR_CHTIF4;
+        Capture_Fold(s_ring, _CAPTURE_DMA_PAIRS / 2u);
+    }
+    if (isr & DMA_ISR_TCIF4)
+    {
+        DMA1->IFCR = DMA_IFCR_CTCIF4;
+        Capture_Fold(s_ring + _CAPTURE_DMA_PAIRS, _CAPTURE_DMA_PAIRS / 2u);
+    }
+}
@@ -1,4 +1,34 @@
-#include <clock.h>                                                               // include own header
+#include <clock.h>                                                                // include own header
+
+//==================================================================================================
+// LIMITS (RM0444 / DS12992, STM32G031)
+//==================================================================================================
+#define CLOCK_HSI_HZ        16000000u                                             // HSI16 oscillator
+#define CLOCK_PLLIN_MIN     2660000u                                              // PLL input after M: 2.66 MHz ..
+#define CLOCK_PLLIN_MAX     16000000u                                             // .. 16 MHz
+#define CLOCK_VCO_MIN       64000000u                                             // VCO: 64 MHz ..
+#define CLOCK_VCO_MAX       344000000u                                            // .. 344 MHz (range 1)
+#define CLOCK_PLLR_MIN      12000000u                                             // PLLRCLK: 12 MHz ..
+#define CLOCK_PLLR_MAX      64000000u                                             // .. 64 MHz (SYSCLK max)
+#define CLOCK_PLLP_MAX      122000000u                                            // PLLPCLK max (range 1)
+#define CLOCK_PLLQ_MAX      128000000u                                            // PLLQCLK max (range 1)
+#define CLOCK_RANGE2_MAX    16000000u                                             // SYSCLK max in range 2
+
+#define CLOCK_SW_HSI        0u                                                    // SW = 000 HSISYS
+#define CLOCK_SW_HSE        1u                                                    // SW = 001 HSE
+#define CLOCK_SW_PLL        2u                                                    // SW = 010 PLLRCLK
+
+typedef struct                                                                    // one complete SYSCLK setup
+{                                                                                 // open struct
+    uint32_t sw;                                                                  // SYSCLK switch value
+    uint32_t hsidiv;                                                              // HSIDIV field (HSISYS = HSI16 >> hsidiv)
+    uint32_t pllcfgr;                                                             // PLLCFGR value (PLL only)
+    Clock_Source src;                                                             // oscillator behind it
+    uint32_t hz;                                                                  // resulting SYSCLK
+} Clock_Setup;                                                                    // struct name
+
+static Clock_Setup s_setup = { CLOCK_SW_HSI, 0u, 0u, CLOCK_SRC_HSI16, CLOCK_HSI_HZ }; // last applied (reset state)
+static Clock_ChangeCallback s_listeners[_CLOCK_LISTENERS];                        // clock-change subscribers (0 = free)
 
 //==================================================================================================
 // INTERNAL HELPERS
@@ -9,25 +39,66 @@ static void Clock_EnableHSI16(void)
     while ((RCC->CR & RCC_CR_HSIRDY) == 0u) { }                                   // wait until ready
 }                                                                                 // end function
 
+static uint8_t Clock_EnableHSE(void)                                              // start HSE, 0 if it never comes up
+{                                                                                 // start function
+    uint32_t timeout = _CLOCK_HSE_TIMEOUT;                                        // polls before giving up (no crystal)
+
+#if _CLOCK_HSE_BYPASS                                                             // external clock, not a crystal
+    RCC->CR |= RCC_CR_HSEBYP;                                                     // bypass the oscillator
+#endif                                                                            // end bypass
+    RCC->CR |= RCC_CR_HSEON;                                                      // turn on HSE
+    while ((RCC->CR & RCC_CR_HSERDY) == 0u)                                       // wait until ready
+    {                                                                             // open loop
+        if (--timeout == 0u)                                                      // crystal not starting
+        {                                                                         // start if
+            RCC->CR &= ~RCC_CR_HSEON;                                             // give it up
+            return 0u;                                                            // fail
+        }                                                                         // end if
+    }                                                                             // end loop
+    return 1u;                                                                    // running
+}                                                                                 // end function
+
 static void Clock_EnableLSI(void)                                                 // ensure LSI is ON (needed for Part C)
 {                                                                                 // start function
     RCC->CSR |= RCC_CSR_LSION;                                                    // enable LSI oscillator
     while ((RCC->CSR & RCC_CSR_LSIRDY) == 0u) { }                                 // wait until LSI ready
 }                                                                                 // end function
 
-static void Clock_SetFlashForHighSpeed(uint32_t sysclkHz)                         // set flash wait states for faster clocks
+static uint32_t Clock_WaitStates(uint32_t hclkHz, uint8_t range2)                 // fewest flash wait states for HCLK
+{                                                                                 // start function
+    if (range2)                                                                   // range 2: 8 MHz per wait state
+        return (hclkHz <= 8000000u) ? 0u : 1u;                                    // 0WS <= 8 MHz, 1WS <= 16 MHz
+    if (hclkHz <= 24000000u) return 0u;                                           // range 1: 0WS <= 24 MHz
+    if (hclkHz <= 48000000u) return 1u;                                           // 1WS <= 48 MHz
+    return 2u;                                                                    // 2WS <= 64 MHz
+}                                                                                 // end function
+
+static uint32_t Clock_GetLatency(void)                                            // wait states in use
 {                                                                                 // start function
-    (void)sysclkHz;                                                               // unused in this simple version
-    FLASH->ACR |= FLASH_ACR_PRFTEN;                                               // enable prefetch (matches demo style)
-    FLASH->ACR &= ~FLASH_ACR_LATENCY;                                             // clear latency bits
-    FLASH->ACR |= FLASH_ACR_LATENCY_1;                                            // 1 wait-state (safe up to 64 MHz on G0)
+    return (FLASH->ACR & FLASH_ACR_LATENCY) >> FLASH_ACR_LATENCY_Pos;             // LATENCY field
 }                                                                                 // end function
 
-static void Clock_SwitchSysclkToHSI(void)                                         // temporarily switch SYSCLK to HSI
+static void Clock_SetLatency(uint32_t ws)                                         // set wait states, wait until the flash uses them
 {                                                                                 // start function
-    RCC->CFGR &= ~RCC_CFGR_SW;                                                    // clear SW bits
-    RCC->CFGR |= RCC_CFGR_SW_0;                                                   // SW = 01 (HSI selected as SYSCLK)
-    while ((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_0) { }                      // wait until switch is active
+    FLASH->ACR = (FLASH->ACR & ~FLASH_ACR_LATENCY) | FLASH_ACR_PRFTEN | (ws << FLASH_ACR_LATENCY_Pos); // new latency + prefetch
+    while (Clock_GetLatency() != ws) { }                                          // read back: takes effect before any clock change
+}                                                                                 // end function
+
+static void Clock_SetRange(uint8_t range2)                                        // core voltage range 1 or 2
+{                                                                                 // start function
+    uint32_t vos = range2 ? PWR_CR1_VOS_1 : PWR_CR1_VOS_0;                        // 10 = range 2, 01 = range 1
+
+    RCC->APBENR1 |= RCC_APBENR1_PWREN;                                            // PWR registers clocked
+    if ((PWR->CR1 & PWR_CR1_VOS) == vos)                                          // already there
+        return;                                                                   // nothing to do
+    PWR->CR1 = (PWR->CR1 & ~PWR_CR1_VOS) | vos;                                   // request the range
+    while ((PWR->SR2 & PWR_SR2_VOSF) != 0u) { }                                   // wait until the regulator settled
+}                                                                                 // end function
+
+static void Clock_SetSwitch(uint32_t sw)                                          // select SYSCLK source, wait for it
+{                                                                                 // start function
+    RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SW) | (sw << RCC_CFGR_SW_Pos);             // SW bits
+    while (((RCC->CFGR & RCC_CFGR_SWS) >> RCC_CFGR_SWS_Pos) != sw) { }            // wait until switch is active
 }                                                                                 // end function
 
 static void Clock_DisablePLL(void)                                                // safely disable PLL before reconfig
@@ -36,17 +107,84 @@ static void Clock_DisablePLL(void)
     while ((RCC->CR & RCC_CR_PLLRDY) != 0u) { }                                   // wait until PLL not ready
 }                                                                                 // end function
 
-static uint32_t Clock_ComputePLLN(uint32_t targetMHz, uint32_t pllR)              // compute N for 16MHz source
+static uint32_t Clock_SourceHz(Clock_Source src)                                  // PLL / SYSCLK oscillator frequency
+{                                                                                 // start function
+    return (src == CLOCK_SRC_HSE) ? _CLOCK_HSE_HZ : CLOCK_HSI_HZ;                 // HSE or HSI16
+}                                                                                 // end function
+
+static uint32_t Clock_AbsDiff(uint32_t a, uint32_t b)                             // |a - b|
+{                                                                                 // start function
+    return (a > b) ? a - b : b - a;                                               // no signed overflow
+}                                                                                 // end function
+
+static uint32_t Clock_PickDiv(uint32_t vcoHz, uint32_t wantHz, uint32_t lo, uint32_t hi, uint32_t maxHz) // closest P/Q divider
+{                                                                                 // start function
+    uint32_t div = (vcoHz + wantHz / 2u) / wantHz;                                // rounded VCO / want
+
+    if (div < lo) div = lo;                                                       // clamp to the field
+    if (div > hi) div = hi;                                                       // clamp to the field
+    while (div < hi && vcoHz / div > maxHz) div++;                                // keep the output legal
+    return (vcoHz / div <= maxHz) ? div : 0u;                                     // 0 = can't be made
+}                                                                                 // end function
+
+static void Clock_Notify(Clock_ChangePhase phase, uint32_t oldHz, uint32_t newHz) // call every subscriber
 {                                                                                 // start function
-    return (targetMHz * pllR) / 16u;                                              // target = 16 * N / R -> N = target*R/16
+    for (uint8_t i = 0u; i < _CLOCK_LISTENERS; i++)                               // registry order
+        if (s_listeners[i])                                                       // slot in use
+            s_listeners[i](phase, oldHz, newHz);                                  // one driver
 }                                                                                 // end function
 
-static uint32_t Clock_PLLR_ToBits(uint32_t pllR)                                  // convert R divider to PLLR bits
+static uint8_t Clock_Apply(const Clock_Setup *pNew)                               // switch SYSCLK with safe ordering
 {                                                                                 // start function
-    if (pllR == 2u) return 0u;                                                    // 00 = /2
-    if (pllR == 4u) return 1u;                                                    // 01 = /4
-    if (pllR == 6u) return 2u;                                                    // 10 = /6
-    return 3u;                                                                    // 11 = /8 (default fallback)
+    uint8_t range2 = (_CLOCK_USE_RANGE2 && pNew->sw != CLOCK_SW_PLL && pNew->hz <= CLOCK_RANGE2_MAX); // low power range when slow enough
+    uint32_t ws = Clock_WaitStates(pNew->hz, range2);                             // wait states it will need
+    uint32_t wsNow = Clock_GetLatency();                                          // wait states now
+
+    if (pNew->src == CLOCK_SRC_HSE && !Clock_EnableHSE())                         // HSE missing
+        return 0u;                                                                // leave everything as it is
+    Clock_EnableHSI16();                                                          // HSI16: target or stepping stone
+
+    uint32_t oldHz = SystemCoreClock;                                             // what the listeners are timed for
+    uint8_t notify = (pNew->hz != oldHz);                                         // a real frequency change
+    if (notify)                                                                   // tell them while the old clock runs
+        Clock_Notify(CLOCK_CHANGE_BEFORE, oldHz, pNew->hz);                       // drain / pause
+    uint32_t primask = __get_PRIMASK();                                           // caller's interrupt state
+    __disable_irq();                                                              // no ISR between switch and re-timing
+
+    Clock_SetRange(0u);                                                           // speeding up needs range 1 first
+    if (ws > wsNow)                                                               // more wait states: before the clock rises
+        Clock_SetLatency(ws);                                                     // flash slows down first
+
+    if (pNew->sw == CLOCK_SW_PLL)                                                 // PLL target
+    {                                                                             // start if
+        Clock_SetSwitch(CLOCK_SW_HSI);                                            // must switch away from PLL before editing it
+        Clock_DisablePLL();                                                       // disable PLL so we can reconfigure
+        RCC->PLLCFGR = pNew->pllcfgr;                                             // M/N/P/Q/R + source + enables
+        RCC->CR |= RCC_CR_PLLON;                                                  // enable PLL
+        while ((RCC->CR & RCC_CR_PLLRDY) == 0u) { }                               // wait until PLL locked
+        Clock_SetSwitch(CLOCK_SW_PLL);                                            // PLL selected as SYSCLK
+    }                                                                             // end if
+    else                                                                          // HSISYS or HSE directly
+    {                                                                             // start else
+        RCC->CR = (RCC->CR & ~RCC_CR_HSIDIV) | (pNew->hsidiv << RCC_CR_HSIDIV_Pos); // HSISYS divider
+        Clock_SetSwitch(pNew->sw);                                                // select the oscillator
+        Clock_DisablePLL();                                                       // PLL not needed: save its current
+    }                                                                             // end else
+    if (pNew->src != CLOCK_SRC_HSE)                                               // HSE no longer used
+        RCC->CR &= ~(RCC_CR_HSEON | RCC_CR_HSEBYP);                               // stop it
+
+    SystemCoreClock = pNew->hz;                                                   // update SystemCoreClock variable
+    if (ws < wsNow)                                                               // fewer wait states: after the clock fell
+        Clock_SetLatency(ws);                                                     // flash speeds up last
+    if (range2)                                                                   // slow enough for range 2
+        Clock_SetRange(1u);                                                       // lower the core voltage last
+
+    if (notify)                                                                   // re-time everything before an ISR runs
+        Clock_Notify(CLOCK_CHANGE_AFTER, oldHz, pNew->hz);                        // BRR / PSC / LOAD
+    __set_PRIMASK(primask);                                                       // interrupts as they were
+
+    s_setup = *pNew;                                                              // remember for Clock_Restore
+    return 1u;                                                                    // done
 }                                                                                 // end function
 
 static uint32_t Clock_MCOPreBits(MCO_Div div)                                     // convert /1,/2,/4.. to MCOPRE bits
@@ -80,45 +218,121 @@ static uint32_t Clock_MCOSelBits(MCO_Select src)
 //==================================================================================================
 // PUBLIC API
 //==================================================================================================
-void Clock_InitPll(PLL_ClockFreq target)                                          // configure SYSCLK = target MHz
+uint8_t Clock_SolvePll(uint32_t targetHz, Clock_Source src, uint32_t pHz, uint32_t qHz, Clock_PllConfig *pCfg) // best M/N/R (+P/Q)
 {                                                                                 // start function
-    uint32_t targetMHz = (uint32_t)target;                                        // convert enum to number
-    uint32_t pllR = 2u;                                                           // choose R=2 for nice results (demo-friendly)
+    uint32_t inHz = Clock_SourceHz(src);                                          // PLL input before M
+    uint32_t bestErr = 0xFFFFFFFFu;                                               // SYSCLK error of the best so far
+    uint32_t bestSide = 0xFFFFFFFFu;                                              // P + Q error of the best so far
+    uint8_t found = 0u;                                                           // any legal setting yet
 
-    if (targetMHz == 16u)                                                         // if they want 16MHz
-    {                                                                             // start if
-        Clock_EnableHSI16();                                                      // ensure HSI ready
-        Clock_SwitchSysclkToHSI();                                                // SYSCLK = HSI
-        SystemCoreClock = 16000000u;                                              // update global
-        return;                                                                   // done
-    }                                                                             // end if
+    for (uint32_t m = 1u; m <= 8u; m++)                                           // every input divider
+    {                                                                             // open loop
+        if (inHz < CLOCK_PLLIN_MIN * m || inHz > CLOCK_PLLIN_MAX * m)             // PLL input out of range
+            continue;                                                             // next M
+        for (uint32_t r = 2u; r <= 8u; r++)                                       // every R divider
+        {                                                                         // open loop
+            uint64_t n64 = ((uint64_t)targetHz * r * m + inHz / 2u) / inHz;       // N rounded to the target
+            uint64_t nLo = ((uint64_t)CLOCK_PLLR_MIN * r * m + inHz - 1u) / inHz; // lowest N with PLLRCLK >= 12 MHz
+            uint64_t nHi = ((uint64_t)CLOCK_PLLR_MAX * r * m) / inHz;             // highest N with PLLRCLK <= 64 MHz
+            if (n64 < nLo) n64 = nLo;                                             // target below the range: closest legal
+            if (n64 > nHi) n64 = nHi;                                             // target above the range: closest legal
+            uint32_t n = (n64 < 8u) ? 8u : (n64 > 86u) ? 86u : (uint32_t)n64;     // N field range
+            uint32_t vco = (uint32_t)((uint64_t)inHz * n / m);                    // VCO output
+            uint32_t out = (uint32_t)((uint64_t)inHz * n / ((uint64_t)m * r));    // PLLRCLK
 
-    Clock_EnableHSI16();                                                          // make sure HSI16 is running
-    Clock_SetFlashForHighSpeed(targetMHz * 1000000u);                             // set flash latency/prefetch
+            if (vco < CLOCK_VCO_MIN || vco > CLOCK_VCO_MAX)                       // VCO out of range
+                continue;                                                         // next R
+            if (out < CLOCK_PLLR_MIN || out > CLOCK_PLLR_MAX)                     // SYSCLK out of range
+                continue;                                                         // next R
 
-    Clock_SwitchSysclkToHSI();                                                    // must switch away from PLL before editing it
-    Clock_DisablePLL();                                                          // disable PLL so we can reconfigure
+            uint32_t p = pHz ? Clock_PickDiv(vco, pHz, 2u, 32u, CLOCK_PLLP_MAX) : 0u; // P divider (0 = off)
+            uint32_t q = qHz ? Clock_PickDiv(vco, qHz, 2u, 8u, CLOCK_PLLQ_MAX) : 0u; // Q divider (0 = off)
+            uint32_t err = Clock_AbsDiff(out, targetHz);                          // SYSCLK error
+            uint32_t side = (p ? Clock_AbsDiff(vco / p, pHz) : pHz) + (q ? Clock_AbsDiff(vco / q, qHz) : qHz); // P/Q error
 
-    uint32_t N = Clock_ComputePLLN(targetMHz, pllR);                              // compute PLLN
+            if (found && (err > bestErr || (err == bestErr && side > bestSide) || // worse SYSCLK or P/Q
+                          (err == bestErr && side == bestSide && vco >= pCfg->vcoHz))) // same, but VCO not lower
+                continue;                                                         // keep the best
 
-    if (N < 8u)  N = 8u;                                                          // clamp N low (datasheet safe range)
-    if (N > 86u) N = 86u;                                                         // clamp N high (datasheet safe range)
+            found = 1u;                                                           // new best
+            bestErr = err;                                                        // its SYSCLK error
+            bestSide = side;                                                      // its P/Q error
+            pCfg->src = src;                                                      // oscillator
+            pCfg->m = (uint8_t)m;                                                 // input divider
+            pCfg->n = (uint8_t)n;                                                 // multiplier
+            pCfg->r = (uint8_t)r;                                                 // SYSCLK divider
+            pCfg->p = (uint8_t)p;                                                 // P divider (0 = off)
+            pCfg->q = (uint8_t)q;                                                 // Q divider (0 = off)
+            pCfg->vcoHz = vco;                                                    // VCO output
+            pCfg->sysclkHz = out;                                                 // PLLRCLK
+            pCfg->pHz = p ? vco / p : 0u;                                         // PLLPCLK
+            pCfg->qHz = q ? vco / q : 0u;                                         // PLLQCLK
+        }                                                                         // end loop
+    }                                                                             // end loop
+    return found;                                                                 // 1 = pCfg filled
+}                                                                                 // end function
+
+uint32_t Clock_ApplyPll(const Clock_PllConfig *pCfg)                              // run SYSCLK from a solved PLL
+{                                                                                 // start function
+    Clock_Setup next;                                                             // full setup
+    uint32_t cfg = (pCfg->src == CLOCK_SRC_HSE) ? RCC_PLLCFGR_PLLSRC_HSE : RCC_PLLCFGR_PLLSRC_HSI; // PLL source
 
-    RCC->PLLCFGR = 0u;                                                            // clear PLLCFGR (simple reset style)
-    RCC->PLLCFGR |= RCC_PLLCFGR_PLLSRC_HSI;                                       // PLL source = HSI16
-    RCC->PLLCFGR |= (0u << RCC_PLLCFGR_PLLM_Pos);                                 // PLLM = /1 (M=0 means /1 on G0)
-    RCC->PLLCFGR |= (N  << RCC_PLLCFGR_PLLN_Pos);                                 // set PLLN
-    RCC->PLLCFGR |= (Clock_PLLR_ToBits(pllR) << RCC_PLLCFGR_PLLR_Pos);            // set PLLR divider bits
-    RCC->PLLCFGR |= RCC_PLLCFGR_PLLREN;                                           // enable PLLR output
+    cfg |= (uint32_t)(pCfg->m - 1u) << RCC_PLLCFGR_PLLM_Pos;                      // PLLM field = M - 1
+    cfg |= (uint32_t)pCfg->n << RCC_PLLCFGR_PLLN_Pos;                             // PLLN field = N
+    cfg |= (uint32_t)(pCfg->r - 1u) << RCC_PLLCFGR_PLLR_Pos;                      // PLLR field = R - 1
+    cfg |= RCC_PLLCFGR_PLLREN;                                                    // enable PLLR output (SYSCLK)
+    if (pCfg->p)                                                                  // P output wanted
+        cfg |= ((uint32_t)(pCfg->p - 1u) << RCC_PLLCFGR_PLLP_Pos) | RCC_PLLCFGR_PLLPEN; // PLLP field = P - 1
+    if (pCfg->q)                                                                  // Q output wanted
+        cfg |= ((uint32_t)(pCfg->q - 1u) << RCC_PLLCFGR_PLLQ_Pos) | RCC_PLLCFGR_PLLQEN; // PLLQ field = Q - 1
 
-    RCC->CR |= RCC_CR_PLLON;                                                      // enable PLL
-    while ((RCC->CR & RCC_CR_PLLRDY) == 0u) { }                                   // wait until PLL locked
+    next.sw = CLOCK_SW_PLL;                                                       // SYSCLK = PLLRCLK
+    next.hsidiv = 0u;                                                             // HSISYS /1 while stepping
+    next.pllcfgr = cfg;                                                           // PLL setup
+    next.src = pCfg->src;                                                         // oscillator
+    next.hz = pCfg->sysclkHz;                                                     // resulting SYSCLK
+    return Clock_Apply(&next) ? next.hz : 0u;                                     // SYSCLK, 0 = failed
+}                                                                                 // end function
 
-    RCC->CFGR &= ~RCC_CFGR_SW;                                                    // clear SYSCLK switch bits
-    RCC->CFGR |= RCC_CFGR_SW_1;                                                   // SW = 10 (PLL selected as SYSCLK)
-    while ((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_1) { }                      // wait until PLL is SYSCLK
+uint32_t Clock_SetSysclk(uint32_t hz, Clock_Source src)                           // closest SYSCLK to hz
+{                                                                                 // start function
+    uint32_t inHz = Clock_SourceHz(src);                                          // oscillator frequency
+    Clock_PllConfig pll;                                                          // solver result
 
-    SystemCoreClock = targetMHz * 1000000u;                                       // update SystemCoreClock variable
+    if (src == CLOCK_SRC_HSI16 && hz <= CLOCK_HSI_HZ && hz != 0u)                 // HSISYS = HSI16 / 2^k ?
+    {                                                                             // start if
+        for (uint32_t k = 0u; k <= 7u; k++)                                       // HSIDIV /1 .. /128
+        {                                                                         // open loop
+            if ((CLOCK_HSI_HZ >> k) == hz)                                        // exact divide
+            {                                                                     // start if
+                Clock_Setup next = { CLOCK_SW_HSI, k, 0u, CLOCK_SRC_HSI16, hz };  // no PLL
+                return Clock_Apply(&next) ? hz : 0u;                              // SYSCLK, 0 = failed
+            }                                                                     // end if
+        }                                                                         // end loop
+    }                                                                             // end if
+    if (src == CLOCK_SRC_HSE && hz == inHz)                                       // HSE as is
+    {                                                                             // start if
+        Clock_Setup next = { CLOCK_SW_HSE, 0u, 0u, CLOCK_SRC_HSE, hz };           // no PLL
+        return Clock_Apply(&next) ? hz : 0u;                                      // SYSCLK, 0 = failed
+    }                                                                             // end if
+
+    if (!Clock_SolvePll(hz, src, 0u, 0u, &pll))                                   // no legal PLL setting
+        return 0u;                                                                // fail
+    return Clock_ApplyPll(&pll);                                                  // closest PLL SYSCLK
+}                                                                                 // end function
+
+void Clock_InitPll(PLL_ClockFreq target)                                          // configure SYSCLK = target MHz
+{                                                                                 // start function
+    Clock_SetSysclk((uint32_t)target * 1000000u, CLOCK_SRC_HSI16);                // HSI16 (PLL when above 16 MHz)
+}                                                                                 // end function
+
+uint8_t Clock_Restore(void)                                                       // last setup again (after Stop)
+{                                                                                 // start function
+    if (((RCC->CFGR & RCC_CFGR_SWS) >> RCC_CFGR_SWS_Pos) == s_setup.sw &&         // still on it (HSISYS wakeup, or no Stop)
+        (s_setup.sw != CLOCK_SW_PLL || (RCC->CR & RCC_CR_PLLRDY) != 0u))          // and the PLL still locked
+        return 1u;                                                                // nothing lost
+    Clock_Setup last = s_setup;                                                   // copy: Clock_Apply rewrites it
+    return Clock_Apply(&last);                                                    // same PLL / divider / range / wait states
 }                                                                                 // end function
 
 void Clock_EnableOutput(MCO_Select src, MCO_Div div)                              // route clock source to MCO pin
@@ -142,3 +356,27 @@ uint32_t Clock_GetSysclkHz(void)
 {                                                                                 // start function
     return SystemCoreClock;                                                       // return global core clock
 }                                                                                 // end function
+
+uint8_t Clock_Subscribe(Clock_ChangeCallback cb)                                  // add a clock-change listener
+{                                                                                 // start function
+    uint8_t free = _CLOCK_LISTENERS;                                              // first empty slot
+
+    for (uint8_t i = 0u; i < _CLOCK_LISTENERS; i++)                               // look through the registry
+    {                                                                             // open loop
+        if (s_listeners[i] == cb)                                                 // already in
+            return 1u;                                                            // once is enough
+        if (!s_listeners[i] && free == _CLOCK_LISTENERS)                          // first hole
+            free = i;                                                             // remember it
+    }                                                                             // end loop
+    if (free == _CLOCK_LISTENERS)                                                 // registry full
+        return 0u;                                                                // fail
+    s_listeners[free] = cb;                                                       // one pointer store: safe against a switch in an ISR
+    return 1u;                                                                    // subscribed
+}                                                                                 // end function
+
+void Clock_Unsubscribe(Clock_ChangeCallback cb)                                   // remove a clock-change listener
+{                                                                                 // start function
+    for (uint8_t i = 0u; i < _CLOCK_LISTENERS; i++)                               // look through the registry
+        if (s_listeners[i] == cb)                                                 // found it
+            s_listeners[i] = 0;                                                   // free the slot
+}                                                                                 // end function
@@ -0,0 +1,197 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  DDS
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   dds.c
+//
+//  Phase bits:  [31:30] quadrant  [29:22] table index  [21:14] fraction
+//  The quarter table has 257 points so index + 1 never runs off the
+//  end; odd quadrants read it backwards, the lower half is negated.
+//  Per sample: one add, one table pair, two multiplies, no division
+//  (the M0+ multiplier is single cycle, there is no divider).
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include "dds.h"
+#include "clock.h"
+
+// ======================================================
+// Quarter sine table, Q15, generated by the compiler
+// sin(x) by Taylor series to x^13 (error < 1e-7 on 0..pi/2)
+// ======================================================
+#define DDS_X(i)        ((double)(i) * (1.5707963267948966 / 256.0))
+#define DDS_SIN(x)      ((x) * (1.0 - (x) * (x) / 6.0 * (1.0 - (x) * (x) / 20.0 * \
+                        (1.0 - (x) * (x) / 42.0 * (1.0 - (x) * (x) / 72.0 *      \
+                        (1.0 - (x) * (x) / 110.0 * (1.0 - (x) * (x) / 156.0)))))))
+#define DDS_Q15(i)      ((int16_t)(32767.0 * DDS_SIN(DDS_X(i)) + 0.5))
+#define DDS_Q15_4(i)    DDS_Q15(i), DDS_Q15((i) + 1), DDS_Q15((i) + 2), DDS_Q15((i) + 3)
+#define DDS_Q15_16(i)   DDS_Q15_4(i), DDS_Q15_4((i) + 4), DDS_Q15_4((i) + 8), DDS_Q15_4((i) + 12)
+#define DDS_Q15_64(i)   DDS_Q15_16(i), DDS_Q15_16((i) + 16), DDS_Q15_16((i) + 32), DDS_Q15_16((i) + 48)
+#define DDS_Q15_256(i)  DDS_Q15_64(i), DDS_Q15_64((i) + 64), DDS_Q15_64((i) + 128), DDS_Q15_64((i) + 192)
+
+static const int16_t s_quarter[257] = { DDS_Q15_256(0), DDS_Q15(256) };
+
+// ======================================================
+// Sample path
+// ======================================================
+int32_t Dds_Sine(uint32_t phase)
+{
+    uint32_t x = (phase >> 14) & 0xFFFFu;            // position in the quadrant
+    if (phase & 0x40000000u)                         // 2nd / 4th quadrant
+        x = 0xFFFFu - x;                             // mirror
+
+    uint32_t i = x >> 8;
+    int32_t a = s_quarter[i];
+    int32_t v = a + (((s_quarter[i + 1u] - a) * (int32_t)(x & 0xFFu)) >> 8);
+
+    return (phase & 0x80000000u) ? -v : v;           // 3rd / 4th: negative
+}
+
+// Sweeps step inc in Q24 so even hour-long sweeps move every sample
+static void Dds_SweepStep(Dds_Osc *pOsc)
+{
+    int64_t sweep = pOsc->sweep;
+    uint64_t acc = pOsc->incQ24 + (uint64_t)sweep;
+    uint32_t inc = (uint32_t)(acc >> 24);
+
+    if ((sweep > 0) ? (inc >= pOsc->sweepTo) : (inc <= pOsc->sweepTo))
+    {
+        if (pOsc->sweepRepeat)
+            inc = pOsc->sweepFrom;
+        else
+        {
+            inc = pOsc->sweepTo;
+            pOsc->sweep = 0;
+        }
+        acc = (uint64_t)inc << 24;
+    }
+    pOsc->incQ24 = acc;
+    pOsc->inc = inc;
+}
+
+static uint32_t Dds_Next(Dds_Osc *pOsc)
+{
+    uint32_t phase = pOsc->phase;
+
+    pOsc->phase = phase + pOsc->inc;
+    if (pOsc->sweep)
+        Dds_SweepStep(pOsc);
+    return (uint32_t)((int32_t)pOsc->mid + ((Dds_Sine(phase) * (int32_t)pOsc->amp) >> 15));
+}
+
+void Dds_Tick(Dds_Osc *pOsc)
+{
+    pOsc->pTimer->SR = (uint32_t)~TIM_SR_UIF;        // rc_w0: clears UIF only
+    *pOsc->pCCR = Dds_Next(pOsc);
+}
+
+void Dds_Fill(Dds_Osc *pOsc, uint16_t *pBuf, uint16_t count)
+{
+    while (count--)
+        *pBuf++ = (uint16_t)Dds_Next(pOsc);
+}
+
+// ======================================================
+// Setup
+// ======================================================
+static uint32_t Dds_Inc(const Dds_Osc *pOsc, uint32_t freq_cHz)
+{
+    if (!pOsc->rate_mHz)
+        return 0;
+
+    // Nyquist first: f_mHz <= rate / 2, so inc <= 2^31
+    if (freq_cHz >= pOsc->rate_mHz / 20u)
+        return 0x80000000u;
+
+    // inc = f * 2^32 / rate, f in cHz -> x10 for mHz. Above 4.29 MHz
+    // f_mHz needs 33+ bits: shift and divide 16 bits at a time
+    uint64_t f_mHz = (uint64_t)freq_cHz * 10u;
+    uint64_t hi = (f_mHz << 16) / pOsc->rate_mHz;
+    uint64_t rem = (f_mHz << 16) % pOsc->rate_mHz;
+    return (uint32_t)((hi << 16) + ((rem << 16) / pOsc->rate_mHz));
+}
+
+void Dds_Init(Dds_Osc *pOsc, TIM_TypeDef *pTimer, Timer_Channel channel, uint8_t useIrq)
+{
+    volatile uint32_t *ccr[4] = { &pTimer->CCR1, &pTimer->CCR2, &pTimer->CCR3, &pTimer->CCR4 };
+
+    if (!pOsc || channel < TIMER_CHANNEL1 || channel > Timer_ChannelCount(pTimer))
+        return;
+
+    uint64_t counts = ((uint64_t)pTimer->PSC + 1u) * ((uint64_t)pTimer->ARR + 1u);
+    uint32_t top = pTimer->ARR + 1u;
+
+    pOsc->phase = 0;
+    pOsc->inc = 0;
+    pOsc->sweep = 0;
+    pOsc->rate_mHz = ((uint64_t)Clock_GetSysclkHz() * 1000u + counts / 2u) / counts;
+    pOsc->pTimer = pTimer;
+    pOsc->pCCR = ccr[channel - 1u];
+    if (top > 0xFFFFu)                               // Dds_Fill stores 16-bit samples
+        top = 0xFFFFu;
+    pOsc->mid = top / 2u;
+    Dds_SetLevel(pOsc, 0xFFFFu);
+    *pOsc->pCCR = pOsc->mid;
+
+    if (useIrq)
+    {
+        pTimer->DIER |= TIM_DIER_UIE;
+        if (pTimer == TIM1)
+            NVIC_EnableIRQ(TIM1_BRK_UP_TRG_COM_IRQn);
+        else if (pTimer == TIM2)
+            NVIC_EnableIRQ(TIM2_IRQn);
+        else if (pTimer == TIM3)
+            NVIC_EnableIRQ(TIM3_IRQn);
+        else if (pTimer == TIM14)
+            NVIC_EnableIRQ(TIM14_IRQn);
+        else if (pTimer == TIM16)
+            NVIC_EnableIRQ(TIM16_IRQn);
+        else if (pTimer == TIM17)
+            NVIC_EnableIRQ(TIM17_IRQn);
+    }
+}
+
+void Dds_SetFrequency(Dds_Osc *pOsc, uint32_t freq_cHz)
+{
+    uint32_t inc = Dds_Inc(pOsc, freq_cHz);
+
+    uint32_t primask = __get_PRIMASK();              // sweep is two words on the M0+
+    __disable_irq();
+    pOsc->sweep = 0;
+    pOsc->inc = inc;
+    __set_PRIMASK(primask);
+}
+
+void Dds_SetLevel(Dds_Osc *pOsc, uint16_t level)
+{
+    // Full swing = mid either side of mid; Q15 sine * amp >> 15
+    pOsc->amp = (uint32_t)(((uint64_t)pOsc->mid * level + 0x8000u) >> 16);
+}
+
+void Dds_Sweep(Dds_Osc *pOsc, uint32_t from_cHz, uint32_t to_cHz,
+               uint32_t duration_ms, uint8_t repeat)
+{
+    uint32_t from = Dds_Inc(pOsc, from_cHz);
+    uint32_t to = Dds_Inc(pOsc, to_cHz);
+    uint64_t samples = ((uint64_t)duration_ms * pOsc->rate_mHz) / 1000000u;
+    int64_t step = (samples) ? (((int64_t)to - (int64_t)from) * (1 << 24)) / (int64_t)samples : 0;
+
+    if (!step)                                       // no time or no change: jump
+    {
+        Dds_SetFrequency(pOsc, to_cHz);
+        return;
+    }
+
+    // sweep and incQ24 are two words each: the sample ISR must not see
+    // half of one, nor end the old sweep in between (its sweep = 0)
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    pOsc->sweepFrom = from;
+    pOsc->sweepTo = to;
+    pOsc->sweepRepeat = repeat;
+    pOsc->incQ24 = (uint64_t)from << 24;
+    pOsc->inc = from;
+    pOsc->sweep = step;
+    __set_PRIMASK(primask);
+}
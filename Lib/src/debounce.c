@@ -0,0 +1,210 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  DEBOUNCE
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   debounce.c
+//
+//  state is kept in "pressed" terms (IDR ^ activeLow), so the counter
+//  and the events never care which way a switch is wired. Each pin
+//  keeps the tick it was pressed on and the tick of its next LONG /
+//  REPEAT; only the pins that still have one to come are walked.
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include "debounce.h"
+#include "wheel.h"
+#include "queue.h"
+
+#define DEBOUNCE_LONG_TICKS    ((_DEBOUNCE_LONG_MS + _DEBOUNCE_TICK_MS - 1u) / _DEBOUNCE_TICK_MS)
+#define DEBOUNCE_REPEAT_TICKS  ((_DEBOUNCE_REPEAT_MS + _DEBOUNCE_TICK_MS - 1u) / _DEBOUNCE_TICK_MS)
+
+typedef struct
+{
+    GPIO_TypeDef *pPort;
+    uint16_t mask;
+    uint16_t invert;             // activeLow
+    uint16_t repeat;
+    uint16_t state;              // debounced, 1 = pressed
+    uint16_t cnt0, cnt1;         // vertical counter
+    uint16_t timing;             // pressed pins with a LONG / REPEAT still to come
+    uint16_t longDone;           // pressed pins past their LONG
+    uint32_t pressedAt[16];      // tick of the press
+    uint32_t due[16];            // tick of the next LONG / REPEAT
+} Debounce_Port;
+
+QUEUE_DEFINE(Debounce_Queue, Debounce_Event, _DEBOUNCE_QUEUE_LEN)
+
+static Debounce_Port s_ports[_DEBOUNCE_PORTS];
+static volatile uint8_t s_count = 0;
+static uint32_t s_now = 0;                           // ticks
+static Debounce_Queue s_queue;                       // tick puts, reader gets
+static Wheel_Timer s_wheel;
+
+// ======================================================
+// Setup
+// ======================================================
+void Debounce_Init(void)
+{
+    Debounce_Stop();
+    s_count = 0;
+    Debounce_Queue_Flush(&s_queue);
+}
+
+uint8_t Debounce_AddPort(GPIO_TypeDef *pPort, uint16_t mask, uint16_t activeLow, uint16_t repeat)
+{
+    uint8_t i;
+    uint8_t ok = 1;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    for (i = 0; i < s_count && s_ports[i].pPort != pPort; i++) { }
+    if (i == s_count && s_count >= _DEBOUNCE_PORTS)
+        ok = 0;
+    else
+    {
+        Debounce_Port *p = &s_ports[i];
+
+        p->pPort = pPort;
+        p->mask = mask;
+        p->invert = activeLow;
+        p->repeat = repeat;
+        p->state = (uint16_t)((pPort->IDR ^ activeLow) & mask);   // no events for the start level
+        p->cnt0 = p->cnt1 = 0;
+        p->timing = 0;
+        p->longDone = 0;
+        for (uint8_t pin = 0; pin < 16u; pin++)
+            p->pressedAt[pin] = s_now;           // held from here if down already
+        if (i == s_count)
+            s_count++;
+    }
+    __set_PRIMASK(primask);
+    return ok;
+}
+
+static void Debounce_OnWheel(void *pArg)
+{
+    (void)pArg;
+    Debounce_Tick();
+}
+
+void Debounce_Start(void)
+{
+    uint32_t ticks = (_DEBOUNCE_TICK_MS * 1000u + _WHEEL_TICK_US - 1u) / _WHEEL_TICK_US;
+
+    Wheel_Arm(&s_wheel, ticks, ticks, Debounce_OnWheel, 0);
+}
+
+void Debounce_Stop(void)
+{
+    Wheel_Cancel(&s_wheel);
+}
+
+// ======================================================
+// Queue
+// ======================================================
+static void Debounce_Push(const Debounce_Port *p, uint8_t pin, Debounce_Type type)
+{
+    Debounce_Event *pEv = Debounce_Queue_Reserve(&s_queue);
+
+    if (!pEv)
+        return;
+
+    uint32_t ticks = s_now - p->pressedAt[pin];
+    uint32_t ms = (ticks > 0xFFFFu / _DEBOUNCE_TICK_MS) ? 0xFFFFu : ticks * _DEBOUNCE_TICK_MS;
+    pEv->pPort = p->pPort;
+    pEv->pin = pin;
+    pEv->type = (uint8_t)type;
+    pEv->heldMs = (uint16_t)ms;
+    Debounce_Queue_Commit(&s_queue);                 // published after the slot is written
+}
+
+uint8_t Debounce_Read(Debounce_Event *pEvent)
+{
+    return Debounce_Queue_Get(&s_queue, pEvent);
+}
+
+uint16_t Debounce_Pressed(GPIO_TypeDef *pPort)
+{
+    for (uint8_t i = 0; i < s_count; i++)
+        if (s_ports[i].pPort == pPort)
+            return s_ports[i].state;
+    return 0;
+}
+
+uint32_t Debounce_Dropped(void)
+{
+    return s_queue.dropped;
+}
+
+// ======================================================
+// Sampling
+// ======================================================
+static void Debounce_Edges(Debounce_Port *p, uint16_t toggle)
+{
+    for (uint8_t pin = 0; toggle >> pin; pin++)
+    {
+        uint16_t bit = (uint16_t)(1u << pin);
+
+        if (!(toggle & bit))
+            continue;
+        if (p->state & bit)
+        {
+            p->pressedAt[pin] = s_now;
+            p->due[pin] = s_now + DEBOUNCE_LONG_TICKS;
+            p->timing |= bit;
+            p->longDone &= (uint16_t)~bit;
+            Debounce_Push(p, pin, DEBOUNCE_PRESS);
+        }
+        else
+        {
+            p->timing &= (uint16_t)~bit;
+            Debounce_Push(p, pin, DEBOUNCE_RELEASE);
+        }
+    }
+}
+
+static void Debounce_Hold(Debounce_Port *p)
+{
+    uint16_t timing = p->timing;
+
+    for (uint8_t pin = 0; timing >> pin; pin++)
+    {
+        uint16_t bit = (uint16_t)(1u << pin);
+
+        if (!(timing & bit) || s_now != p->due[pin])
+            continue;
+        if (!(p->longDone & bit))
+        {
+            p->longDone |= bit;
+            Debounce_Push(p, pin, DEBOUNCE_LONG);
+        }
+        else
+            Debounce_Push(p, pin, DEBOUNCE_REPEAT);
+        if (p->repeat & bit)
+            p->due[pin] += DEBOUNCE_REPEAT_TICKS;
+        else
+            p->timing &= (uint16_t)~bit;             // nothing more to time, wait for the release
+    }
+}
+
+void Debounce_Tick(void)
+{
+    s_now++;
+    for (uint8_t i = 0; i < s_count; i++)
+    {
+        Debounce_Port *p = &s_ports[i];
+        uint16_t sample = (uint16_t)((p->pPort->IDR ^ p->invert) & p->mask);
+        uint16_t delta = sample ^ p->state;
+
+        p->cnt1 = (uint16_t)((p->cnt1 ^ p->cnt0) & delta);
+        p->cnt0 = (uint16_t)(~p->cnt0 & delta);
+        uint16_t toggle = (uint16_t)(delta & ~(p->cnt0 | p->cnt1));
+        p->state ^= toggle;
+
+        if (toggle)
+            Debounce_Edges(p, toggle);
+        if (p->timing)
+            Debounce_Hold(p);
+    }
+}
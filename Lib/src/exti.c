@@ -0,0 +1,168 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  EXTI
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   exti.c
+//
+//  G0 EXTI: EXTICR[line / 4] picks the port, 8 bits per line (A = 0,
+//  B = 1, C = 2, D = 3, F = 5); RTSR1 / FTSR1 the edges; IMR1 lets it
+//  interrupt. Rising and falling have their own pending registers
+//  (RPR1 / FPR1, write 1 to clear), which is what tells the handler
+//  the direction without reading the pin.
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include "exti.h"
+#include "timebase.h"
+#include "queue.h"
+
+#define EXTI_PORTS  6u                               // A, B, C, D, (E), F
+
+QUEUE_DEFINE(Exti_Queue, Exti_Event, _EXTI_QUEUE_LEN)
+
+static Exti_Callback s_callbacks[16];
+static GPIO_TypeDef *s_ports[16];
+static Exti_Queue s_queue;                           // interrupts put, reader gets
+
+static IRQn_Type Exti_Irq(uint8_t line)
+{
+    if (line < 2u)
+        return EXTI0_1_IRQn;
+    if (line < 4u)
+        return EXTI2_3_IRQn;
+    return EXTI4_15_IRQn;
+}
+
+// EXTI lines sharing the line's vector
+static uint32_t Exti_IrqLines(uint8_t line)
+{
+    if (line < 2u)
+        return 0x0003u;
+    if (line < 4u)
+        return 0x000Cu;
+    return 0xFFF0u;
+}
+
+// ======================================================
+// Setup
+// ======================================================
+uint8_t Exti_Attach(GPIO_TypeDef *pPort, uint8_t pin, Exti_Edge edge, Exti_Callback cb)
+{
+    uint32_t offset = (uint32_t)((uintptr_t)pPort - IOPORT_BASE);
+    uint32_t port = offset / 0x400u;
+
+    if (pin > 15u || offset % 0x400u || port >= EXTI_PORTS || port == 4u)
+        return 0;
+
+    uint32_t bit = 1u << pin;
+    uint32_t shift = 8u * (pin & 3u);
+
+    Exti_Detach(pin);                                // quiet while it is rewired
+    s_callbacks[pin] = cb;
+    s_ports[pin] = pPort;
+
+    EXTI->EXTICR[pin >> 2] = (EXTI->EXTICR[pin >> 2] & ~(0xFFu << shift)) | (port << shift);
+    if (edge & EXTI_EDGE_RISING)
+        EXTI->RTSR1 |= bit;
+    if (edge & EXTI_EDGE_FALLING)
+        EXTI->FTSR1 |= bit;
+    EXTI->RPR1 = bit;                                // nothing stale from the old routing
+    EXTI->FPR1 = bit;
+    EXTI->IMR1 |= bit;
+
+    NVIC_EnableIRQ(Exti_Irq(pin));
+    return 1;
+}
+
+void Exti_Detach(uint8_t line)
+{
+    if (line > 15u)
+        return;
+
+    uint32_t bit = 1u << line;
+    EXTI->IMR1 &= ~bit;
+    EXTI->RTSR1 &= ~bit;
+    EXTI->FTSR1 &= ~bit;
+    EXTI->RPR1 = bit;
+    EXTI->FPR1 = bit;
+    if (!(EXTI->IMR1 & Exti_IrqLines(line)))
+        NVIC_DisableIRQ(Exti_Irq(line));             // last line on this vector
+}
+
+// ======================================================
+// Queue
+// ======================================================
+static void Exti_Push(uint32_t us, uint8_t line, uint8_t rising)
+{
+    Exti_Event ev = { us, line, rising };
+
+    if (s_callbacks[line])
+        s_callbacks[line](&ev);
+
+    Exti_Event *pSlot = Exti_Queue_Reserve(&s_queue);
+    if (pSlot)
+    {
+        *pSlot = ev;
+        Exti_Queue_Commit(&s_queue);                 // published after the slot is written
+    }
+}
+
+uint8_t Exti_Read(Exti_Event *pEvent)
+{
+    return Exti_Queue_Get(&s_queue, pEvent);
+}
+
+uint8_t Exti_Pending(void)
+{
+    return Exti_Queue_Count(&s_queue);
+}
+
+uint32_t Exti_Dropped(void)
+{
+    return s_queue.dropped;
+}
+
+// ======================================================
+// Interrupts
+// ======================================================
+static void Exti_Service(uint32_t lines)
+{
+    uint32_t us = Timebase_Micros32();               // stamp before anything else
+    uint32_t rise = EXTI->RPR1 & lines;
+    uint32_t fall = EXTI->FPR1 & lines;
+
+    EXTI->RPR1 = rise;
+    EXTI->FPR1 = fall;
+
+    for (uint8_t line = 0; (rise | fall) >> line; line++)
+    {
+        uint32_t bit = 1u << line;
+
+        if ((rise & bit) && (fall & bit))            // both: the level now says which came last
+        {
+            uint8_t high = (s_ports[line]->IDR & bit) ? 1u : 0u;
+            Exti_Push(us, line, (uint8_t)!high);
+            Exti_Push(us, line, high);
+        }
+        else if (rise & bit)
+            Exti_Push(us, line, 1);
+        else if (fall & bit)
+            Exti_Push(us, line, 0);
+    }
+}
+
+void EXTI0_1_IRQHandler(void)
+{
+    Exti_Service(0x0003u);
+}
+
+void EXTI2_3_IRQHandler(void)
+{
+    Exti_Service(0x000Cu);
+}
+
+void EXTI4_15_IRQHandler(void)
+{
+    Exti_Service(0xFFF0u);
+}
@@ -0,0 +1,297 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  FORMAT LIBRARY
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   fmt.c
+//
+//  Decimal conversion subtracts descending powers of ten: at most
+//  9 subtractions per digit and no call into the libgcc divide
+//  helpers. 64-bit values that fit in 32 bits take the 32-bit path.
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include "fmt.h"
+
+static const uint32_t s_pow10_32[10] =
+{
+    1000000000u, 100000000u, 10000000u, 1000000u, 100000u,
+    10000u, 1000u, 100u, 10u, 1u
+};
+
+static const uint64_t s_pow10_64[20] =
+{
+    10000000000000000000ull, 1000000000000000000ull, 100000000000000000ull,
+    10000000000000000ull, 1000000000000000ull, 100000000000000ull,
+    10000000000000ull, 1000000000000ull, 100000000000ull, 10000000000ull,
+    1000000000ull, 100000000ull, 10000000ull, 1000000ull, 100000ull,
+    10000ull, 1000ull, 100ull, 10ull, 1ull
+};
+
+static const char s_hex[16] = "0123456789ABCDEF";
+
+// ======================================================
+// Digit generators (natural width, not terminated)
+// ======================================================
+static uint8_t Fmt_Digits32(char *out, uint32_t value)
+{
+    uint8_t n = 0;
+
+    for (uint8_t i = 0; i < 10; i++)
+    {
+        uint32_t p = s_pow10_32[i];
+        char d = '0';
+        while (value >= p)
+        {
+            value -= p;
+            d++;
+        }
+        if (n || d != '0' || i == 9)
+            out[n++] = d;
+    }
+    return n;
+}
+
+static uint8_t Fmt_Digits64(char *out, uint64_t value)
+{
+    if ((value >> 32) == 0)
+        return Fmt_Digits32(out, (uint32_t)value);
+
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < 20; i++)
+    {
+        uint64_t p = s_pow10_64[i];
+        char d = '0';
+        while (value >= p)
+        {
+            value -= p;
+            d++;
+        }
+        if (n || d != '0')
+            out[n++] = d;
+    }
+    return n;
+}
+
+// Right-align digits in width, sign in front of any '0' padding
+static uint8_t Fmt_Place(char *buf, const char *digits, uint8_t n, uint8_t neg,
+                         uint8_t width, char pad)
+{
+    uint8_t len = 0;
+    uint8_t body = (uint8_t)(n + neg);
+    uint8_t fill = (width > body) ? (uint8_t)(width - body) : 0;
+
+    if (neg && pad == '0')
+        buf[len++] = '-';
+    while (fill--)
+        buf[len++] = pad;
+    if (neg && pad != '0')
+        buf[len++] = '-';
+    for (uint8_t i = 0; i < n; i++)
+        buf[len++] = digits[i];
+
+    buf[len] = '\0';
+    return len;
+}
+
+// ======================================================
+// Decimal
+// ======================================================
+uint8_t Fmt_U32(char *buf, uint32_t value, uint8_t width, char pad)
+{
+    char digits[10];
+    uint8_t n = Fmt_Digits32(digits, value);
+    return Fmt_Place(buf, digits, n, 0, width, pad);
+}
+
+uint8_t Fmt_I32(char *buf, int32_t value, uint8_t width, char pad)
+{
+    char digits[10];
+    uint8_t neg = (value < 0);
+    uint32_t mag = neg ? (uint32_t)(-(value + 1)) + 1u : (uint32_t)value;
+    uint8_t n = Fmt_Digits32(digits, mag);
+    return Fmt_Place(buf, digits, n, neg, width, pad);
+}
+
+uint8_t Fmt_U64(char *buf, uint64_t value, uint8_t width, char pad)
+{
+    char digits[20];
+    uint8_t n = Fmt_Digits64(digits, value);
+    return Fmt_Place(buf, digits, n, 0, width, pad);
+}
+
+uint8_t Fmt_I64(char *buf, int64_t value, uint8_t width, char pad)
+{
+    char digits[20];
+    uint8_t neg = (value < 0);
+    uint64_t mag = neg ? (uint64_t)(-(value + 1)) + 1u : (uint64_t)value;
+    uint8_t n = Fmt_Digits64(digits, mag);
+    return Fmt_Place(buf, digits, n, neg, width, pad);
+}
+
+// ======================================================
+// Hex / binary (shifts only)
+// ======================================================
+uint8_t Fmt_Hex32(char *buf, uint32_t value, uint8_t digits)
+{
+    return Fmt_Hex64(buf, value, digits);
+}
+
+uint8_t Fmt_Hex64(char *buf, uint64_t value, uint8_t digits)
+{
+    uint8_t n = digits;
+
+    if (n == 0)                                     // natural width
+    {
+        n = 1;
+        while (n < 16 && (value >> (4u * n)))
+            n++;
+    }
+    if (n > 16)
+        n = 16;
+
+    for (uint8_t i = 0; i < n; i++)
+        buf[i] = s_hex[(value >> (4u * (n - 1u - i))) & 0xFu];
+    buf[n] = '\0';
+    return n;
+}
+
+uint8_t Fmt_Bin32(char *buf, uint32_t value, uint8_t digits)
+{
+    return Fmt_Bin64(buf, value, digits);
+}
+
+uint8_t Fmt_Bin64(char *buf, uint64_t value, uint8_t digits)
+{
+    uint8_t n = digits;
+
+    if (n == 0)
+    {
+        n = 1;
+        while (n < 64 && (value >> n))
+            n++;
+    }
+    if (n > 64)
+        n = 64;
+
+    for (uint8_t i = 0; i < n; i++)
+        buf[i] = (char)('0' + ((value >> (n - 1u - i)) & 1u));
+    buf[n] = '\0';
+    return n;
+}
+
+// ======================================================
+// Fixed point / engineering
+// ======================================================
+uint8_t Fmt_Fixed(char *buf, int32_t value, uint8_t fracDigits)
+{
+    char digits[10];
+    uint8_t len = 0;
+    uint8_t neg = (value < 0);
+    uint32_t mag = neg ? (uint32_t)(-(value + 1)) + 1u : (uint32_t)value;
+    uint8_t n = Fmt_Digits32(digits, mag);
+
+    if (fracDigits > 9)
+        fracDigits = 9;
+
+    if (neg)
+        buf[len++] = '-';
+
+    if (n <= fracDigits)                            // 0.xxx
+    {
+        buf[len++] = '0';
+        if (fracDigits)
+            buf[len++] = '.';
+        for (uint8_t i = n; i < fracDigits; i++)
+            buf[len++] = '0';
+        for (uint8_t i = 0; i < n; i++)
+            buf[len++] = digits[i];
+    }
+    else
+    {
+        for (uint8_t i = 0; i < n; i++)
+        {
+            if (i == n - fracDigits)
+                buf[len++] = '.';
+            buf[len++] = digits[i];
+        }
+    }
+
+    buf[len] = '\0';
+    return len;
+}
+
+uint8_t Fmt_Engineering(char *buf, uint64_t value, uint8_t fracDigits)
+{
+    char digits[21];                                // room for a rounding carry
+    uint8_t n = Fmt_Digits64(&digits[1], value);
+    char *d = &digits[1];
+    uint8_t len = 0;
+
+    if (fracDigits > 9)
+        fracDigits = 9;
+
+    uint8_t exp = 0;
+    while ((uint8_t)(exp + 3) < n)                  // exponent = 3 * floor((n - 1) / 3)
+        exp = (uint8_t)(exp + 3);
+    uint8_t intDigits = (uint8_t)(n - exp);
+    uint8_t keep = (uint8_t)(intDigits + fracDigits);
+
+    // Round half up on the digit string
+    if (keep < n && d[keep] >= '5')
+    {
+        int8_t i = (int8_t)(keep - 1);
+        while (i >= 0 && d[i] == '9')
+            d[i--] = '0';
+        if (i >= 0)
+            d[i]++;
+        else
+        {
+            d = &digits[0];                         // carry out: 999.5 -> 1000
+            d[0] = '1';
+            n++;
+            intDigits++;
+            if (intDigits > 3)                      // 1000.0 -> 1.000x10^(e+3)
+            {
+                intDigits = 1;
+                exp = (uint8_t)(exp + 3);
+            }
+        }
+    }
+
+    for (uint8_t i = 0; i < intDigits; i++)
+        buf[len++] = d[i];
+    if (fracDigits)
+    {
+        buf[len++] = '.';
+        for (uint8_t i = 0; i < fracDigits; i++)
+        {
+            uint8_t k = (uint8_t)(intDigits + i);
+            buf[len++] = (k < n) ? d[k] : '0';
+        }
+    }
+
+    buf[len++] = 'x';
+    buf[len++] = '1';
+    buf[len++] = '0';
+    buf[len++] = '^';
+    len = (uint8_t)(len + Fmt_U32(&buf[len], exp, 0, ' '));
+    return len;
+}
+
+// ======================================================
+// ANSI
+// ======================================================
+uint8_t Fmt_Cursor(char *buf, uint8_t row, uint8_t col)
+{
+    uint8_t len = 0;
+
+    buf[len++] = '\033';
+    buf[len++] = '[';
+    len = (uint8_t)(len + Fmt_U32(&buf[len], row, 0, ' '));
+    buf[len++] = ';';
+    len = (uint8_t)(len + Fmt_U32(&buf[len], col, 0, ' '));
+    buf[len++] = 'H';
+    buf[len] = '\0';
+    return len;
+}
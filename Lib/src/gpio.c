@@ -45,7 +45,7 @@ void GPIO_Clear(GPIO_TypeDef* gpio, uint16_t pin)
 void GPIO_Toggle(GPIO_TypeDef* gpio, uint16_t pin)
 {
     if (pin > 15) return;
-    gpio->ODR ^= (1U << pin);                 // XOR to flip bit
+    _GPIO_PortToggle(gpio, (uint16_t)(1U << pin));
 }
 
 int GPIO_Read(GPIO_TypeDef* gpio, uint16_t pin)
@@ -71,7 +71,7 @@ void _GPIO_ClockEnable(GPIO_TypeDef *pPort)
 void _GPIO_PinToggle(GPIO_TypeDef *pPort, int PinNumber)
 {
     if (PinNumber < 0 || PinNumber > 15) return;
-    pPort->ODR ^= (1U << PinNumber);
+    _GPIO_PortToggle(pPort, (uint16_t)(1U << PinNumber));
 }
 
 void _GPIO_PinSet(GPIO_TypeDef *pPort, int PinNumber)
@@ -106,6 +106,24 @@ int _GPIO_GetPinOState(GPIO_TypeDef *pPort, int PinNumber)
     return (pPort->ODR >> PinNumber) & 1U;
 }
 
+//======================================================================
+// Whole-Port Writes (one BSRR store)
+//======================================================================
+
+// ODR ^= mask would write every pin of the port back, undoing whatever
+// an ISR changed on another pin in between. BSRR only touches the pins
+// in the mask: set the ones that were low, reset the ones that were high.
+void _GPIO_PortToggle(GPIO_TypeDef *pPort, uint16_t mask)
+{
+    uint32_t odr = pPort->ODR;
+    pPort->BSRR = ((odr & mask) << 16) | (~odr & mask);
+}
+
+void _GPIO_PortWrite(GPIO_TypeDef *pPort, uint16_t mask, uint16_t value)
+{
+    pPort->BSRR = ((uint32_t)(mask & ~value) << 16) | (mask & value);
+}
+
 //======================================================================
 // Advanced GPIO Functions (ICA08+)
 //======================================================================
@@ -158,4 +176,85 @@ void _GPIO_SetPull(GPIO_TypeDef *pPort, int PinNumber, _GPIO_Pull pull)
     
     // Set pull configuration
     pPort->PUPDR |= ((uint32_t)pull << (PinNumber * 2));
-}
\ No newline at end of file
+}
+
+//======================================================================
+// Batched Configuration
+//======================================================================
+
+// Register images for one port: bits to change (mask) and their values
+typedef struct
+{
+    uint32_t mask2, moder, ospeedr, pupdr;    // 2 bits per pin
+    uint32_t mask1, otyper;                   // 1 bit per pin
+    uint32_t afrMask[2], afr[2];              // 4 bits per pin
+    uint32_t bsrr;                            // initial output levels
+} GPIO_PortImage;
+
+#define GPIO_PORTS  6                         // A, B, C, D, (E), F
+
+static int GPIO_PortIndex(const GPIO_TypeDef *pPort)
+{
+    uint32_t offset = (uint32_t)((uintptr_t)pPort - IOPORT_BASE);
+
+    if (offset % 0x400U || offset / 0x400U >= GPIO_PORTS || offset / 0x400U == 4U)
+        return -1;
+    return (int)(offset / 0x400U);
+}
+
+uint8_t GPIO_ConfigureBatch(const _GPIO_PinConfig *pTable, uint16_t count)
+{
+    GPIO_PortImage img[GPIO_PORTS] = { 0 };
+    uint32_t clocks = 0;
+
+    // Fold the table (check everything before writing anything)
+    for (uint16_t i = 0; i < count; i++)
+    {
+        const _GPIO_PinConfig *c = &pTable[i];
+        int port = GPIO_PortIndex(c->pPort);
+        if (port < 0 || c->pin > 15 || c->mode > 3 || c->af > 7 ||
+            c->type > 1 || c->speed > 3 || c->pull > 2)
+            return 0;
+
+        GPIO_PortImage *p = &img[port];
+        uint32_t sh2 = c->pin * 2U;
+        uint32_t sh4 = (c->pin & 7U) * 4U;
+        uint32_t f2 = 0x3U << sh2;
+        uint32_t f1 = 1U << c->pin;
+        uint8_t r = c->pin >> 3;
+
+        p->mask2 |= f2;
+        p->moder = (p->moder & ~f2) | ((uint32_t)c->mode << sh2);
+        p->ospeedr = (p->ospeedr & ~f2) | ((uint32_t)c->speed << sh2);
+        p->pupdr = (p->pupdr & ~f2) | ((uint32_t)c->pull << sh2);
+        p->mask1 |= f1;
+        p->otyper = (p->otyper & ~f1) | ((uint32_t)c->type << c->pin);
+        p->afrMask[r] |= 0xFU << sh4;
+        p->afr[r] = (p->afr[r] & ~(0xFU << sh4)) | ((uint32_t)c->af << sh4);
+        p->bsrr &= ~(f1 | (f1 << 16));
+        p->bsrr |= c->level ? f1 : (f1 << 16);
+        clocks |= 1U << port;                 // IOPENR bit = port index
+    }
+
+    RCC->IOPENR |= clocks;
+
+    // One write per register; MODER last
+    for (int port = 0; port < GPIO_PORTS; port++)
+    {
+        const GPIO_PortImage *p = &img[port];
+        if (!(clocks & (1U << port)))
+            continue;
+
+        GPIO_TypeDef *gpio = (GPIO_TypeDef *)(IOPORT_BASE + 0x400U * (uint32_t)port);
+        gpio->BSRR = p->bsrr;
+        gpio->OTYPER = (gpio->OTYPER & ~p->mask1) | p->otyper;
+        gpio->OSPEEDR = (gpio->OSPEEDR & ~p->mask2) | p->ospeedr;
+        gpio->PUPDR = (gpio->PUPDR & ~p->mask2) | p->pupdr;
+        if (p->afrMask[0])
+            gpio->AFR[0] = (gpio->AFR[0] & ~p->afrMask[0]) | p->afr[0];
+        if (p->afrMask[1])
+            gpio->AFR[1] = (gpio->AFR[1] & ~p->afrMask[1]) | p->afr[1];
+        gpio->MODER = (gpio->MODER & ~p->mask2) | p->moder;
+    }
+    return 1;
+}
@@ -0,0 +1,225 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  POWER
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   power.c
+//
+//  LPTIM1 free runs over 16 bits (ARR = 0xFFFF, 2 s a lap at 32 kHz);
+//  a Stop is one CMP match away, never more than ~0xF000 ticks.
+//  s_tickQ16 = timebase us per LPTIM tick, Q16.
+//
+//  The LPTIM counter runs on its own clock: CNT is read until two
+//  reads agree, and CMP is only written with the timer enabled, then
+//  CMPOK waited for before sleeping on it.
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include "power.h"
+#include "timebase.h"
+#include "clock.h"
+
+#define POWER_MAX_TICKS   0xF000u
+#define POWER_EXTI_LPTIM1 EXTI_IMR1_IM29           // LPTIM1 wakeup line
+
+static uint8_t s_ready = 0;
+static volatile uint8_t s_blocks = 0;
+static uint32_t s_tickQ16 = 0;
+static uint32_t s_maxUs = 0;
+static uint32_t s_latencyUs = _POWER_WAKE_US;
+static Power_Stats s_stats;
+
+// ======================================================
+// LPTIM1
+// ======================================================
+static uint16_t Power_LptimCount(void)
+{
+    uint32_t a;
+    uint32_t b = LPTIM1->CNT;
+
+    do
+    {
+        a = b;
+        b = LPTIM1->CNT;
+    } while (a != b);
+    return (uint16_t)a;
+}
+
+// Wait for the counter to move, return the new count
+static uint16_t Power_LptimEdge(void)
+{
+    uint16_t c = Power_LptimCount();
+    uint16_t n;
+
+    while ((n = Power_LptimCount()) == c)
+        ;
+    return n;
+}
+
+static uint32_t Power_TicksToUs(uint32_t ticks)
+{
+    return (uint32_t)(((uint64_t)ticks * s_tickQ16 + 0x8000u) >> 16);
+}
+
+void Power_Init(void)
+{
+    RCC->APBENR1 |= RCC_APBENR1_PWREN | RCC_APBENR1_LPTIM1EN;
+
+#if _POWER_USE_LSE
+    RCC->BDCR |= RCC_BDCR_LSEON;
+    while ((RCC->BDCR & RCC_BDCR_LSERDY) == 0u) { }
+    RCC->CCIPR |= RCC_CCIPR_LPTIM1SEL;               // 11 = LSE
+#else
+    RCC->CSR |= RCC_CSR_LSION;
+    while ((RCC->CSR & RCC_CSR_LSIRDY) == 0u) { }
+    RCC->CCIPR = (RCC->CCIPR & ~RCC_CCIPR_LPTIM1SEL) | RCC_CCIPR_LPTIM1SEL_0;   // 01 = LSI
+#endif
+
+    LPTIM1->CR = 0;
+    LPTIM1->CFGR = 0;                                // internal clock, /1
+    LPTIM1->IER = LPTIM_IER_CMPMIE;                  // IER only takes writes while disabled
+    LPTIM1->CR = LPTIM_CR_ENABLE;
+    LPTIM1->ARR = 0xFFFFu;
+    while (!(LPTIM1->ISR & LPTIM_ISR_ARROK)) { }
+    LPTIM1->ICR = LPTIM_ICR_ARROKCF;
+    LPTIM1->CR |= LPTIM_CR_CNTSTRT;
+
+    EXTI->IMR1 |= POWER_EXTI_LPTIM1;
+    NVIC_EnableIRQ(LPTIM1_IRQn);
+    PWR->CR1 = (PWR->CR1 & ~PWR_CR1_LPMS) | _POWER_STOP_LPMS;
+
+    // Tick length against the timebase, edge to edge
+    uint16_t lp0 = Power_LptimEdge();
+    uint32_t t0 = Timebase_Micros32();
+    while ((uint16_t)(Power_LptimEdge() - lp0) < _POWER_CAL_TICKS)
+        ;
+    uint32_t took = Timebase_Micros32() - t0;
+
+    s_tickQ16 = (uint32_t)(((uint64_t)took << 16) / _POWER_CAL_TICKS);
+    s_maxUs = Power_TicksToUs(POWER_MAX_TICKS);
+    s_latencyUs = _POWER_WAKE_US;
+    s_stats.stops = 0;
+    s_stats.sleeps = 0;
+    s_stats.stopUs = 0;
+    s_ready = 1;
+}
+
+// ======================================================
+// Stop
+// ======================================================
+static void Power_Stop(uint32_t us)
+{
+    uint32_t ticks = (uint32_t)(((uint64_t)us << 16) / s_tickQ16);
+    if (ticks > POWER_MAX_TICKS)
+        ticks = POWER_MAX_TICKS;
+
+    uint16_t cmp = (uint16_t)(Power_LptimCount() + ticks);
+    LPTIM1->ICR = LPTIM_ICR_CMPMCF | LPTIM_ICR_CMPOKCF;
+    LPTIM1->CMP = cmp;
+    while (!(LPTIM1->ISR & LPTIM_ISR_CMPOK)) { }
+    LPTIM1->ICR = LPTIM_ICR_CMPOKCF;
+
+    uint16_t lp0 = Power_LptimEdge();                // stamp both clocks together
+    uint32_t t0 = Timebase_Micros32();
+
+    SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+    __WFI();
+    SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+
+    Clock_Restore();                                 // woke on HSI16
+
+    uint16_t lp1 = Power_LptimEdge();
+    uint32_t slept = Power_TicksToUs((uint16_t)(lp1 - lp0));
+    Timebase_Resync(t0 + slept);
+
+    if (LPTIM1->ISR & LPTIM_ISR_CMPM)                // our wakeup: how late is it now
+    {
+        uint16_t late = (uint16_t)(lp1 - cmp);
+        if (late < 0x8000u)
+        {
+            uint32_t lateUs = Power_TicksToUs(late);
+            if (lateUs > s_latencyUs)
+                s_latencyUs = lateUs;                // worst case at once,
+            else
+                s_latencyUs -= (s_latencyUs - lateUs) / 16u;   // easing back slowly
+        }
+        LPTIM1->ICR = LPTIM_ICR_CMPMCF;
+    }
+    NVIC_ClearPendingIRQ(LPTIM1_IRQn);
+
+    s_stats.stops++;
+    s_stats.stopUs += slept;
+}
+
+// USART2 still sending: a byte in TDR or the shifter (TC clear), the
+// TX ring feeding TDR (TXEIE stays on until it runs dry) or a DMA
+// segment in flight. Stop would cut the frame (no USART2 wakeup).
+static uint8_t Power_UsartTxBusy(void)
+{
+    if (!(RCC->APBENR1 & RCC_APBENR1_USART2EN) || !(USART2->CR1 & USART_CR1_UE))
+        return 0;
+    if (!(USART2->ISR & USART_ISR_TC) || (USART2->CR1 & USART_CR1_TXEIE_TXFNFIE))
+        return 1;
+    return (USART2->CR3 & USART_CR3_DMAT) && (DMA1_Channel2->CCR & DMA_CCR_EN) && DMA1_Channel2->CNDTR;
+}
+
+void Power_Idle(void)
+{
+    uint32_t left = s_maxUs;
+    uint32_t at;
+
+    if (Timebase_GetAlarm(&at))
+    {
+        int32_t d = (int32_t)(at - Timebase_Micros32());
+        if (d <= 0)
+            return;                                  // due: let it fire
+        left = (uint32_t)d;
+    }
+
+    if (!s_ready || s_blocks || left < s_latencyUs + _POWER_MIN_STOP_US || Power_UsartTxBusy())
+    {
+        __WFI();
+        s_stats.sleeps++;
+        return;
+    }
+    Power_Stop(left - s_latencyUs);
+}
+
+void Power_Block(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    s_blocks++;
+    __set_PRIMASK(primask);
+}
+
+void Power_Unblock(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (s_blocks)
+        s_blocks--;
+    __set_PRIMASK(primask);
+}
+
+uint32_t Power_GetWakeLatencyUs(void)
+{
+    return s_latencyUs;
+}
+
+void Power_GetStats(Power_Stats *pStats)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *pStats = s_stats;
+    pStats->latencyUs = s_latencyUs;
+    __set_PRIMASK(primask);
+}
+
+// ======================================================
+// LPTIM1 INTERRUPT: a wakeup taken with IRQs on
+// ======================================================
+void LPTIM1_IRQHandler(void)
+{
+    LPTIM1->ICR = LPTIM_ICR_CMPMCF | LPTIM_ICR_ARRMCF;
+}
@@ -0,0 +1,212 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  PROFILER
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   prof.c
+//
+//  SysTick counts DOWN from LOAD to 0, so elapsed = start - end.
+//  Timestamps are turned into an up-counting value (LOAD - VAL) so
+//  Prof_Elapsed is a plain masked subtraction.
+//
+//  With a tick counter, a wrap whose SysTick_Handler has not run yet
+//  (IRQs masked, or called from an equal / higher priority handler)
+//  leaves the exception pending: PENDSTSET with VAL back near LOAD
+//  means one period the counter does not have yet. VAL still near 0
+//  means it was read before the wrap. Good while the handler is held
+//  off for less than half a period.
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include "prof.h"
+#include "usart.h"
+#include "fmt.h"
+
+static volatile uint32_t *s_pTicks = 0;
+static uint32_t s_mask = 0x00FFFFFFu;
+static uint32_t s_overhead = 0;
+static Prof_Scope *s_first = 0;
+static Prof_Scope *s_last = 0;
+static Prof_Scope *s_stack[_PROF_MAX_DEPTH];
+static uint8_t s_depth = 0;
+
+// ======================================================
+// Timestamps
+// ======================================================
+uint32_t Prof_Now(void)
+{
+    uint32_t load = SysTick->LOAD;
+
+    if (!s_pTicks)
+        return load - SysTick->VAL;
+
+    // Re-read if a tick landed between reading the counter and VAL
+    uint32_t ticks, val, pending;
+    do
+    {
+        ticks = *s_pTicks;
+        val = SysTick->VAL;
+        pending = SCB->ICSR & SCB_ICSR_PENDSTSET_Msk;
+    } while (ticks != *s_pTicks);
+
+    if (pending && val > load / 2u)                  // wrapped, handler still to run
+        ticks++;
+    return ticks * (load + 1u) + (load - val);
+}
+
+uint32_t Prof_Elapsed(uint32_t start, uint32_t end)
+{
+    return (end - start) & s_mask;
+}
+
+// ======================================================
+// Setup
+// ======================================================
+void Prof_Init(void)
+{
+    if (!(SysTick->CTRL & SysTick_CTRL_ENABLE_Msk))
+    {
+        SysTick->LOAD = 0x00FFFFFFu;                 // full 24-bit range
+        SysTick->VAL = 0u;
+        SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;   // no interrupt
+    }
+
+    // Calibrate: an empty Begin/End pair should read zero
+    static Prof_Scope cal = PROF_SCOPE_INIT("cal");
+    s_overhead = 0;
+    cal.min = 0xFFFFFFFFu;                           // again on a second Prof_Init
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        Prof_Begin(&cal);
+        Prof_End(&cal);
+    }
+    s_overhead = cal.min;
+
+    // Take the calibration scope back out of the report list (scopes
+    // that ran before Prof_Init stay registered)
+    if (s_last == &cal)
+    {
+        Prof_Scope *p = s_first;
+        if (p == &cal)
+            s_first = s_last = 0;
+        else
+        {
+            while (p->next != &cal)
+                p = p->next;
+            p->next = 0;
+            s_last = p;
+        }
+    }
+    cal.registered = 0;
+}
+
+void Prof_SetTickCounter(volatile uint32_t *pTicks)
+{
+    s_pTicks = pTicks;
+    s_mask = pTicks ? 0xFFFFFFFFu : 0x00FFFFFFu;
+}
+
+// ======================================================
+// Scopes
+// ======================================================
+void Prof_Begin(Prof_Scope *pScope)
+{
+    if (!pScope->registered)
+    {
+        pScope->registered = 1;
+        pScope->next = 0;
+        pScope->parent = s_depth ? s_stack[s_depth - 1] : 0;
+        if (s_last)
+            s_last->next = pScope;
+        else
+            s_first = pScope;
+        s_last = pScope;
+    }
+
+    if (s_depth < _PROF_MAX_DEPTH)
+        s_stack[s_depth] = pScope;
+    s_depth++;
+
+    pScope->start = Prof_Now();                      // last, so setup is not counted
+}
+
+void Prof_End(Prof_Scope *pScope)
+{
+    uint32_t now = Prof_Now();                       // first, so bookkeeping is not counted
+    uint32_t cycles = Prof_Elapsed(pScope->start, now);
+
+    cycles = (cycles > s_overhead) ? (cycles - s_overhead) : 0;
+
+    pScope->count++;
+    pScope->total += cycles;
+    if (cycles < pScope->min) pScope->min = cycles;
+    if (cycles > pScope->max) pScope->max = cycles;
+
+    if (s_depth)
+        s_depth--;
+    if (s_depth && s_depth <= _PROF_MAX_DEPTH)
+        s_stack[s_depth - 1]->child += cycles;
+}
+
+void Prof_Reset(void)
+{
+    for (Prof_Scope *p = s_first; p; p = p->next)
+    {
+        p->count = 0;
+        p->min = 0xFFFFFFFFu;
+        p->max = 0;
+        p->total = 0;
+        p->child = 0;
+    }
+}
+
+// ======================================================
+// Report (fmt only, no printf)
+// ======================================================
+static void Prof_Column(USART_TypeDef *uart, uint64_t value, uint8_t width)
+{
+    char buf[_FMT_DEC64_SIZE];
+    Fmt_U64(buf, value, width, ' ');
+    _USART_TxString(uart, buf);
+}
+
+static uint8_t Prof_Level(const Prof_Scope *pScope)
+{
+    uint8_t level = 0;
+    while ((pScope = pScope->parent) != 0 && level < _PROF_MAX_DEPTH)
+        level++;
+    return level;
+}
+
+static void Prof_ReportTree(USART_TypeDef *uart, Prof_Scope *parent)
+{
+    for (Prof_Scope *p = s_first; p; p = p->next)
+    {
+        if (p->parent != parent)
+            continue;
+
+        uint8_t level = Prof_Level(p);
+        uint8_t col = 0;
+        for (uint8_t i = 0; i < level; i++, col += 2)
+            _USART_TxString(uart, "  ");
+        for (const char *n = p->name; *n && col < 24; n++, col++)
+            _USART_TxByte(uart, *n);
+        while (col++ < 24)
+            _USART_TxByte(uart, ' ');
+
+        Prof_Column(uart, p->count, 10);
+        Prof_Column(uart, p->count ? p->min : 0, 10);
+        Prof_Column(uart, p->count ? p->total / p->count : 0, 10);
+        Prof_Column(uart, p->max, 10);
+        Prof_Column(uart, p->total - p->child, 12);
+        _USART_TxString(uart, "\r\n");
+
+        Prof_ReportTree(uart, p);
+    }
+}
+
+void Prof_Report(USART_TypeDef *uart)
+{
+    _USART_TxString(uart, "\r\nscope                        count       min       avg       max        self\r\n");
+    Prof_ReportTree(uart, 0);
+}
@@ -0,0 +1,218 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  SCHED
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   sched.c
+//
+//  Queues: head/tail are free-running 8-bit counters, so count =
+//  tail - head even across the wrap. The scheduler is the only reader;
+//  posts can come from any interrupt, so they run with IRQs off.
+//
+//  Sleeping: IRQs go off, the queues are checked one last time, then
+//  __WFI. A post landing after the check leaves its interrupt pending,
+//  and a pending interrupt wakes WFI even with PRIMASK set: no lost
+//  wakeup. The ISR runs once IRQs are back on.
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include "sched.h"
+#include "timebase.h"
+#include "usart.h"
+#include "fmt.h"
+
+#define SCHED_MASK  (_SCHED_QUEUE_LEN - 1u)
+
+static Sched_Task *s_pTasks = 0;
+static uint8_t s_count = 0;
+static uint8_t s_turn[_SCHED_PRIORITIES];    // task after the one that ran last, per level
+static volatile uint8_t s_ready[_SCHED_PRIORITIES];   // events queued per level
+static Sched_IdleHook s_idleHook = 0;
+static uint32_t s_since = 0;                 // timebase at the last reset
+static uint64_t s_idleUs = 0;
+
+// ======================================================
+// Setup
+// ======================================================
+void Sched_Init(Sched_Task *pTasks, uint8_t count)
+{
+    s_pTasks = pTasks;
+    s_count = count;
+    for (uint8_t p = 0; p < _SCHED_PRIORITIES; p++)
+    {
+        s_turn[p] = 0;
+        s_ready[p] = 0;
+    }
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (pTasks[i].priority >= _SCHED_PRIORITIES)
+            pTasks[i].priority = _SCHED_PRIORITIES - 1u;
+        pTasks[i].head = pTasks[i].tail;     // drop anything stale
+    }
+    Sched_ResetStats();
+}
+
+void Sched_SetIdleHook(Sched_IdleHook hook)
+{
+    s_idleHook = hook;
+}
+
+// ======================================================
+// Events
+// ======================================================
+uint8_t Sched_Post(Sched_Task *pTask, uint32_t event)
+{
+    uint8_t ok = 0;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if ((uint8_t)(pTask->tail - pTask->head) < _SCHED_QUEUE_LEN)
+    {
+        pTask->queue[pTask->tail & SCHED_MASK] = event;
+        pTask->tail++;
+        s_ready[pTask->priority]++;
+        ok = 1;
+    }
+    else
+        pTask->dropped++;
+    __set_PRIMASK(primask);
+    return ok;
+}
+
+// Most urgent level with work, next task in turn on that level
+static Sched_Task *Sched_Pick(void)
+{
+    for (uint8_t p = 0; p < _SCHED_PRIORITIES; p++)
+    {
+        if (!s_ready[p])
+            continue;
+        for (uint8_t k = 0; k < s_count; k++)
+        {
+            uint8_t i = (uint8_t)((s_turn[p] + k) % s_count);
+            Sched_Task *pTask = &s_pTasks[i];
+            if (pTask->priority == p && pTask->head != pTask->tail)
+            {
+                s_turn[p] = (uint8_t)(i + 1u);
+                return pTask;
+            }
+        }
+    }
+    return 0;
+}
+
+static uint8_t Sched_Pending(void)
+{
+    for (uint8_t p = 0; p < _SCHED_PRIORITIES; p++)
+        if (s_ready[p])
+            return 1;
+    return 0;
+}
+
+uint8_t Sched_RunOnce(void)
+{
+    Sched_Task *pTask = Sched_Pick();
+
+    if (!pTask)
+    {
+        uint32_t primask = __get_PRIMASK();  // the caller's state, not always on
+        __disable_irq();
+        if (!Sched_Pending())
+        {
+            uint32_t start = Timebase_Micros32();
+            if (s_idleHook)
+                s_idleHook();
+            else
+                __WFI();
+            s_idleUs += Timebase_Micros32() - start;
+        }
+        __set_PRIMASK(primask);
+        return 0;
+    }
+
+    uint32_t event = pTask->queue[pTask->head & SCHED_MASK];
+    pTask->head++;                           // slot free before the handler can post again
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    s_ready[pTask->priority]--;
+    __set_PRIMASK(primask);
+
+    uint32_t start = Timebase_Micros32();
+    pTask->handler(pTask, event);
+    uint32_t took = Timebase_Micros32() - start;
+
+    pTask->runs++;
+    pTask->totalUs += took;
+    if (took > pTask->maxUs)
+        pTask->maxUs = took;
+    return 1;
+}
+
+void Sched_Run(void)
+{
+    for (;;)
+        Sched_RunOnce();
+}
+
+// ======================================================
+// Statistics
+// ======================================================
+uint16_t Sched_GetLoad(void)
+{
+    uint32_t elapsed = Timebase_Micros32() - s_since;
+    uint64_t idle = s_idleUs;
+
+    if (!elapsed)
+        return 0;
+    if (idle > elapsed)
+        idle = elapsed;
+    return (uint16_t)(((uint64_t)(elapsed - idle) * 1000u + elapsed / 2u) / elapsed);
+}
+
+void Sched_ResetStats(void)
+{
+    for (uint8_t i = 0; i < s_count; i++)
+    {
+        s_pTasks[i].runs = 0;
+        s_pTasks[i].dropped = 0;
+        s_pTasks[i].maxUs = 0;
+        s_pTasks[i].totalUs = 0;
+    }
+    s_idleUs = 0;
+    s_since = Timebase_Micros32();
+}
+
+static void Sched_Column(USART_TypeDef *uart, uint64_t value, uint8_t width)
+{
+    char buf[_FMT_DEC64_SIZE];
+    Fmt_U64(buf, value, width, ' ');
+    _USART_TxString(uart, buf);
+}
+
+void Sched_Report(USART_TypeDef *uart)
+{
+    char buf[16];
+
+    _USART_TxString(uart, "\r\ntask              pri      runs    max us    avg us    total us   dropped\r\n");
+    for (uint8_t i = 0; i < s_count; i++)
+    {
+        const Sched_Task *pTask = &s_pTasks[i];
+        uint8_t col = 0;
+        for (const char *n = pTask->name; n && *n && col < 16; n++, col++)
+            _USART_TxByte(uart, *n);
+        while (col++ < 16)
+            _USART_TxByte(uart, ' ');
+
+        Sched_Column(uart, pTask->priority, 5);
+        Sched_Column(uart, pTask->runs, 10);
+        Sched_Column(uart, pTask->maxUs, 10);
+        Sched_Column(uart, pTask->runs ? pTask->totalUs / pTask->runs : 0, 10);
+        Sched_Column(uart, pTask->totalUs, 12);
+        Sched_Column(uart, pTask->dropped, 10);
+        _USART_TxString(uart, "\r\n");
+    }
+
+    _USART_TxString(uart, "load ");
+    Fmt_Fixed(buf, Sched_GetLoad(), 1);
+    _USART_TxString(uart, buf);
+    _USART_TxString(uart, " %\r\n");
+}
@@ -0,0 +1,303 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  TERMINAL RENDERER
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   term.c
+//
+//  front = what the terminal shows, back = what the caller drew.
+//  Rows touched since the last flush are tracked in a bitmask so a
+//  flush only compares those rows. Internal coordinates are 0-based.
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include "term.h"
+
+#define TERM_CURSOR_UNKNOWN  0xFFu
+
+static char s_front[_USART_ROWS][_USART_COLS];
+static char s_back[_USART_ROWS][_USART_COLS];
+static uint32_t s_dirtyRows = 0;
+static uint8_t s_repaint = 0;
+static uint8_t s_curRow = TERM_CURSOR_UNKNOWN;
+static uint8_t s_curCol = TERM_CURSOR_UNKNOWN;
+static USART_TypeDef *s_uart = 0;
+
+// ======================================================
+// Output staging (batches writer calls)
+// ======================================================
+static char s_stage[_TERM_STAGE_SIZE];
+static uint16_t s_stageLen = 0;
+static uint16_t s_sent = 0;
+static Term_Writer s_writer = 0;
+
+static void Term_StageFlush(void)
+{
+    if (s_stageLen)
+        s_writer(s_stage, s_stageLen);
+    s_stageLen = 0;
+}
+
+static void Term_Emit(char c)
+{
+    if (s_stageLen == _TERM_STAGE_SIZE)
+        Term_StageFlush();
+    s_stage[s_stageLen++] = c;
+    s_sent++;
+}
+
+static void Term_EmitString(const char *str)
+{
+    while (*str)
+        Term_Emit(*str++);
+}
+
+static void Term_EmitNumber(uint8_t value)
+{
+    if (value >= 100) Term_Emit((char)('0' + value / 100));
+    if (value >= 10)  Term_Emit((char)('0' + (value / 10) % 10));
+    Term_Emit((char)('0' + value % 10));
+}
+
+static uint8_t Term_Digits(uint8_t value)
+{
+    return (value >= 100) ? 3 : (value >= 10) ? 2 : 1;
+}
+
+static void Term_UsartWriter(const char *data, uint16_t len)
+{
+    while (len--)
+        _USART_TxByte(s_uart, *data++);
+}
+
+// ======================================================
+// Cursor movement: pick the shortest sequence
+// ======================================================
+static void Term_MoveTo(uint8_t row, uint8_t col)
+{
+    if (row == s_curRow && col == s_curCol)
+        return;
+
+    // ESC [ r ; c H
+    uint8_t cupLen = (uint8_t)(4 + Term_Digits(row + 1) + Term_Digits(col + 1));
+
+    if (row == s_curRow && s_curCol != TERM_CURSOR_UNKNOWN && col > s_curCol)
+    {
+        uint8_t ahead = (uint8_t)(col - s_curCol);
+        uint8_t cufLen = (uint8_t)(3 + Term_Digits(ahead));     // ESC [ n C
+
+        if (ahead <= cufLen && ahead <= cupLen)
+        {
+            for (uint8_t c = s_curCol; c < col; c++)                // cells match: just resend
+                Term_Emit(s_back[row][c]);
+        }
+        else if (cufLen < cupLen)
+        {
+            Term_EmitString("\033[");
+            Term_EmitNumber(ahead);
+            Term_Emit('C');
+        }
+        else
+        {
+            Term_EmitString("\033[");
+            Term_EmitNumber((uint8_t)(row + 1));
+            Term_Emit(';');
+            Term_EmitNumber((uint8_t)(col + 1));
+            Term_Emit('H');
+        }
+    }
+    else if (col == 0 && s_curRow != TERM_CURSOR_UNKNOWN && row == s_curRow + 1)
+    {
+        Term_EmitString("\r\n");                                    // next line, no scroll (row < last)
+    }
+    else if (row == 0 && col == 0)
+    {
+        Term_EmitString("\033[H");
+    }
+    else
+    {
+        Term_EmitString("\033[");
+        Term_EmitNumber((uint8_t)(row + 1));
+        Term_Emit(';');
+        Term_EmitNumber((uint8_t)(col + 1));
+        Term_Emit('H');
+    }
+
+    s_curRow = row;
+    s_curCol = col;
+}
+
+// After writing the last column the terminal is in its pending-wrap
+// state, so the next move always uses an absolute position.
+static void Term_Advance(uint8_t col)
+{
+    s_curCol = (col >= _USART_COLS) ? TERM_CURSOR_UNKNOWN : col;
+    if (s_curCol == TERM_CURSOR_UNKNOWN)
+        s_curRow = TERM_CURSOR_UNKNOWN;
+}
+
+static uint8_t Term_RestBlank(uint8_t row, uint8_t col)
+{
+    for (uint8_t c = col; c < _USART_COLS; c++)
+        if (s_back[row][c] != ' ')
+            return 0;
+    return 1;
+}
+
+// Least the row costs cell by cell from col: the run itself, plus a
+// move (3+ bytes) and a cell if anything past it changed as well
+static uint8_t Term_TailCost(uint8_t row, uint8_t col, uint8_t end)
+{
+    for (uint8_t c = end; c < _USART_COLS; c++)
+        if (s_back[row][c] != s_front[row][c])
+            return (uint8_t)(end - col + 4u);
+    return (uint8_t)(end - col);
+}
+
+static void Term_DiffRow(uint8_t row)
+{
+    uint8_t col = 0;
+
+    while (col < _USART_COLS)
+    {
+        if (s_back[row][col] == s_front[row][col])
+        {
+            col++;
+            continue;
+        }
+
+        // Extend the run across short stretches of unchanged cells
+        uint8_t end = (uint8_t)(col + 1);
+        uint8_t gap = 0;
+        for (uint8_t c = end; c < _USART_COLS; c++)
+        {
+            if (s_back[row][c] != s_front[row][c])
+            {
+                end = (uint8_t)(c + 1);
+                gap = 0;
+            }
+            else if (++gap > _TERM_GAP_MAX)
+                break;
+        }
+
+        Term_MoveTo(row, col);
+
+        // Blank tail: erase to end of line when ESC [ K (3 bytes) is
+        // shorter than sending what changed
+        if (Term_TailCost(row, col, end) > 3 && Term_RestBlank(row, col))
+        {
+            Term_EmitString("\033[K");
+            for (uint8_t c = col; c < _USART_COLS; c++)
+                s_front[row][c] = ' ';
+            return;
+        }
+
+        for (uint8_t c = col; c < end; c++)
+        {
+            Term_Emit(s_back[row][c]);
+            s_front[row][c] = s_back[row][c];
+        }
+        Term_Advance(end);
+        col = end;
+    }
+}
+
+// ======================================================
+// PUBLIC API
+// ======================================================
+void Term_Init(USART_TypeDef *uart)
+{
+    s_uart = uart;
+
+    for (uint8_t r = 0; r < _USART_ROWS; r++)
+        for (uint8_t c = 0; c < _USART_COLS; c++)
+        {
+            s_front[r][c] = ' ';
+            s_back[r][c] = ' ';
+        }
+
+    s_dirtyRows = 0;
+    s_repaint = 0;
+
+    if (uart)
+    {
+        _USART_ClearScreen(uart);       // leaves the cursor at home
+        s_curRow = 0;
+        s_curCol = 0;
+    }
+    else
+    {
+        s_curRow = TERM_CURSOR_UNKNOWN;
+        s_curCol = TERM_CURSOR_UNKNOWN;
+    }
+}
+
+void Term_Clear(void)
+{
+    for (uint8_t r = 0; r < _USART_ROWS; r++)
+        for (uint8_t c = 0; c < _USART_COLS; c++)
+            s_back[r][c] = ' ';
+    s_dirtyRows = (_USART_ROWS >= 32) ? 0xFFFFFFFFu : ((1UL << _USART_ROWS) - 1u);
+}
+
+void Term_Invalidate(void)
+{
+    s_repaint = 1;
+}
+
+void Term_PutCharXY(uint8_t col, uint8_t row, char c)
+{
+    if (col < 1 || col > _USART_COLS || row < 1 || row > _USART_ROWS)
+        return;
+
+    s_back[row - 1][col - 1] = c;
+    s_dirtyRows |= (1UL << (row - 1));
+}
+
+void Term_PutStringXY(uint8_t col, uint8_t row, const char *str)
+{
+    if (col < 1 || row < 1 || row > _USART_ROWS)
+        return;
+
+    char *cell = &s_back[row - 1][col - 1];
+    while (*str && col <= _USART_COLS)
+    {
+        *cell++ = *str++;
+        col++;
+    }
+    s_dirtyRows |= (1UL << (row - 1));
+}
+
+uint16_t Term_FlushTo(Term_Writer writer)
+{
+    s_writer = writer;
+    s_sent = 0;
+    s_stageLen = 0;
+
+    if (s_repaint)
+    {
+        Term_EmitString("\033[2J\033[H");
+        for (uint8_t r = 0; r < _USART_ROWS; r++)
+            for (uint8_t c = 0; c < _USART_COLS; c++)
+                s_front[r][c] = ' ';
+        s_dirtyRows = (_USART_ROWS >= 32) ? 0xFFFFFFFFu : ((1UL << _USART_ROWS) - 1u);
+        s_curRow = 0;
+        s_curCol = 0;
+        s_repaint = 0;
+    }
+
+    for (uint8_t r = 0; r < _USART_ROWS; r++)
+        if (s_dirtyRows & (1UL << r))
+            Term_DiffRow(r);
+    s_dirtyRows = 0;
+
+    Term_StageFlush();
+    return s_sent;
+}
+
+uint16_t Term_Flush(void)
+{
+    if (!s_uart)
+        return 0;
+    return Term_FlushTo(Term_UsartWriter);
+}
@@ -0,0 +1,159 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  TIMEBASE
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   timebase.c
+//
+//  TIM2: PSC = timer clock / 1 MHz - 1, ARR = 0xFFFFFFFF, UIE.
+//  s_laps is the only state the ISR writes; a 32-bit store is atomic
+//  on the M0+, so readers never see half of it.
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include "timebase.h"
+#include "clock.h"
+
+static volatile uint32_t s_laps = 0;
+static uint8_t s_running = 0;
+static Timebase_AlarmCallback s_alarmCb = 0;
+
+// Clock lib listener: PSC follows SYSCLK, with IRQs still off
+static void Timebase_OnClockChange(Clock_ChangePhase phase, uint32_t oldHz, uint32_t newHz)
+{
+    (void)oldHz;
+    (void)newHz;
+    if (phase == CLOCK_CHANGE_AFTER)
+        Timebase_Init();
+}
+
+void Timebase_Init(void)
+{
+    uint32_t clk = Clock_GetSysclkHz();
+    uint32_t psc = (clk + _TIMEBASE_HZ / 2u) / _TIMEBASE_HZ;
+
+    RCC->APBENR1 |= RCC_APBENR1_TIM2EN;
+    TIM2->PSC = (psc > 0u) ? psc - 1u : 0u;
+
+    if (s_running)                                   // clock change: PSC loads at the next lap,
+    {                                                // so force it without touching CNT
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        uint32_t cnt = TIM2->CNT;
+        TIM2->EGR = TIM_EGR_UG;                      // URS = 1: no lap counted
+        TIM2->CNT = cnt;
+        __set_PRIMASK(primask);
+        return;
+    }
+
+    TIM2->CR1 = TIM_CR1_URS;                         // only overflows set UIF
+    TIM2->ARR = 0xFFFFFFFFu;
+    TIM2->CNT = 0;
+    TIM2->EGR = TIM_EGR_UG;                          // load PSC now
+    TIM2->SR = 0;
+    TIM2->DIER |= TIM_DIER_UIE;
+    s_laps = 0;
+    NVIC_EnableIRQ(TIM2_IRQn);
+    TIM2->CR1 |= TIM_CR1_CEN;
+    s_running = 1;
+    Clock_Subscribe(Timebase_OnClockChange);
+}
+
+uint64_t Timebase_Micros(void)
+{
+    uint32_t laps;
+    uint32_t cnt;
+    uint32_t sr;
+
+    do
+    {
+        laps = s_laps;
+        cnt = TIM2->CNT;
+        sr = TIM2->SR;                               // UIF of the same lap count
+    } while (laps != s_laps);                        // ISR ran in between: again
+
+    if ((sr & TIM_SR_UIF) && cnt < 0x80000000u)      // wrapped, ISR not run yet
+        laps++;
+    return ((uint64_t)laps << 32) | cnt;
+}
+
+uint64_t Timebase_Millis(void)
+{
+    return Timebase_Micros() / 1000u;
+}
+
+void Timebase_DelayUs(uint32_t us)
+{
+    uint32_t start = TIM2->CNT;
+
+    while ((uint32_t)(TIM2->CNT - start) < us)
+        ;
+}
+
+// ======================================================
+// Alarm (CH1 output compare, frozen: no pin)
+// ======================================================
+void Timebase_SetAlarm(uint32_t atUs, Timebase_AlarmCallback cb)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    s_alarmCb = cb;
+    TIM2->CCR1 = atUs;
+    TIM2->SR = (uint32_t)~TIM_SR_CC1IF;
+    TIM2->DIER |= TIM_DIER_CC1IE;
+    if ((int32_t)(TIM2->CNT - atUs) >= 0)            // already passed: no match coming
+        TIM2->EGR = TIM_EGR_CC1G;
+    __set_PRIMASK(primask);
+}
+
+void Timebase_CancelAlarm(void)
+{
+    TIM2->DIER &= ~TIM_DIER_CC1IE;
+    TIM2->SR = (uint32_t)~TIM_SR_CC1IF;
+}
+
+uint8_t Timebase_GetAlarm(uint32_t *pAtUs)
+{
+    if (!(TIM2->DIER & TIM_DIER_CC1IE))
+        return 0;
+    *pAtUs = TIM2->CCR1;
+    return 1;
+}
+
+void Timebase_Resync(uint32_t nowUs)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t cnt = TIM2->CNT;
+    uint32_t ahead = nowUs - cnt;
+    if ((int32_t)ahead > 0)
+    {
+        TIM2->CNT = nowUs;                           // a CNT write makes no update event
+        if (nowUs < cnt)
+            s_laps++;                                // so count the lap it skipped here
+        if ((TIM2->DIER & TIM_DIER_CC1IE) && TIM2->CCR1 - cnt <= ahead)
+            TIM2->EGR = TIM_EGR_CC1G;                // alarm was inside the jump
+    }
+    __set_PRIMASK(primask);
+}
+
+// ======================================================
+// TIM2 INTERRUPT: laps of the 32-bit counter, alarm
+// ======================================================
+void TIM2_IRQHandler(void)
+{
+    uint32_t sr = TIM2->SR;
+
+    if (sr & TIM_SR_UIF)
+    {
+        TIM2->SR = (uint32_t)~TIM_SR_UIF;            // rc_w0: clears UIF only
+        s_laps++;
+    }
+    if ((sr & TIM_SR_CC1IF) && (TIM2->DIER & TIM_DIER_CC1IE))
+    {
+        TIM2->SR = (uint32_t)~TIM_SR_CC1IF;
+        TIM2->DIER &= ~TIM_DIER_CC1IE;               // one shot
+        if (s_alarmCb)
+            s_alarmCb();                             // may set the next alarm
+    }
+}
@@ -0,0 +1,373 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  TRIM
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   trim.c
+//
+//  IC1 on TI1, prescaler /8, rising edges; the timer free runs over
+//  16 bits at SYSCLK. Only the differences between captures are
+//  summed, so the counter wrapping does not matter as long as 8
+//  reference periods fit in 65536 ticks (32 kHz references up to
+//  ~250 MHz, a pin reference from SYSCLK * 8 / 65536 up). Trim_Init
+//  and every measurement check that. The first capture only sets the
+//  starting point.
+//
+//  A measurement is only kept if SystemCoreClock did not change
+//  under it (clock lib switch in between).
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include "trim.h"
+#include "clock.h"
+#include "wheel.h"
+
+#define TRIM_EDGES    8u                   // reference edges per capture (IC1PSC = /8)
+#define TRIM_MAX      127u
+
+static TIM_TypeDef *s_pTim = 0;
+static IRQn_Type s_irq;
+static uint32_t s_refHz = 0;
+static Trim_Status s_status;
+static Wheel_Timer s_wheel;
+
+// Tracking window (TIMx interrupt)
+static volatile uint8_t s_busy = 0;
+static int8_t s_first = 0;
+static uint32_t s_count = 0;
+static uint32_t s_sum = 0;
+static uint16_t s_last = 0;
+static uint32_t s_clk = 0;
+
+// ======================================================
+// HSITRIM
+// ======================================================
+static uint8_t Trim_Get(void)
+{
+    return (uint8_t)((RCC->ICSCR & RCC_ICSCR_HSITRIM) >> RCC_ICSCR_HSITRIM_Pos);
+}
+
+static void Trim_Set(uint8_t trim)
+{
+    RCC->ICSCR = (RCC->ICSCR & ~RCC_ICSCR_HSITRIM) | ((uint32_t)trim << RCC_ICSCR_HSITRIM_Pos);
+}
+
+// SYSCLK from HSI16, directly or through the PLL
+static uint8_t Trim_OnHsi(void)
+{
+    uint32_t sws = RCC->CFGR & RCC_CFGR_SWS;
+
+    if (sws == (RCC_CFGR_SWS_1))
+        return (RCC->PLLCFGR & RCC_PLLCFGR_PLLSRC) == RCC_PLLCFGR_PLLSRC_HSI;
+    return sws == 0u;
+}
+
+// 8 reference periods inside the 16-bit counter at clk
+static uint8_t Trim_Fits(uint32_t clk)
+{
+    return (uint64_t)clk * TRIM_EDGES < ((uint64_t)s_refHz << 16);
+}
+
+// ticks against the ticks expected at the nominal clock, in ppm
+static int32_t Trim_Ppm(uint32_t ticks, uint32_t clk)
+{
+    int64_t expected = (int64_t)_TRIM_CAPTURES * TRIM_EDGES * clk;    // in 1/refHz
+    int64_t measured = (int64_t)ticks * s_refHz;
+    int64_t diff = (measured - expected) * 1000000;
+
+    return (int32_t)((diff + ((diff < 0) ? -expected / 2 : expected / 2)) / expected);
+}
+
+// ======================================================
+// Setup
+// ======================================================
+static uint8_t Trim_StartLse(void)
+{
+    uint32_t polls = _TRIM_LSE_POLLS;
+
+    RCC->APBENR1 |= RCC_APBENR1_PWREN;
+    PWR->CR1 |= PWR_CR1_DBP;                         // BDCR is write protected
+    RCC->BDCR |= RCC_BDCR_LSEON;
+    while ((RCC->BDCR & RCC_BDCR_LSERDY) == 0u)
+        if (--polls == 0u)
+            return 0;
+    return 1;
+}
+
+static uint8_t Trim_StartHse(void)
+{
+    uint32_t polls = _CLOCK_HSE_TIMEOUT;
+
+#if _CLOCK_HSE_BYPASS
+    RCC->CR |= RCC_CR_HSEBYP;
+#endif
+    RCC->CR |= RCC_CR_HSEON;
+    while ((RCC->CR & RCC_CR_HSERDY) == 0u)
+        if (--polls == 0u)
+            return 0;
+    return 1;
+}
+
+uint8_t Trim_Init(Trim_Ref ref, uint32_t pinHz)
+{
+    uint32_t sel = 0;
+
+    Trim_StopTracking();
+    s_pTim = 0;
+    switch (ref)
+    {
+        case TRIM_REF_LSE:
+            if (!Trim_StartLse())
+                return 0;
+            s_refHz = 32768u;
+            sel = TIM_TISEL_TI1SEL_1;                // TIM16 TI1 = LSE
+            break;
+        case TRIM_REF_LSI:
+            RCC->CSR |= RCC_CSR_LSION;
+            while ((RCC->CSR & RCC_CSR_LSIRDY) == 0u) { }
+            s_refHz = 32000u;
+            sel = TIM_TISEL_TI1SEL_0;                // TIM16 TI1 = LSI
+            break;
+        case TRIM_REF_HSE:
+            if (!Trim_StartHse())
+                return 0;
+            s_refHz = _CLOCK_HSE_HZ / 32u;
+            sel = TIM_TISEL_TI1SEL_0;                // TIM17 TI1 = HSE / 32
+            break;
+        default:
+            if (!pinHz)
+                return 0;
+            s_refHz = pinHz;                         // TIM16_CH1 pin
+            break;
+    }
+    if (!Trim_Fits(SystemCoreClock))                 // slower than the counter can span
+        return 0;
+
+    if (ref == TRIM_REF_HSE)
+    {
+        RCC->APBENR2 |= RCC_APBENR2_TIM17EN;
+        s_pTim = TIM17;
+        s_irq = TIM17_IRQn;
+    }
+    else
+    {
+        RCC->APBENR2 |= RCC_APBENR2_TIM16EN;
+        s_pTim = TIM16;
+        s_irq = TIM16_IRQn;
+    }
+
+    s_pTim->CR1 = 0;
+    s_pTim->DIER = 0;
+    s_pTim->PSC = 0;                                 // SYSCLK ticks
+    s_pTim->ARR = 0xFFFFu;
+    s_pTim->CCER = 0;
+    s_pTim->CCMR1 = TIM_CCMR1_CC1S_0 | TIM_CCMR1_IC1PSC;   // IC1 = TI1, every 8th edge
+    s_pTim->TISEL = sel;
+    s_pTim->CCER = TIM_CCER_CC1E;                    // rising edges
+    s_pTim->EGR = TIM_EGR_UG;
+    s_pTim->SR = 0;
+    s_pTim->CR1 = TIM_CR1_CEN;
+
+    s_status.trim = Trim_Get();
+    return 1;
+}
+
+// ======================================================
+// Measuring
+// ======================================================
+static uint8_t Trim_WaitCapture(uint16_t *pCcr)
+{
+    uint32_t polls = _TRIM_POLLS;
+
+    while (!(s_pTim->SR & TIM_SR_CC1IF))
+        if (--polls == 0u)
+            return 0;                                // reference gone
+    *pCcr = (uint16_t)s_pTim->CCR1;                  // clears CC1IF
+    return 1;
+}
+
+// One window; 0 if a capture was lost (a long interrupt) or the reference stopped
+static uint8_t Trim_Window(uint32_t *pTicks)
+{
+    uint16_t last, ccr;
+    uint32_t sum = 0;
+
+    s_pTim->SR = 0;
+    if (!Trim_WaitCapture(&last))
+        return 0;
+    s_pTim->SR = (uint32_t)~TIM_SR_CC1OF;            // start clean from here
+
+    for (uint32_t i = 0; i < _TRIM_CAPTURES; i++)
+    {
+        if (!Trim_WaitCapture(&ccr) || (s_pTim->SR & TIM_SR_CC1OF))
+            return 0;
+        sum += (uint16_t)(ccr - last);
+        last = ccr;
+    }
+    *pTicks = sum;
+    return 1;
+}
+
+uint8_t Trim_Measure(int32_t *pPpm)
+{
+    uint32_t ticks;
+
+    if (!s_pTim || s_busy || !Trim_OnHsi())
+        return 0;
+
+    uint32_t clk = SystemCoreClock;
+    if (!Trim_Fits(clk))                             // SYSCLK raised past the reference
+        return 0;
+    for (uint8_t tries = 0; tries < _TRIM_TRIES; tries++)
+    {
+        if (!Trim_Window(&ticks))
+            continue;
+        if (clk != SystemCoreClock)
+            return 0;
+        *pPpm = Trim_Ppm(ticks, clk);
+        s_status.errorPpm = *pPpm;
+        return 1;
+    }
+    return 0;
+}
+
+static uint8_t Trim_MeasureAt(uint8_t trim, int32_t *pPpm)
+{
+    Trim_Set(trim);
+    return Trim_Measure(pPpm);
+}
+
+// Smallest code with error >= 0, then the better of it and the one below
+uint8_t Trim_Calibrate(Trim_Status *pStatus)
+{
+    uint8_t was = Trim_Get();
+    uint8_t lo = 0, hi = TRIM_MAX;
+    int32_t ppm, below;
+
+    while (lo < hi)
+    {
+        uint8_t mid = (uint8_t)((lo + hi) / 2u);
+        if (!Trim_MeasureAt(mid, &ppm))
+        {
+            Trim_Set(was);
+            return 0;
+        }
+        if (ppm >= 0)
+            hi = mid;
+        else
+            lo = (uint8_t)(mid + 1u);
+    }
+
+    if (!Trim_MeasureAt(lo, &ppm) || (lo && !Trim_MeasureAt((uint8_t)(lo - 1u), &below)))
+    {
+        Trim_Set(was);
+        return 0;
+    }
+    if (lo)
+    {
+        s_status.stepPpm = ppm - below;
+        if (-below < ppm)                            // the code below is closer
+        {
+            lo--;
+            ppm = below;
+        }
+    }
+    Trim_Set(lo);
+    s_status.trim = lo;
+    s_status.errorPpm = ppm;
+    if (pStatus)
+        Trim_GetStatus(pStatus);
+    return 1;
+}
+
+// ======================================================
+// Tracking
+// ======================================================
+static void Trim_OnWheel(void *pArg)
+{
+    (void)pArg;
+    if (s_busy || !Trim_OnHsi() || !Trim_Fits(SystemCoreClock))
+        return;
+
+    s_busy = 1;
+    s_first = 1;
+    s_count = 0;
+    s_sum = 0;
+    s_clk = SystemCoreClock;
+    s_pTim->SR = 0;
+    s_pTim->DIER = TIM_DIER_CC1IE;
+    NVIC_ClearPendingIRQ(s_irq);
+    NVIC_EnableIRQ(s_irq);
+}
+
+void Trim_IRQHandler(void)
+{
+    if (!s_pTim || !(s_pTim->SR & TIM_SR_CC1IF))
+        return;
+
+    uint16_t ccr = (uint16_t)s_pTim->CCR1;
+    if (s_pTim->SR & TIM_SR_CC1OF)                   // interrupt came too late: start over
+    {
+        s_pTim->SR = (uint32_t)~TIM_SR_CC1OF;
+        s_first = 1;
+        s_count = 0;
+        s_sum = 0;
+    }
+    if (s_first)
+    {
+        s_first = 0;
+        s_last = ccr;
+        return;
+    }
+    s_sum += (uint16_t)(ccr - s_last);
+    s_last = ccr;
+    if (++s_count < _TRIM_CAPTURES)
+        return;
+
+    s_pTim->DIER = 0;
+    s_busy = 0;
+    if (s_clk != SystemCoreClock)
+        return;                                      // SYSCLK moved: try next time
+
+    int32_t ppm = Trim_Ppm(s_sum, s_clk);
+    int32_t half = s_status.stepPpm / 2;
+    uint8_t trim = Trim_Get();
+
+    s_status.errorPpm = ppm;
+    if (ppm > half && trim > 0u)
+        trim--;
+    else if (ppm < -half && trim < TRIM_MAX)
+        trim++;
+    else
+        return;
+    Trim_Set(trim);
+    s_status.trim = trim;
+    s_status.adjusts++;
+}
+
+uint8_t Trim_StartTracking(uint32_t periodMs)
+{
+    if (!s_pTim || s_status.stepPpm <= 0)
+        return 0;
+
+    uint32_t ticks = (periodMs * 1000u + _WHEEL_TICK_US - 1u) / _WHEEL_TICK_US;
+    Wheel_Arm(&s_wheel, ticks, ticks, Trim_OnWheel, 0);
+    return 1;
+}
+
+void Trim_StopTracking(void)
+{
+    Wheel_Cancel(&s_wheel);
+    if (s_pTim)
+        s_pTim->DIER = 0;
+    s_busy = 0;
+}
+
+void Trim_GetStatus(Trim_Status *pStatus)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *pStatus = s_status;
+    pStatus->trim = Trim_Get();
+    __set_PRIMASK(primask);
+}
@@ -1,5 +1,227 @@
 #include "usart.h"
-#include <stdio.h>
+#include "ringbuf.h"
+#include "fmt.h"
+#include "clock.h"
+#include <string.h>
+
+// ======================================================
+// BUFFERED MODE STATE (USART2)
+// TX ring: main loop produces, USART2_IRQHandler consumes
+// RX ring: USART2_IRQHandler produces, main loop consumes
+// ======================================================
+static uint8_t s_txData[_USART_TX_BUFFSIZE];
+static uint8_t s_rxData[_USART_RX_BUFFSIZE];
+static Ring_Buffer s_txRing;
+static Ring_Buffer s_rxRing;
+static volatile uint8_t s_buffered = 0;
+static volatile uint32_t s_rxDropped = 0;
+static volatile uint32_t s_rxOverruns = 0;
+
+// ======================================================
+// DMA TX STATE (USART2 -> DMA1 Channel 2)
+// s_dmaFillIdx is the segment the CPU appends to; the other
+// one (if s_dmaBusy) is owned by the DMA channel.
+// ======================================================
+static uint8_t s_dmaSeg[2][_USART_DMA_SEGSIZE];
+static volatile uint16_t s_dmaFill = 0;
+static volatile uint8_t s_dmaFillIdx = 0;
+static volatile uint8_t s_dmaBusy = 0;
+static volatile uint8_t s_dmaTx = 0;
+static _USART_TxDoneCallback s_txDoneCb = 0;
+
+// ======================================================
+// DMA RX STATE (DMA1 Channel 3 -> circular s_dmaRx)
+// DMA owns the write position (derived from CNDTR),
+// the application owns s_dmaRxRead. s_dmaRxUnread counts
+// the bytes between them, so a full ring (write == read)
+// is not taken for an empty one.
+// ======================================================
+static uint8_t s_dmaRx[_USART_DMA_RXSIZE];
+static volatile uint16_t s_dmaRxRead = 0;
+static volatile uint16_t s_dmaRxSeen = 0;          // write position at the last look
+static volatile uint16_t s_dmaRxUnread = 0;
+static volatile uint8_t s_dmaRxOn = 0;
+static uint16_t s_dmaRxHighWater = 0;
+static _USART_RxIdleCallback s_rxIdleCb = 0;
+
+// ======================================================
+// CLOCK-CHANGE STATE (USART2 follows SYSCLK)
+// ======================================================
+static uint32_t s_baud = 0;
+static uint32_t s_pausedCr1 = 0;
+static uint32_t s_pausedCr3 = 0;
+
+static uint8_t _USART_IsBuffered(USART_TypeDef *uart)
+{
+    return (uart == USART2) && s_buffered;
+}
+
+static uint8_t _USART_IsDmaTx(USART_TypeDef *uart)
+{
+    return (uart == USART2) && s_dmaTx;
+}
+
+static uint8_t _USART_IsDmaRx(USART_TypeDef *uart)
+{
+    return (uart == USART2) && s_dmaRxOn;
+}
+
+static uint16_t _USART_DmaRxWritePos(void)
+{
+    uint16_t pos = (uint16_t)(_USART_DMA_RXSIZE - DMA1_Channel3->CNDTR);
+    return (pos >= _USART_DMA_RXSIZE) ? 0 : pos;    // CNDTR reload window
+}
+
+// Fold what DMA wrote since the last look into s_dmaRxUnread.
+// HT / TC make this run at least every half ring, so one step
+// is never a whole lap. Past a full ring the oldest bytes were
+// overwritten: they count as dropped and reading restarts at
+// the oldest byte still there (the write position).
+static uint16_t _USART_DmaRxUpdate(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    uint16_t wr = _USART_DmaRxWritePos();
+    uint32_t unread = s_dmaRxUnread + (uint16_t)((wr + _USART_DMA_RXSIZE - s_dmaRxSeen) % _USART_DMA_RXSIZE);
+
+    s_dmaRxSeen = wr;
+    if (unread > _USART_DMA_RXSIZE)
+    {
+        s_rxDropped += unread - _USART_DMA_RXSIZE;
+        unread = _USART_DMA_RXSIZE;
+        s_dmaRxRead = wr;
+    }
+    s_dmaRxUnread = (uint16_t)unread;
+
+    __set_PRIMASK(primask);
+    return (uint16_t)unread;
+}
+
+// Called from the IDLE / HT / TC interrupts
+static void _USART_DmaRxEvent(void)
+{
+    uint16_t avail = _USART_DmaRxUpdate();
+
+    if (avail > s_dmaRxHighWater)
+        s_dmaRxHighWater = avail;
+    if (avail && s_rxIdleCb)
+        s_rxIdleCb(avail);
+}
+
+static void _USART_DmaStart(const void *data, uint16_t len)
+{
+    DMA1_Channel2->CCR &= ~DMA_CCR_EN;
+    DMA1->IFCR = DMA_IFCR_CGIF2;
+    DMA1_Channel2->CMAR = (uint32_t)(uintptr_t)data;
+    DMA1_Channel2->CNDTR = len;
+    s_dmaBusy = 1;
+    DMA1_Channel2->CCR |= DMA_CCR_EN;
+}
+
+// Hand the fill segment to DMA and flip. Caller masks interrupts.
+static void _USART_DmaStartFill(void)
+{
+    if (s_dmaFill == 0)
+    {
+        s_dmaBusy = 0;
+        return;
+    }
+
+    _USART_DmaStart(s_dmaSeg[s_dmaFillIdx], s_dmaFill);
+    s_dmaFillIdx ^= 1u;
+    s_dmaFill = 0;
+}
+
+// Append to the fill segment, starting DMA whenever it is idle.
+// Only spins while both segments are full.
+static void _USART_DmaWrite(const uint8_t *data, uint16_t len)
+{
+    while (len)
+    {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+
+        uint16_t room = (uint16_t)(_USART_DMA_SEGSIZE - s_dmaFill);
+        uint16_t n = (len < room) ? len : room;
+
+        memcpy(&s_dmaSeg[s_dmaFillIdx][s_dmaFill], data, n);
+        s_dmaFill = (uint16_t)(s_dmaFill + n);
+        if (!s_dmaBusy)
+            _USART_DmaStartFill();
+
+        __set_PRIMASK(primask);
+
+        data += n;
+        len = (uint16_t)(len - n);
+        if (len)
+            while (s_dmaBusy && s_dmaFill == _USART_DMA_SEGSIZE);
+    }
+}
+
+// Kick the TX interrupt after queueing. The ISR only ever clears
+// TXEIE, so losing that clear to this read-modify-write just costs
+// one extra (empty) interrupt.
+static void _USART_KickTx(void)
+{
+    USART2->CR1 |= USART_CR1_TXEIE_TXFNFIE;
+}
+
+// Interrupts masked, or called from a handler the TX IRQ may not
+// preempt: nothing else drains the TX ring, so move one byte by hand
+static uint8_t _USART_TxPollOne(void)
+{
+    if (!__get_PRIMASK() && !__get_IPSR())
+        return 0;
+
+    uint32_t primask = __get_PRIMASK();
+    uint8_t c;
+
+    __disable_irq();
+    while (!(USART2->ISR & USART_ISR_TXE_TXFNF));
+    if (Ring_Get(&s_txRing, &c))
+        USART2->TDR = c;
+    __set_PRIMASK(primask);
+    return 1;
+}
+
+// Nearest divider, not the one below: 64 MHz / 115200 is 555.56
+static uint32_t _USART_Brr(uint32_t clk, uint32_t baud)
+{
+    return (clk + baud / 2u) / baud;
+}
+
+// BEFORE: stop feeding TDR (ISR and DMA) and let the shifter empty,
+// so no frame goes out half at one rate and half at the other.
+// AFTER (IRQs off): new BRR, then whatever was feeding TDR resumes.
+// A byte arriving during the switch itself can still come in garbled.
+static void _USART_OnClockChange(Clock_ChangePhase phase, uint32_t oldHz, uint32_t newHz)
+{
+    (void)oldHz;
+    if (!s_baud)
+        return;
+
+    if (phase == CLOCK_CHANGE_BEFORE)
+    {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        s_pausedCr1 = USART2->CR1 & USART_CR1_TXEIE_TXFNFIE;
+        s_pausedCr3 = USART2->CR3 & USART_CR3_DMAT;
+        USART2->CR1 &= ~USART_CR1_TXEIE_TXFNFIE;
+        USART2->CR3 &= ~USART_CR3_DMAT;
+        __set_PRIMASK(primask);
+
+        for (uint32_t n = _USART_DRAIN_POLLS; n && !(USART2->ISR & USART_ISR_TC); n--)
+            ;
+        return;
+    }
+
+    USART2->CR1 &= ~USART_CR1_UE;                   // BRR only takes writes with UE = 0
+    USART2->BRR = _USART_Brr(newHz, s_baud);
+    USART2->CR1 |= USART_CR1_UE;
+    USART2->CR3 |= s_pausedCr3;
+    USART2->CR1 |= s_pausedCr1;
+}
 
 // ======================================================
 // INITIALIZE USART2
@@ -25,13 +247,311 @@ void _USART_Init_USART2(uint32_t sysclk, uint32_t baud)
     USART2->CR1 &= ~USART_CR1_UE;
 
     // Baud rate
-    USART2->BRR = sysclk / baud;
+    USART2->BRR = _USART_Brr(sysclk, baud);
+    s_baud = baud;
+    Clock_Subscribe(_USART_OnClockChange);
 
     // Enable TX, RX
     USART2->CR1 |= USART_CR1_TE | USART_CR1_RE;
 
     // Enable USART
     USART2->CR1 |= USART_CR1_UE;
+
+#if _USART_BUFFERED
+    _USART_EnableBuffered();
+#endif
+}
+
+// ======================================================
+// BUFFERED MODE CONTROL
+// ======================================================
+void _USART_EnableBuffered(void)
+{
+    NVIC_DisableIRQ(USART2_IRQn);
+
+    Ring_Init(&s_txRing, s_txData, _USART_TX_BUFFSIZE);
+    Ring_Init(&s_rxRing, s_rxData, _USART_RX_BUFFSIZE);
+
+    USART2->ICR = USART_ICR_ORECF;                  // stale overrun
+    USART2->CR1 &= ~USART_CR1_TXEIE_TXFNFIE;        // nothing to send yet
+    USART2->CR1 |= USART_CR1_RXNEIE_RXFNEIE;        // RX always interrupt driven
+
+    s_buffered = 1;
+    NVIC_EnableIRQ(USART2_IRQn);
+}
+
+void _USART_DisableBuffered(void)
+{
+    if (!s_buffered)
+        return;
+
+    while (Ring_Count(&s_txRing));                  // let ISR drain TX
+    while (!(USART2->ISR & USART_ISR_TC));          // last byte out of shifter
+
+    NVIC_DisableIRQ(USART2_IRQn);
+    USART2->CR1 &= ~(USART_CR1_TXEIE_TXFNFIE | USART_CR1_RXNEIE_RXFNEIE);
+    s_buffered = 0;
+}
+
+uint16_t _USART_TxFree(void)
+{
+    return Ring_Free(&s_txRing);
+}
+
+void _USART_GetStats(_USART_Stats *stats)
+{
+    stats->txHighWater = s_txRing.highWater;
+    stats->rxHighWater = s_dmaRxOn ? s_dmaRxHighWater : s_rxRing.highWater;
+    stats->rxDropped = s_rxDropped;
+    stats->rxOverruns = s_rxOverruns;
+}
+
+void _USART_ClearStats(void)
+{
+    s_txRing.highWater = 0;
+    s_rxRing.highWater = 0;
+    s_dmaRxHighWater = 0;
+    s_rxDropped = 0;
+    s_rxOverruns = 0;
+}
+
+// ======================================================
+// DMA TRANSMIT CONTROL
+// ======================================================
+void _USART_EnableTxDMA(void)
+{
+    if (s_buffered)                                 // finish anything in the TX ring
+        while (Ring_Count(&s_txRing));
+    USART2->CR1 &= ~USART_CR1_TXEIE_TXFNFIE;
+
+    RCC->AHBENR |= RCC_AHBENR_DMA1EN;
+
+    DMA1_Channel2->CCR = 0;
+    DMAMUX1_Channel1->CCR = _USART_DMAREQ_USART2_TX;   // DMAMUX ch1 feeds DMA ch2
+    DMA1_Channel2->CPAR = (uint32_t)(uintptr_t)&USART2->TDR;
+    DMA1_Channel2->CCR = DMA_CCR_MINC | DMA_CCR_DIR | DMA_CCR_TCIE;   // 8-bit mem -> periph
+
+    s_dmaFill = 0;
+    s_dmaFillIdx = 0;
+    s_dmaBusy = 0;
+
+    USART2->CR3 |= USART_CR3_DMAT;
+    s_dmaTx = 1;
+    NVIC_EnableIRQ(DMA1_Channel2_3_IRQn);
+}
+
+void _USART_DisableTxDMA(void)
+{
+    if (!s_dmaTx)
+        return;
+
+    _USART_TxFlush(USART2);
+    USART2->CR3 &= ~USART_CR3_DMAT;
+    DMA1_Channel2->CCR &= ~DMA_CCR_EN;
+    s_dmaTx = 0;
+}
+
+uint16_t _USART_TxDMA(const char *data, uint16_t len)
+{
+    if (!s_dmaTx)
+        return 0;
+
+    _USART_DmaWrite((const uint8_t *)data, len);
+    return len;
+}
+
+uint8_t _USART_TxDMAZeroCopy(const void *data, uint16_t len)
+{
+    uint8_t started = 0;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (s_dmaTx && !s_dmaBusy && s_dmaFill == 0 && len)
+    {
+        _USART_DmaStart(data, len);
+        started = 1;
+    }
+
+    __set_PRIMASK(primask);
+    return started;
+}
+
+uint8_t _USART_TxDMABusy(void)
+{
+    return s_dmaBusy || s_dmaFill;
+}
+
+void _USART_SetTxDoneCallback(_USART_TxDoneCallback cb)
+{
+    s_txDoneCb = cb;
+}
+
+void _USART_TxFlush(USART_TypeDef *uart)
+{
+    if (_USART_IsDmaTx(uart))
+        while (s_dmaBusy || s_dmaFill);
+    else if (_USART_IsBuffered(uart))
+        while (Ring_Count(&s_txRing))
+            _USART_TxPollOne();
+
+    while (!(uart->ISR & USART_ISR_TC));
+}
+
+// ======================================================
+// DMA CIRCULAR RECEIVE CONTROL
+// ======================================================
+void _USART_EnableRxDMA(void)
+{
+    USART2->CR1 &= ~USART_CR1_RXNEIE_RXFNEIE;       // DMA takes RXNE from here on
+
+    RCC->AHBENR |= RCC_AHBENR_DMA1EN;
+
+    DMA1_Channel3->CCR = 0;
+    DMAMUX1_Channel2->CCR = _USART_DMAREQ_USART2_RX;   // DMAMUX ch2 feeds DMA ch3
+    DMA1_Channel3->CPAR = (uint32_t)(uintptr_t)&USART2->RDR;
+    DMA1_Channel3->CMAR = (uint32_t)(uintptr_t)s_dmaRx;
+    DMA1_Channel3->CNDTR = _USART_DMA_RXSIZE;
+    DMA1->IFCR = DMA_IFCR_CGIF3;
+    DMA1_Channel3->CCR = DMA_CCR_MINC | DMA_CCR_CIRC | DMA_CCR_HTIE | DMA_CCR_TCIE;   // periph -> mem
+
+    s_dmaRxRead = 0;
+    s_dmaRxSeen = 0;
+    s_dmaRxUnread = 0;
+    s_dmaRxHighWater = 0;
+    s_dmaRxOn = 1;
+
+    DMA1_Channel3->CCR |= DMA_CCR_EN;
+    USART2->ICR = USART_ICR_IDLECF | USART_ICR_ORECF;
+    USART2->CR3 |= USART_CR3_DMAR | USART_CR3_EIE;  // EIE: ORE still interrupts without RXNEIE
+    USART2->CR1 |= USART_CR1_IDLEIE;
+
+    NVIC_EnableIRQ(DMA1_Channel2_3_IRQn);
+    NVIC_EnableIRQ(USART2_IRQn);
+}
+
+void _USART_DisableRxDMA(void)
+{
+    if (!s_dmaRxOn)
+        return;
+
+    USART2->CR1 &= ~USART_CR1_IDLEIE;
+    USART2->CR3 &= ~(USART_CR3_DMAR | USART_CR3_EIE);
+    DMA1_Channel3->CCR &= ~DMA_CCR_EN;
+    s_dmaRxOn = 0;
+
+    if (s_buffered)
+        USART2->CR1 |= USART_CR1_RXNEIE_RXFNEIE;    // back to the RX ring
+}
+
+uint16_t _USART_RxAvailable(void)
+{
+    if (!s_dmaRxOn)
+        return Ring_Count(&s_rxRing);
+
+    return _USART_DmaRxUpdate();
+}
+
+uint16_t _USART_RxPeek(const uint8_t **span)
+{
+    if (!s_dmaRxOn)                                 // interrupt ring: up to its end
+    {
+        uint16_t head = s_rxRing.head;
+        uint16_t tail = s_rxRing.tail;
+
+        *span = &s_rxData[tail];
+        return (uint16_t)((head >= tail) ? (head - tail) : (_USART_RX_BUFFSIZE - tail));
+    }
+
+    uint16_t avail = _USART_DmaRxUpdate();
+    uint16_t rd = s_dmaRxRead;
+
+    *span = &s_dmaRx[rd];
+    return (avail < _USART_DMA_RXSIZE - rd) ? avail : (uint16_t)(_USART_DMA_RXSIZE - rd);
+}
+
+void _USART_RxConsume(uint16_t n)
+{
+    uint16_t avail = _USART_RxAvailable();
+
+    if (n > avail)
+        n = avail;
+    if (!s_dmaRxOn)
+    {
+        s_rxRing.tail = (uint16_t)((s_rxRing.tail + n) & s_rxRing.mask);
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();             // the HT / TC update moves both
+    __disable_irq();
+    if (n > s_dmaRxUnread)                          // an overflow restarted the read
+        n = s_dmaRxUnread;
+    s_dmaRxRead = (uint16_t)((s_dmaRxRead + n) % _USART_DMA_RXSIZE);
+    s_dmaRxUnread = (uint16_t)(s_dmaRxUnread - n);
+    __set_PRIMASK(primask);
+}
+
+void _USART_SetRxIdleCallback(_USART_RxIdleCallback cb)
+{
+    s_rxIdleCb = cb;
+}
+
+// ======================================================
+// DMA1 CHANNEL 2/3 INTERRUPT
+// channel 2 = USART2 TX, channel 3 = USART2 RX
+// ======================================================
+void DMA1_Channel2_3_IRQHandler(void)
+{
+    if (DMA1->ISR & (DMA_ISR_HTIF3 | DMA_ISR_TCIF3))
+    {
+        DMA1->IFCR = DMA_IFCR_CGIF3;
+        _USART_DmaRxEvent();
+    }
+
+    if (DMA1->ISR & DMA_ISR_TCIF2)
+    {
+        DMA1->IFCR = DMA_IFCR_CGIF2;
+        DMA1_Channel2->CCR &= ~DMA_CCR_EN;
+
+        _USART_DmaStartFill();                      // next segment, if any
+        if (!s_dmaBusy && s_txDoneCb)
+            s_txDoneCb();
+    }
+}
+
+// ======================================================
+// USART2 INTERRUPT (services both rings)
+// ======================================================
+void USART2_IRQHandler(void)
+{
+    uint32_t isr = USART2->ISR;
+
+    if ((isr & USART_ISR_IDLE) && (USART2->CR1 & USART_CR1_IDLEIE))
+    {
+        USART2->ICR = USART_ICR_IDLECF;
+        _USART_DmaRxEvent();                        // end of a burst
+    }
+
+    if (isr & USART_ISR_ORE)
+    {
+        USART2->ICR = USART_ICR_ORECF;
+        s_rxOverruns++;
+    }
+
+    if ((isr & USART_ISR_RXNE_RXFNE) && !s_dmaRxOn)
+    {
+        uint8_t c = (uint8_t)USART2->RDR;           // reading clears RXNE
+        if (!Ring_Put(&s_rxRing, c))
+            s_rxDropped++;
+    }
+
+    if ((USART2->CR1 & USART_CR1_TXEIE_TXFNFIE) && (isr & USART_ISR_TXE_TXFNF))
+    {
+        uint8_t c;
+        if (Ring_Get(&s_txRing, &c))
+            USART2->TDR = c;
+        else
+            USART2->CR1 &= ~USART_CR1_TXEIE_TXFNFIE;   // ring empty, stop
+    }
 }
 
 // ======================================================
@@ -39,27 +559,111 @@ void _USART_Init_USART2(uint32_t sysclk, uint32_t baud)
 // ======================================================
 void _USART_TxByte(USART_TypeDef *uart, char c)
 {
+    if (_USART_IsDmaTx(uart))
+    {
+        _USART_DmaWrite((const uint8_t *)&c, 1);
+        return;
+    }
+
+    if (_USART_IsBuffered(uart))
+    {
+        while (!Ring_Put(&s_txRing, (uint8_t)c))    // only waits when ring is full
+            if (!_USART_TxPollOne())
+                _USART_KickTx();
+        _USART_KickTx();
+        return;
+    }
+
     while (!(uart->ISR & USART_ISR_TXE_TXFNF));
     uart->TDR = c;
 }
 
 void _USART_TxString(USART_TypeDef *uart, const char *str)
 {
+    if (_USART_IsDmaTx(uart))
+    {
+        _USART_DmaWrite((const uint8_t *)str, (uint16_t)strlen(str));
+        return;
+    }
+
     while (*str)
         _USART_TxByte(uart, *str++);
 }
 
+uint8_t _USART_TxByteNB(USART_TypeDef *uart, char c)
+{
+    if (_USART_IsDmaTx(uart))
+    {
+        if (s_dmaBusy && s_dmaFill == _USART_DMA_SEGSIZE)
+            return 0;
+        _USART_DmaWrite((const uint8_t *)&c, 1);
+        return 1;
+    }
+
+    if (!_USART_IsBuffered(uart))
+    {
+        if (!(uart->ISR & USART_ISR_TXE_TXFNF))
+            return 0;
+        uart->TDR = c;
+        return 1;
+    }
+
+    if (!Ring_Put(&s_txRing, (uint8_t)c))
+        return 0;
+    _USART_KickTx();
+    return 1;
+}
+
+uint16_t _USART_TxStringNB(USART_TypeDef *uart, const char *str)
+{
+    uint16_t count = 0;
+
+    while (*str && _USART_TxByteNB(uart, *str))
+    {
+        str++;
+        count++;
+    }
+    return count;
+}
+
 // ======================================================
 // RECEIVE FUNCTIONS
 // ======================================================
 char _USART_RxByteB(USART_TypeDef *uart)
 {
+    if (_USART_IsDmaRx(uart))
+    {
+        char c;
+        while (!_USART_RxByte(uart, &c));
+        return c;
+    }
+
+    if (_USART_IsBuffered(uart))
+    {
+        uint8_t c;
+        while (!Ring_Get(&s_rxRing, &c));
+        return (char)c;
+    }
+
     while (!(uart->ISR & USART_ISR_RXNE_RXFNE));
     return uart->RDR;
 }
 
 uint8_t _USART_RxByte(USART_TypeDef *uart, char *c)
 {
+    if (_USART_IsDmaRx(uart))
+    {
+        const uint8_t *span;
+        if (!_USART_RxPeek(&span))
+            return 0;
+        *c = (char)span[0];
+        _USART_RxConsume(1);
+        return 1;
+    }
+
+    if (_USART_IsBuffered(uart))
+        return Ring_Get(&s_rxRing, (uint8_t *)c);
+
     if (uart->ISR & USART_ISR_RXNE_RXFNE)
     {
         *c = uart->RDR;
@@ -79,8 +683,8 @@ void _USART_ClearScreen(USART_TypeDef *uart)
 
 void _USART_SetCursor(USART_TypeDef *uart, uint8_t row, uint8_t col)
 {
-    char buf[16];
-    sprintf(buf, "\033[%d;%dH", row, col);
+    char buf[_FMT_CURSOR_SIZE];
+    Fmt_Cursor(buf, row, col);
     _USART_TxString(uart, buf);
 }
 
@@ -0,0 +1,214 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  WAVE
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   wave.c
+//
+//  DMA1 Channel 1 (DMAMUX channel 0): 16-bit table -> 32-bit CCRx,
+//  memory increment, circular, half and full transfer interrupts.
+//  Shapes are built with integers only (no FPU on the M0+): a quarter
+//  sine table is mirrored into the other three quadrants.
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include "wave.h"
+
+static TIM_TypeDef *s_pTimer = 0;
+static uint16_t *s_pBuf = 0;
+static uint16_t s_count = 0;
+static volatile uint32_t s_cycles = 0;
+static Wave_HalfCallback s_halfCb = 0;
+
+// sin(0..90 deg) in 64 steps, Q15
+static const int16_t s_quarterSine[65] =
+{
+        0,   804,  1608,  2410,  3212,  4011,  4808,  5602,
+     6393,  7179,  7962,  8739,  9512, 10278, 11039, 11793,
+    12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+    18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+    23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790,
+    27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+    30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971,
+    32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+    32767,
+};
+
+// ======================================================
+// Shapes (phase 0..65535 = one period)
+// ======================================================
+static int32_t Wave_QuarterSine(uint32_t x)          // x = 0..16384
+{
+    uint32_t i = x >> 8;
+    int32_t a = s_quarterSine[i];
+
+    if (i >= 64u)
+        return a;
+    return a + (((s_quarterSine[i + 1u] - a) * (int32_t)(x & 0xFFu)) >> 8);
+}
+
+static int32_t Wave_Sine(uint32_t phase)             // -32767..32767
+{
+    uint32_t x = phase & 0x3FFFu;
+
+    switch (phase >> 14)
+    {
+        case 0:  return Wave_QuarterSine(x);
+        case 1:  return Wave_QuarterSine(16384u - x);
+        case 2:  return -Wave_QuarterSine(x);
+        default: return -Wave_QuarterSine(16384u - x);
+    }
+}
+
+static uint32_t Wave_Unit(Wave_Shape shape, uint32_t phase)   // 0..65535
+{
+    switch (shape)
+    {
+        case WAVE_SINE:
+            return (uint32_t)(32768 + Wave_Sine(phase));
+        case WAVE_TRIANGLE:
+            return (phase < 32768u) ? phase * 2u : (65535u - phase) * 2u;
+        default:
+            return phase;
+    }
+}
+
+uint32_t Wave_Top(TIM_TypeDef *pTimer)
+{
+    return pTimer->ARR + 1u;
+}
+
+void Wave_Fill(uint16_t *pBuf, uint16_t count, Wave_Shape shape, uint32_t top)
+{
+    if (!pBuf || !count)
+        return;
+    if (top > 0xFFFFu)                                // table entries are 16-bit
+        top = 0xFFFFu;
+
+    for (uint32_t k = 0; k < count; k++)
+    {
+        uint32_t phase = (k << 16) / count;
+        pBuf[k] = (uint16_t)(((uint64_t)Wave_Unit(shape, phase) * top + 0x8000u) >> 16);
+    }
+}
+
+void Wave_FillUser(uint16_t *pBuf, uint16_t count, const uint16_t *pShape,
+                   uint16_t len, uint32_t top)
+{
+    if (!pBuf || !count || !pShape || !len)
+        return;
+    if (top > 0xFFFFu)
+        top = 0xFFFFu;
+
+    for (uint32_t k = 0; k < count; k++)
+    {
+        uint32_t pos = (uint32_t)(((uint64_t)k * len << 16) / count);   // 16.16 index
+        uint32_t i = pos >> 16;
+        uint32_t f = pos & 0xFFFFu;
+        int32_t a = pShape[i];
+        int32_t b = pShape[(i + 1u < len) ? i + 1u : 0u];
+        uint32_t v = (uint32_t)(a + (int32_t)(((int64_t)(b - a) * f) >> 16));
+        pBuf[k] = (uint16_t)(((uint64_t)v * top + 0x8000u) >> 16);
+    }
+}
+
+// ======================================================
+// Streaming
+// ======================================================
+static uint8_t Wave_Request(TIM_TypeDef *pTimer)
+{
+    if (pTimer == TIM1)  return _WAVE_DMAREQ_TIM1_UP;
+    if (pTimer == TIM2)  return _WAVE_DMAREQ_TIM2_UP;
+    if (pTimer == TIM3)  return _WAVE_DMAREQ_TIM3_UP;
+    if (pTimer == TIM16) return _WAVE_DMAREQ_TIM16_UP;
+    if (pTimer == TIM17) return _WAVE_DMAREQ_TIM17_UP;
+    return 0;                                         // TIM14: no DMA
+}
+
+uint8_t Wave_Start(TIM_TypeDef *pTimer, Timer_Channel channel, uint16_t *pBuf, uint16_t count)
+{
+    uint8_t request = Wave_Request(pTimer);
+    volatile uint32_t *ccr[4] = { &pTimer->CCR1, &pTimer->CCR2, &pTimer->CCR3, &pTimer->CCR4 };
+
+    if (!request || !pBuf || count < 2u ||
+        channel < TIMER_CHANNEL1 || channel > Timer_ChannelCount(pTimer))
+        return 0;
+
+    Wave_Stop();
+    s_pTimer = pTimer;
+    s_pBuf = pBuf;
+    s_count = count;
+    s_cycles = 0;
+
+    RCC->AHBENR |= RCC_AHBENR_DMA1EN;
+
+    DMA1_Channel1->CCR = 0;
+    DMAMUX1_Channel0->CCR = request;                  // DMAMUX ch0 feeds DMA ch1
+    DMA1_Channel1->CPAR = (uint32_t)(uintptr_t)ccr[channel - 1u];
+    DMA1_Channel1->CMAR = (uint32_t)(uintptr_t)pBuf;
+    DMA1_Channel1->CNDTR = count;
+    DMA1->IFCR = DMA_IFCR_CGIF1;
+    DMA1_Channel1->CCR = DMA_CCR_MINC | DMA_CCR_CIRC | DMA_CCR_DIR      // mem -> periph, loop
+                       | DMA_CCR_MSIZE_0 | DMA_CCR_PSIZE_1             // 16-bit -> 32-bit
+                       | DMA_CCR_PL_1                                  // high: a late sample is a glitch
+                       | DMA_CCR_HTIE | DMA_CCR_TCIE | DMA_CCR_TEIE;
+    DMA1_Channel1->CCR |= DMA_CCR_EN;
+
+    NVIC_EnableIRQ(DMA1_Channel1_IRQn);
+    pTimer->DIER |= TIM_DIER_UDE;                     // one request per update event
+    return 1;
+}
+
+void Wave_Stop(void)
+{
+    if (s_pTimer)
+        s_pTimer->DIER &= ~TIM_DIER_UDE;
+    DMA1_Channel1->CCR &= ~DMA_CCR_EN;
+    s_pTimer = 0;
+}
+
+uint8_t Wave_IsRunning(void)
+{
+    return (DMA1_Channel1->CCR & DMA_CCR_EN) ? 1 : 0;
+}
+
+void Wave_SetCallback(Wave_HalfCallback cb)
+{
+    s_halfCb = cb;
+}
+
+uint32_t Wave_GetCycles(void)
+{
+    return s_cycles;
+}
+
+// ======================================================
+// DMA1 CHANNEL 1 INTERRUPT
+// HT: first half played (DMA now reads the second half)
+// TC: second half played (DMA wrapped to the first half)
+// ======================================================
+void DMA1_Channel1_IRQHandler(void)
+{
+    uint32_t isr = DMA1->ISR;
+    uint16_t half = (uint16_t)(s_count / 2u);
+
+    if (isr & DMA_ISR_TEIF1)                          // bad address: give up
+    {
+        DMA1->IFCR = DMA_IFCR_CGIF1;
+        Wave_Stop();
+        return;
+    }
+    if (isr & DMA_ISR_HTIF1)
+    {
+        DMA1->IFCR = DMA_IFCR_CHTIF1;
+        if (s_halfCb)
+            s_halfCb(s_pBuf, half);
+    }
+    if (isr & DMA_ISR_TCIF1)
+    {
+        DMA1->IFCR = DMA_IFCR_CTCIF1;
+        s_cycles++;
+        if (s_halfCb)
+            s_halfCb(s_pBuf + half, (uint16_t)(s_count - half));
+    }
+}
@@ -0,0 +1,239 @@
+/////////////////////////////////////////////////////////////////////////
+//
+//  WHEEL
+//
+//  AUTHOR: Jou Jon Galenzoga
+//  FILE:   wheel.c
+//
+//  s_tick is the next tick to process: every slot before it has run.
+//  Level 0 slot = expires bits 0..5, level 1 = bits 6..11, and so on;
+//  the level comes from the distance to s_tick. A bitmap of the busy
+//  level 0 slots finds the next deadline without walking the lists.
+//
+//  All wheel state is touched with interrupts off (thread side) or
+//  from the TIM2 interrupt, so there is no other locking.
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include "wheel.h"
+#include "timebase.h"
+
+#define WHEEL_BITS    6u
+#define WHEEL_SLOTS   (1u << WHEEL_BITS)
+#define WHEEL_MASK    (WHEEL_SLOTS - 1u)
+#define WHEEL_LEVELS  4u
+#define WHEEL_NONE    0xFFFFu              // slot of a timer taken off for its call
+
+static Wheel_Timer *s_slots[WHEEL_LEVELS * WHEEL_SLOTS];
+static uint32_t s_busy[2];                 // level 0 slots with timers
+static uint32_t s_tick = 0;                // next tick to process
+static uint32_t s_tickUs = 0;              // timebase low word when s_tick is due
+static uint32_t s_target = 0;              // tick the alarm is set for
+
+static void Wheel_OnAlarm(void);
+
+// ======================================================
+// Lists
+// ======================================================
+static void Wheel_Link(Wheel_Timer **ppHead, Wheel_Timer *pTimer)
+{
+    pTimer->next = *ppHead;
+    if (pTimer->next)
+        pTimer->next->pprev = &pTimer->next;
+    pTimer->pprev = ppHead;
+    *ppHead = pTimer;
+}
+
+static void Wheel_Unlink(Wheel_Timer *pTimer)
+{
+    *pTimer->pprev = pTimer->next;
+    if (pTimer->next)
+        pTimer->next->pprev = pTimer->pprev;
+    if (pTimer->slot < WHEEL_SLOTS && !s_slots[pTimer->slot])
+        s_busy[pTimer->slot >> 5] &= ~(1u << (pTimer->slot & 31u));
+    pTimer->pprev = 0;
+}
+
+static void Wheel_Insert(Wheel_Timer *pTimer)
+{
+    uint32_t expires = pTimer->expires;
+    uint32_t delta = expires - s_tick;
+    uint32_t level = 0;
+
+    if ((int32_t)delta < 0)                          // late: due now
+    {
+        expires = s_tick;
+        delta = 0;
+    }
+    while (level < WHEEL_LEVELS - 1u && delta >= (WHEEL_SLOTS << (WHEEL_BITS * level)))
+        level++;
+    if (level == WHEEL_LEVELS - 1u && delta >= (WHEEL_SLOTS << (WHEEL_BITS * level)))
+        expires = s_tick + (WHEEL_MASK << (WHEEL_BITS * level));  // beyond the top: park, cascades again
+
+    uint32_t slot = level * WHEEL_SLOTS + ((expires >> (WHEEL_BITS * level)) & WHEEL_MASK);
+    pTimer->slot = (uint16_t)slot;
+    Wheel_Link(&s_slots[slot], pTimer);
+    if (!level)
+        s_busy[slot >> 5] |= 1u << (slot & 31u);
+}
+
+// ======================================================
+// Time
+// ======================================================
+uint32_t Wheel_Now(void)
+{
+    int32_t d = (int32_t)(Timebase_Micros32() - s_tickUs);
+
+    return (d < 0) ? s_tick - 1u : s_tick + (uint32_t)d / _WHEEL_TICK_US;
+}
+
+// First tick from 'tick' on that needs work: a busy level 0 slot in
+// this round, else the cascade at the start of the next round
+static uint32_t Wheel_NextDue(uint32_t tick)
+{
+    uint32_t idx = tick & WHEEL_MASK;
+
+    if (!idx)
+        return tick;                                 // cascade tick
+    for (uint32_t w = idx >> 5; w < 2u; w++)
+    {
+        uint32_t bits = s_busy[w] & ((w == (idx >> 5)) ? ~0u << (idx & 31u) : ~0u);
+        if (bits)
+        {
+            uint32_t bit = 0;
+            while (!(bits & 1u))
+            {
+                bits >>= 1;
+                bit++;
+            }
+            return (tick & ~WHEEL_MASK) + w * 32u + bit;
+        }
+    }
+    return (tick | WHEEL_MASK) + 1u;
+}
+
+static void Wheel_Cascade(uint32_t level)
+{
+    uint32_t slot = level * WHEEL_SLOTS + ((s_tick >> (WHEEL_BITS * level)) & WHEEL_MASK);
+    Wheel_Timer *pList = s_slots[slot];
+
+    s_slots[slot] = 0;
+    while (pList)
+    {
+        Wheel_Timer *pTimer = pList;
+        pList = pList->next;
+        Wheel_Insert(pTimer);
+    }
+}
+
+static void Wheel_Run(void)
+{
+    uint32_t slot = s_tick & WHEEL_MASK;
+    Wheel_Timer *pDue = s_slots[slot];
+
+    if (!pDue)
+        return;
+    s_slots[slot] = 0;                               // detach: callbacks may re-arm into it
+    s_busy[slot >> 5] &= ~(1u << (slot & 31u));
+    pDue->pprev = &pDue;
+    for (Wheel_Timer *p = pDue; p; p = p->next)
+        p->slot = WHEEL_NONE;
+
+    while (pDue)
+    {
+        Wheel_Timer *pTimer = pDue;
+        Wheel_Unlink(pTimer);                        // a callback may cancel the next one
+        if (pTimer->period)
+        {
+            pTimer->expires += pTimer->period;
+            Wheel_Insert(pTimer);
+        }
+        pTimer->cb(pTimer->pArg);
+    }
+}
+
+static void Wheel_Advance(uint32_t now)
+{
+    while ((int32_t)(now - s_tick) >= 0)
+    {
+        if (!(s_tick & WHEEL_MASK))                  // new round: pour the levels above down
+        {
+            for (uint32_t level = 1; level < WHEEL_LEVELS; level++)
+            {
+                Wheel_Cascade(level);
+                if ((s_tick >> (WHEEL_BITS * level)) & WHEEL_MASK)
+                    break;
+            }
+        }
+        Wheel_Run();
+
+        uint32_t next = Wheel_NextDue(s_tick + 1u);  // skip the empty slots
+        if ((int32_t)(next - now) > 1)
+            next = now + 1u;
+        s_tickUs += (next - s_tick) * _WHEEL_TICK_US;
+        s_tick = next;
+    }
+}
+
+static void Wheel_Schedule(void)
+{
+    s_target = Wheel_NextDue(s_tick);
+    Timebase_SetAlarm(s_tickUs + (s_target - s_tick) * _WHEEL_TICK_US, Wheel_OnAlarm);
+}
+
+static void Wheel_OnAlarm(void)
+{
+    Wheel_Advance(Wheel_Now());
+    Wheel_Schedule();
+}
+
+// ======================================================
+// API
+// ======================================================
+void Wheel_Init(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (uint32_t i = 0; i < WHEEL_LEVELS * WHEEL_SLOTS; i++)
+        s_slots[i] = 0;
+    s_busy[0] = 0;
+    s_busy[1] = 0;
+    s_tick = 0;
+    s_tickUs = Timebase_Micros32();
+    Wheel_Schedule();
+    __set_PRIMASK(primask);
+}
+
+void Wheel_Arm(Wheel_Timer *pTimer, uint32_t delay, uint32_t period,
+               Wheel_Callback cb, void *pArg)
+{
+    if (!pTimer || !cb)
+        return;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (pTimer->pprev)
+        Wheel_Unlink(pTimer);
+    pTimer->cb = cb;
+    pTimer->pArg = pArg;
+    pTimer->period = period;
+    pTimer->expires = Wheel_Now() + (delay ? delay : 1u);
+    Wheel_Insert(pTimer);
+
+    uint32_t due = ((int32_t)(pTimer->expires - s_tick) < 0) ? s_tick : pTimer->expires;
+    if ((int32_t)(due - s_target) < 0)               // sooner than the alarm: bring it forward
+        Wheel_Schedule();
+    __set_PRIMASK(primask);
+}
+
+void Wheel_Cancel(Wheel_Timer *pTimer)
+{
+    if (!pTimer)
+        return;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (pTimer->pprev)
+        Wheel_Unlink(pTimer);
+    __set_PRIMASK(primask);
+}
@@ -11,6 +11,7 @@ Author  : Jou Jon Galenzoga                                            // Author
 #include "stm32g031xx.h"                                               // MCU register definitions (CMSIS)
 #include "gpio.h"                                                      // your GPIO helper library
 #include "usart.h"                                                     // your USART helper library
+#include "fmt.h"                                                       // printf-free number formatting
 
 // ================================================================     // Section divider
 // SELECT WHICH PART TO RUN (ENABLE ONLY ONE)                           // Choose which lab part compiles
@@ -146,21 +147,26 @@ static void RenderOneChar(uint8_t row, uint8_t col, char ch)            // print
 
 static void FormatEngineering(uint64_t value, char *out, size_t outSize)// formats loop count in engineering notation
 {                                                                       // start FormatEngineering
+    static const char suffix[] = " loops of main";                      // text after the number
+    char tmp[48];                                                       // worst case "999.999x10^18 loops of main"
+    uint8_t len = 0;                                                    // characters in tmp
+
     if (value == 0)                                                     // if loop count is zero
-    {                                                                   // start if
-        snprintf(out, outSize, "0 loops of main");                      // print simple message
-        return;                                                         // exit function early
-    }                                                                   // end if
-
-    int exp = 0;                                                        // exponent in multiples of 3
-    double mant = (double)value;                                        // mantissa as floating point
-    while (mant >= 1000.0)                                              // while mantissa too large
+        len = Fmt_U32(tmp, 0u, 0u, ' ');                                // plain "0"
+    else                                                                // otherwise
+        len = Fmt_Engineering(tmp, value, 3u);                          // integer-only "d.dddx10^e" (no double math)
+
+    for (uint8_t i = 0; suffix[i] != '\0'; i++)                         // append suffix
+        tmp[len++] = suffix[i];                                         // copy one character
+    tmp[len] = '\0';                                                    // terminate
+
+    size_t n = 0;                                                       // copy into caller buffer
+    while (n + 1u < outSize && tmp[n] != '\0')                          // leave room for NULL
     {                                                                   // start while
-        mant /= 1000.0;                                                 // scale down by 1000
-        exp += 3;                                                       // increase exponent by 3
+        out[n] = tmp[n];                                                // copy character
+        n++;                                                            // next character
     }                                                                   // end while
-
-    snprintf(out, outSize, "%.3fx10^%d loops of main", mant, exp);      // build engineering string
+    if (outSize) out[n] = '\0';                                         // terminate caller buffer
 }                                                                       // end FormatEngineering
 
 // ================================================================     // Section divider